@@ -186,6 +186,7 @@ void ArduEyeGUIClass::sendDataByte(byte data_out)
 void ArduEyeGUIClass::sendImage(byte rows,byte cols,short *pixels,
 					  short size)
 {
+  PROF_SCOPE(PROF_GUI);
 
   union	//to get the signed bytes to format properly, use a union
   {	
@@ -230,6 +231,7 @@ void ArduEyeGUIClass::sendImage(byte rows,byte cols,short *pixels,
 void ArduEyeGUIClass::sendImage(byte rows,byte cols,char *pixels,
 					  short size)
 {
+  PROF_SCOPE(PROF_GUI);
 
   if(detected)	//if GUI is detected, send bytes
   {
@@ -251,6 +253,64 @@ void ArduEyeGUIClass::sendImage(byte rows,byte cols,char *pixels,
   }
 }
 
+/*********************************************************************/
+//	sendImage (frame version)
+//	sends a CYE_Frame to the GUI for display
+//
+//	ARGUMENTS:
+//	frame: frame to send, short, char or unsigned char pixels, or
+//	packed (sent as a short image, unpacked one row at a time)
+/*********************************************************************/
+
+void ArduEyeGUIClass::sendImage(CYE_Frame *frame)
+{
+  if ((frame->format==CYE_FRAME_PACK10)||(frame->format==CYE_FRAME_PACK12))
+    sendPackedImage(frame);
+  else if (frame->format==CYE_FRAME_SHORT)
+    sendImage(frame->rows,frame->cols,(short *)frame->pixels,
+		CYE_FrameNumPix(frame));
+  else
+    sendImage(frame->rows,frame->cols,(char *)frame->pixels,
+		CYE_FrameNumPix(frame));
+}
+
+/*********************************************************************/
+//	sendPackedImage
+//	sends a packed frame (CYE_FRAME_PACK10/12) as a short image, 
+//	unpacked CYE_PACK_MAXCOLS pixels at a time
+/*********************************************************************/
+
+void ArduEyeGUIClass::sendPackedImage(CYE_Frame *frame)
+{
+  PROF_SCOPE(PROF_GUI);
+
+  short part[CYE_PACK_MAXCOLS];
+  byte r,c,n,col;
+
+  if(detected)
+  {
+  	sendEscChar(START);	//send start packet
+  
+  	sendDataByte(IMAGE);		//write image header
+  	sendDataByte(frame->rows);	//write rows of image
+  	sendDataByte(frame->cols);	//write cols of image
+
+	for(r=0;r<frame->rows;r++)
+	  for(col=0;col<frame->cols;col+=n)
+	  {
+	    n=(frame->cols-col>CYE_PACK_MAXCOLS) ? CYE_PACK_MAXCOLS : frame->cols-col;
+	    CYE_FrameGetRowPart(frame,r,col,n,part);
+	    for(c=0;c<n;c++)
+	    {
+	      sendDataByte(part[c]&0xFF);	//low byte first, as sendImage
+	      sendDataByte(part[c]>>8);
+	    }
+	  }
+  
+  	sendEscChar(STOP);		//send stop packet
+  }
+}
+
 /*********************************************************************/
 //	sendVectors (short version)
 //	sends an image to the GUI for display
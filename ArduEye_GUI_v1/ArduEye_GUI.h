@@ -56,6 +56,12 @@ policies, either expressed or implied, of Centeye, Inc.
   #include "WProgram.h"
   #endif
 
+//per stage timing hooks, compiled out unless ARDUEYE_PROF is 1
+#include <ArduEye_Prof.h>
+
+//frame objects (CYE_Frame)
+#include <CYE_Images_v1.h>
+
 /*********************************************************************/
 //Defines GUI comm handler special characters
 
@@ -118,6 +124,11 @@ class ArduEyeGUIClass
     void sendImage(byte,byte,short*,short);
     void sendImage(byte,byte,char*,short);
 
+    // sends a CYE_Frame, dimensions and pixel format taken from the
+    // frame (unsigned char frames are sent as char images, packed
+    // frames as short images)
+    void sendImage(CYE_Frame*);
+
     // sends a set of vectors to be displayed in the GUI on top of    
     // any image.  First two arguments are the number of rows and 
     // columns in the VECTOR display (not image).  Third argument
@@ -137,6 +148,9 @@ class ArduEyeGUIClass
   // library-accessible "private" interface
   private:
     int detected;	 //whether the GUI is detected
+
+    // sendImage for packed frames, unpacks one row at a time
+    void sendPackedImage(CYE_Frame*);
     
     
 };
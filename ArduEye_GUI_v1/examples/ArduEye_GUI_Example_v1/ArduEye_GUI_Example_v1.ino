@@ -57,9 +57,12 @@
 
 #include <ArduEye_SMH.h>  //Stonyman/Hawksbill vision chip library
 #include <ArduEye_GUI.h>  //ArduEye processing GUI interface
+#include <ArduEye_Prof.h> //per stage timing, see ARDUEYE_PROF
+#include <CYE_Images_v1.h>  //image support functions and frames
 
 #include <SPI.h>  //SPI library is needed to use an external ADC
                   //not supported for MEGA 2560
+#include <EEPROM.h>  //EEPROM library is needed for stored profiles
 
 //==============================================================================
 // GLOBAL VARIABLES
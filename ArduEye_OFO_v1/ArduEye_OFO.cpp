@@ -63,7 +63,8 @@ ArduEyeOFOClass ArduEyeOFO;
 //	LPF
 //	Send in a new optical flow measurement and the filtered optical
 //	flow value will be changed by ((*new_OF)-(*filtered_OF))*alpha
-//	alpha should be between 0-1 
+//	alpha should be between 0-1.  LPF_Q15 does the same without
+//	float math.
 /*********************************************************************/
 
 void ArduEyeOFOClass::LPF(short *filtered_OF,short *new_OF,float alpha)
@@ -71,6 +72,189 @@ void ArduEyeOFOClass::LPF(short *filtered_OF,short *new_OF,float alpha)
 	(*filtered_OF)=(*filtered_OF)+((float)(*new_OF)-(*filtered_OF))				*alpha;
 }
 
+/*********************************************************************/
+//	ofoSat16, ofoQ8, ofoRound
+//	Helpers of the fixed point filters: saturation to a short, a whole
+//	number to Q8.8 (saturated), and Q8.8 rounded to a whole number
+/*********************************************************************/
+
+static inline short ofoSat16(long v)
+{
+  if (v>32767)
+    return 32767;
+  if (v<-32768)
+    return -32768;
+  return (short)v;
+}
+
+static inline short ofoQ8(short x)
+{
+  if (x>127)
+    return 127*256;
+  if (x<-128)
+    return -128*256;
+  return x*256;
+}
+
+static inline short ofoRound(short q8)
+{
+  return ((long)q8+128)>>8;	// int is 16 bits on AVR
+}
+
+/*********************************************************************/
+//	LPF_Q15
+//	Fixed point version of LPF for n values at once: each state moves
+//	by (in-state)*alpha, alpha in Q15 (OFO_Q15(0.35)).  The states are
+//	Q8.8, so unlike LPF the fraction is kept between calls.  Each step
+//	rounds once, so a state stays within about 0.5/alpha Q8.8 steps 
+//	of the float filter (2/256 for alpha 0.35); out is within 1 of 
+//	the float result rounded.  There is no float math, the example
+//	ArduEye_FilterBench_v1 prints the cycles per value against LPF.
+//
+//	EXAMPLE:
+//	short state[2]={0,0},of[2],filtered[2];
+//	LPF_Q15(state,of,filtered,2,OFO_Q15(0.35));
+/*********************************************************************/
+
+void ArduEyeOFOClass::LPF_Q15(short *state, const short *in, short *out, short n, short alpha)
+{
+  short i;
+
+  for (i=0; i<n; ++i)
+  {
+    state[i]+=(((long)ofoQ8(in[i])-state[i])*alpha+16384)>>15;
+    out[i]=ofoRound(state[i]);
+  }
+}
+
+/*********************************************************************/
+//	Biquad
+//	Second order IIR section (direct form I) for n values at once.  
+//	Coefficients are Q14, e.g. from BiquadLowPass, and shared by all
+//	values, each value has its own OFOBiquadState (start with zeros).
+//	The sum is kept in 32 bits and rounded once per step; for a stable
+//	low pass the state stays within 1/256 times the noise gain of
+//	1/(1+a1*z^-1+a2*z^-2) of the float filter, within 3/256 for a 
+//	Butterworth at fc 0.1.  The state saturates when a full scale 
+//	step overshoots, after which it is within 6/256 of a float filter
+//	saturated the same way.
+/*********************************************************************/
+
+void ArduEyeOFOClass::Biquad(const OFOBiquad *c, OFOBiquadState *state, const short *in, short *out, short n)
+{
+  OFOBiquadState *st;
+  short i,x,y;
+  long acc;
+
+  for (i=0; i<n; ++i)
+  {
+    st=&state[i];
+    x=ofoQ8(in[i]);
+
+    acc=(long)c->b0*x+(long)c->b1*st->x1+(long)c->b2*st->x2;
+    acc-=(long)c->a1*st->y1;
+    acc-=(long)c->a2*st->y2;
+    y=ofoSat16((acc+8192)>>14);
+
+    st->x2=st->x1;
+    st->x1=x;
+    st->y2=st->y1;
+    st->y1=y;
+    out[i]=ofoRound(y);
+  }
+}
+
+/*********************************************************************/
+//	BiquadLowPass
+//	Low pass coefficients (RBJ cookbook) for a cutoff of "fc" times 
+//	the frame rate and quality "q", rounded to Q14.  Uses floats, 
+//	call it once at setup.
+/*********************************************************************/
+
+void ArduEyeOFOClass::BiquadLowPass(OFOBiquad *c, float fc, float q)
+{
+  float w0=2*PI*fc;
+  float cw=cos(w0);
+  float alpha=sin(w0)/(2*q);
+  float a0=1+alpha;
+
+  c->b0=OFO_Q14((1-cw)/2/a0);
+  c->b1=OFO_Q14((1-cw)/a0);
+  c->b2=c->b0;
+  c->a1=OFO_Q14(-2*cw/a0);
+  c->a2=OFO_Q14((1-alpha)/a0);
+}
+
+/*********************************************************************/
+//	AlphaBeta
+//	Alpha-beta tracker for n values at once.  Each state predicts its
+//	next value from its change per frame, then corrects value and 
+//	change by alpha and beta (Q15) times the prediction error.  It 
+//	follows a steadily changing flow without the lag of a low pass.
+//	Typical values are alpha 0.5, beta 0.1; start with zero states.
+//	Like LPF_Q15 the states stay within a few Q8.8 steps of the float
+//	tracker.  While x is saturated (a full scale step) the correction
+//	is lost and v collects up to half a step of rounding per frame,
+//	43/256 after 50 frames in ArduEye_FilterBench_v1.
+/*********************************************************************/
+
+void ArduEyeOFOClass::AlphaBeta(OFOAlphaBeta *state, const short *in, short *out, short n, short alpha, short beta)
+{
+  OFOAlphaBeta *st;
+  short i,pred,r;
+
+  for (i=0; i<n; ++i)
+  {
+    st=&state[i];
+    pred=ofoSat16((long)st->x+st->v);
+    r=ofoSat16((long)ofoQ8(in[i])-pred);
+
+    st->x=ofoSat16(pred+(((long)r*alpha+16384)>>15));
+    st->v=ofoSat16(st->v+(((long)r*beta+16384)>>15));
+    out[i]=ofoRound(st->x);
+  }
+}
+
+/*********************************************************************/
+//	Median
+//	Median of the last "len" (odd, up to OFO_MEDIAN_MAX) inputs of
+//	each of n values, to remove single frame outliers of the flow.  
+//	hist holds len values per value (n*len shorts, start with zeros)
+//	and *pos the slot written next, shared by all values.  Exact, 
+//	there is no rounding.
+/*********************************************************************/
+
+void ArduEyeOFOClass::Median(short *hist, unsigned char len, unsigned char *pos, const short *in, short *out, short n)
+{
+  short w[OFO_MEDIAN_MAX],v,*h;
+  unsigned char j,k;
+  short i;
+
+  if (len>OFO_MEDIAN_MAX)
+    len=OFO_MEDIAN_MAX;
+  if (*pos>=len)
+    *pos=0;
+
+  for (i=0; i<n; ++i)
+  {
+    h=hist+i*len;
+    h[*pos]=in[i];
+
+    // insertion sort of the window
+    for (j=0; j<len; ++j)
+    {
+      v=h[j];
+      for (k=j; (k>0)&&(w[k-1]>v); --k)
+        w[k]=w[k-1];
+      w[k]=v;
+    }
+    out[i]=w[len>>1];
+  }
+
+  if (++(*pos)>=len)
+    *pos=0;
+}
+
 /*********************************************************************/
 //	Accumulate
 //	The current optical flow value is added to the accumulation sum
@@ -105,6 +289,8 @@ short ArduEyeOFOClass::Accumulate(short *new_OF,short *acc_OF, short threshold)
 
 void ArduEyeOFOClass::IIA_1D(short *curr_img, short *last_img, char numpix, short 					scale, short *out) 
 {
+  PROF_SCOPE(PROF_FLOW);
+
   short *pleft,*pright,*pone,*ptwo;
   long top,bottom;
   char i;
@@ -154,6 +340,8 @@ void ArduEyeOFOClass::IIA_1D(short *curr_img, short *last_img, char numpix, shor
 
 void ArduEyeOFOClass::IIA_1D(char *curr_img, char *last_img, char 				numpix, short scale, short *out) 
 {
+  PROF_SCOPE(PROF_FLOW);
+
   char *pleft,*pright,*pone,*ptwo;
   long top,bottom;
   int deltat,deltax;
@@ -208,6 +396,8 @@ void ArduEyeOFOClass::IIA_1D(char *curr_img, char *last_img, char 				numpix, sh
 
 void ArduEyeOFOClass::IIA_Plus_2D(char *curr_img, char *last_img, short 						rows,short cols, short scale, short 						*ofx, short *ofy)
 {
+  PROF_SCOPE(PROF_FLOW);
+
   int32_t  A=0, BD=0, C=0, E=0, F=0;
   int16_t  F2F1, F4F3, FCF0;
         
@@ -281,6 +471,8 @@ void ArduEyeOFOClass::IIA_Plus_2D(char *curr_img, char *last_img, short 						ro
 
 void ArduEyeOFOClass::IIA_Plus_2D(short *curr_img, short *last_img, 						short rows,short cols, short scale, 						short *ofx, short *ofy)
 {
+  PROF_SCOPE(PROF_FLOW);
+
   int32_t  A=0, BD=0, C=0, E=0, F=0;
   int16_t  F2F1, F4F3, FCF0;
         
@@ -353,6 +545,8 @@ void ArduEyeOFOClass::IIA_Plus_2D(short *curr_img, short *last_img, 						short
 
 void ArduEyeOFOClass::IIA_Square_2D(char *curr_img, char *last_img, 						short rows,short cols, short scale, 						short *ofx, short *ofy)
 {
+  PROF_SCOPE(PROF_FLOW);
+
   int32_t  A=0, BD=0, C=0, E=0, F=0;
   int16_t  F2F1, F4F3, FCF0;
           
@@ -430,6 +624,8 @@ void ArduEyeOFOClass::IIA_Square_2D(char *curr_img, char *last_img, 						short
 
 void ArduEyeOFOClass::IIA_Square_2D(short *curr_img,short *last_img, 						short rows,short cols, short scale, 						short *ofx, short *ofy)
 {
+  PROF_SCOPE(PROF_FLOW);
+
   int32_t  A=0, BD=0, C=0, E=0, F=0;
   int16_t  F2F1, F4F3, FCF0;
           
@@ -505,6 +701,8 @@ void ArduEyeOFOClass::IIA_Square_2D(short *curr_img,short *last_img, 						short
 
 void ArduEyeOFOClass::LK_Plus_2D(char *curr_img, char *last_img, short 					   rows,short cols, short scale, short 					   *ofx, short *ofy)
 {
+  PROF_SCOPE(PROF_FLOW);
+
   int32_t  A11=0, A12=0, A22=0, b1=0, b2=0;
   int16_t  F2F1, F4F3, FCF0;
         
@@ -570,6 +768,8 @@ void ArduEyeOFOClass::LK_Plus_2D(char *curr_img, char *last_img, short 					   r
 
 void ArduEyeOFOClass::LK_Plus_2D(short *curr_img, short *last_img, 					   short rows,short cols, short scale, 					   short *ofx, short *ofy)
 {
+  PROF_SCOPE(PROF_FLOW);
+
   int32_t  A11=0, A12=0, A22=0, b1=0, b2=0;
   int16_t  F2F1, F4F3, FCF0;
         
@@ -637,6 +837,8 @@ void ArduEyeOFOClass::LK_Plus_2D(short *curr_img, short *last_img, 					   short
 
 void ArduEyeOFOClass::LK_Square_2D(char *curr_img, char *last_img, 						short rows,short cols, short scale, 						short *ofx, short *ofy)
 {
+  PROF_SCOPE(PROF_FLOW);
+
   int32_t  A11=0, A12=0, A22=0, b1=0, b2=0;
   int16_t  F2F1, F4F3, FCF0;
          
@@ -715,6 +917,8 @@ void ArduEyeOFOClass::LK_Square_2D(char *curr_img, char *last_img, 						short r
 
 void ArduEyeOFOClass::LK_Square_2D(short *curr_img, short *last_img, 						short rows, short cols, short 						scale, short *ofx, short *ofy)
 {
+  PROF_SCOPE(PROF_FLOW);
+
   int32_t  A11=0, A12=0, A22=0, b1=0, b2=0;
   int16_t  F2F1, F4F3, FCF0;
         
@@ -771,3 +975,314 @@ void ArduEyeOFOClass::LK_Square_2D(short *curr_img, short *last_img, 						short
   (*ofx) = (short)XS;
   (*ofy) = (short)YS;
 }
+
+/*********************************************************************/
+//	framesUsable
+//	Returns 1 if curr and last have the same dimensions and a signed
+//	pixel format the kernels support.  Otherwise zeroes the outputs
+//	(ofy may be NULL) and returns 0.
+/*********************************************************************/
+
+char ArduEyeOFOClass::framesUsable(CYE_Frame *curr, CYE_Frame *last, short *ofx, short *ofy)
+{
+  if (CYE_FrameMatch(curr,last) && (curr->format!=CYE_FRAME_UCHAR))
+    return 1;
+
+  *ofx=0;
+  if (ofy)
+    *ofy=0;
+  return 0;
+}
+
+/*********************************************************************/
+//	IIA_1D (frame version)
+//	IIA_1D over all pixels of two frames, taken in raster order as one
+//	line whatever the frame shape or format.  Packed frames, and 
+//	frames with more pixels than the char count of the array versions,
+//	are read in pieces by partsIIA_1D.
+/*********************************************************************/
+
+void ArduEyeOFOClass::IIA_1D(CYE_Frame *curr, CYE_Frame *last, short scale, short *out)
+{
+  if (!framesUsable(curr,last,out,0))
+    return;
+
+  if ((curr->format==CYE_FRAME_PACK10)||(curr->format==CYE_FRAME_PACK12)||(CYE_FrameNumPix(curr)>127))
+    partsIIA_1D(curr,last,scale,out);
+  else if (curr->format==CYE_FRAME_CHAR)
+    IIA_1D((char *)curr->pixels,(char *)last->pixels,CYE_FrameNumPix(curr),scale,out);
+  else
+    IIA_1D((short *)curr->pixels,(short *)last->pixels,CYE_FrameNumPix(curr),scale,out);
+}
+
+/*********************************************************************/
+//	IIA_Plus_2D (frame version)
+/*********************************************************************/
+
+void ArduEyeOFOClass::IIA_Plus_2D(CYE_Frame *curr, CYE_Frame *last, short scale, short *ofx, short *ofy)
+{
+  if (!framesUsable(curr,last,ofx,ofy))
+    return;
+
+  if ((curr->format==CYE_FRAME_PACK10)||(curr->format==CYE_FRAME_PACK12))
+  {
+    int32_t sums[5];
+    if (packedSums(curr,last,0,sums))
+      solveIIA(sums,scale,ofx,ofy);
+    else
+      *ofx=*ofy=0;
+  }
+  else if (curr->format==CYE_FRAME_CHAR)
+    IIA_Plus_2D((char *)curr->pixels,(char *)last->pixels,curr->rows,curr->cols,scale,ofx,ofy);
+  else
+    IIA_Plus_2D((short *)curr->pixels,(short *)last->pixels,curr->rows,curr->cols,scale,ofx,ofy);
+}
+
+/*********************************************************************/
+//	IIA_Square_2D (frame version)
+/*********************************************************************/
+
+void ArduEyeOFOClass::IIA_Square_2D(CYE_Frame *curr, CYE_Frame *last, short scale, short *ofx, short *ofy)
+{
+  if (!framesUsable(curr,last,ofx,ofy))
+    return;
+
+  if ((curr->format==CYE_FRAME_PACK10)||(curr->format==CYE_FRAME_PACK12))
+  {
+    int32_t sums[5];
+    if (packedSums(curr,last,1,sums))
+      solveIIA(sums,scale,ofx,ofy);
+    else
+      *ofx=*ofy=0;
+  }
+  else if (curr->format==CYE_FRAME_CHAR)
+    IIA_Square_2D((char *)curr->pixels,(char *)last->pixels,curr->rows,curr->cols,scale,ofx,ofy);
+  else
+    IIA_Square_2D((short *)curr->pixels,(short *)last->pixels,curr->rows,curr->cols,scale,ofx,ofy);
+}
+
+/*********************************************************************/
+//	LK_Plus_2D (frame version)
+/*********************************************************************/
+
+void ArduEyeOFOClass::LK_Plus_2D(CYE_Frame *curr, CYE_Frame *last, short scale, short *ofx, short *ofy)
+{
+  if (!framesUsable(curr,last,ofx,ofy))
+    return;
+
+  if ((curr->format==CYE_FRAME_PACK10)||(curr->format==CYE_FRAME_PACK12))
+  {
+    int32_t sums[5];
+    if (packedSums(curr,last,0,sums))
+      solveLK(sums,scale,ofx,ofy);
+    else
+      *ofx=*ofy=0;
+  }
+  else if (curr->format==CYE_FRAME_CHAR)
+    LK_Plus_2D((char *)curr->pixels,(char *)last->pixels,curr->rows,curr->cols,scale,ofx,ofy);
+  else
+    LK_Plus_2D((short *)curr->pixels,(short *)last->pixels,curr->rows,curr->cols,scale,ofx,ofy);
+}
+
+/*********************************************************************/
+//	LK_Square_2D (frame version)
+/*********************************************************************/
+
+void ArduEyeOFOClass::LK_Square_2D(CYE_Frame *curr, CYE_Frame *last, short scale, short *ofx, short *ofy)
+{
+  if (!framesUsable(curr,last,ofx,ofy))
+    return;
+
+  if ((curr->format==CYE_FRAME_PACK10)||(curr->format==CYE_FRAME_PACK12))
+  {
+    int32_t sums[5];
+    if (packedSums(curr,last,1,sums))
+      solveLK(sums,scale,ofx,ofy);
+    else
+      *ofx=*ofy=0;
+  }
+  else if (curr->format==CYE_FRAME_CHAR)
+    LK_Square_2D((char *)curr->pixels,(char *)last->pixels,curr->rows,curr->cols,scale,ofx,ofy);
+  else
+    LK_Square_2D((short *)curr->pixels,(short *)last->pixels,curr->rows,curr->cols,scale,ofx,ofy);
+}
+
+/*********************************************************************/
+//	partsIIA_1D
+//	IIA_1D over all pixels of two frames of any format, read 
+//	CYE_PACK_MAXCOLS pixels at a time.  The stencil runs on across 
+//	row ends as in the array versions, keeping the last two pixels of
+//	curr and the last of last.  No texture gives zero flow.
+/*********************************************************************/
+
+void ArduEyeOFOClass::partsIIA_1D(CYE_Frame *curr, CYE_Frame *last, short scale, short *out)
+{
+  PROF_SCOPE(PROF_FLOW);
+
+  short c[CYE_PACK_MAXCOLS],l[CYE_PACK_MAXCOLS];
+  short c1=0,c2=0,l1=0;		// curr at j-1 and j-2, last at j-1
+  long top=0,bottom=0,deltat,deltax;
+  unsigned short j=0;		// pixels of the whole frame
+  unsigned char r,col,k,n;
+
+  for (r=0; r<curr->rows; ++r)
+    for (col=0; col<curr->cols; col+=n)
+    {
+      n=(curr->cols-col>CYE_PACK_MAXCOLS) ? CYE_PACK_MAXCOLS : curr->cols-col;
+      CYE_FrameGetRowPart(curr,r,col,n,c);
+      CYE_FrameGetRowPart(last,r,col,n,l);
+      for (k=0; k<n; ++k, ++j)
+      {
+        if (j>=2)	// center pixel j-1
+        {
+          deltat = l1 - c1;
+          deltax = c[k] - c2;
+          top += deltat * deltax;
+          bottom += deltax * deltax;
+        }
+        c2=c1;
+        c1=c[k];
+        l1=l[k];
+      }
+    }
+
+  *out = bottom ? 2*top*scale/bottom : 0;
+}
+
+/*********************************************************************/
+//	packedSums
+//	Gradient sums of the 2D algorithms over two packed frames: 
+//	sums[0..4] = A, BD, C, E, F of IIA (A11, A12, b1, A22, b2 of LK).
+//	Only the rows the stencil needs are unpacked, 3 of curr and 1 of
+//	last for the plus stencil, 2 and 1 for the square stencil, and the
+//	row buffers are rotated by pointer.  A frame wider than 
+//	CYE_PACK_MAXCOLS is read in strips of that width overlapping by
+//	CYE_PACK_GROUP columns, each summing the stencils centered on its
+//	own CYE_PACK_MAXCOLS-CYE_PACK_GROUP columns.  Returns 0 if the 
+//	frames are too small for the stencil.
+/*********************************************************************/
+
+char ArduEyeOFOClass::packedSums(CYE_Frame *curr, CYE_Frame *last, char square, int32_t *sums)
+{
+  PROF_SCOPE(PROF_FLOW);
+
+  short buf[4][CYE_PACK_MAXCOLS];
+  short *up,*mid,*down,*lz,*t;
+  int16_t F2F1, F4F3, FCF0;
+  unsigned char r,c,n,col,end;
+  unsigned char rows=curr->rows,cols=curr->cols;
+  unsigned char first=square ? 0 : 1;	// first strip column with a stencil
+
+  for (r=0; r<5; ++r)
+    sums[r]=0;
+  if ((rows<2)||(cols<2))
+    return 0;
+  if (!square && (rows<3 || cols<3))
+    return 0;
+
+  // strips of n columns from col on, stencils centered on strip
+  // columns first...end-1, up to the strip reaching the right edge
+  for (col=0; ; col+=CYE_PACK_MAXCOLS-CYE_PACK_GROUP)
+  {
+    if (col+CYE_PACK_MAXCOLS>=cols)	// last strip, to the right edge
+    {
+      n=cols-col;
+      end=n-1;
+    }
+    else
+    {
+      n=CYE_PACK_MAXCOLS;
+      end=first+CYE_PACK_MAXCOLS-CYE_PACK_GROUP;
+    }
+    up=buf[0]; mid=buf[1]; down=buf[2]; lz=buf[3];
+
+    if (square)
+    {
+      // top left, top right, bottom left, bottom right
+      CYE_FrameGetRowPart(curr,0,col,n,up);
+      for (r=0; r<rows-1; ++r)
+      {
+        CYE_FrameGetRowPart(curr,r+1,col,n,down);
+        CYE_FrameGetRowPart(last,r,col,n,lz);
+        for (c=0; c<end; ++c)
+        {
+          F2F1 = (up[c]-up[c+1]) + (down[c]-down[c+1]);
+          F4F3 = (up[c]-down[c]) + (up[c+1]-down[c+1]);
+          FCF0 = lz[c]-up[c];
+          sums[0] += (int32_t)F2F1*F2F1;
+          sums[1] += (int32_t)F4F3*F2F1;
+          sums[2] += (int32_t)FCF0*F2F1;
+          sums[3] += (int32_t)F4F3*F4F3;
+          sums[4] += (int32_t)FCF0*F4F3;
+        }
+        t=up; up=down; down=t;
+      }
+    }
+    else
+    {
+      // left minus right, up minus down around each inner pixel
+      CYE_FrameGetRowPart(curr,0,col,n,up);
+      CYE_FrameGetRowPart(curr,1,col,n,mid);
+      for (r=1; r<rows-1; ++r)
+      {
+        CYE_FrameGetRowPart(curr,r+1,col,n,down);
+        CYE_FrameGetRowPart(last,r,col,n,lz);
+        for (c=1; c<end; ++c)
+        {
+          F2F1 = mid[c-1]-mid[c+1];
+          F4F3 = up[c]-down[c];
+          FCF0 = lz[c]-mid[c];
+          sums[0] += (int32_t)F2F1*F2F1;
+          sums[1] += (int32_t)F4F3*F2F1;
+          sums[2] += (int32_t)FCF0*F2F1;
+          sums[3] += (int32_t)F4F3*F4F3;
+          sums[4] += (int32_t)FCF0*F4F3;
+        }
+        t=up; up=mid; mid=down; down=t;
+      }
+    }
+
+    if (n==cols-col)
+      break;
+  }
+  return 1;
+}
+
+/*********************************************************************/
+//	solveIIA, solveLK
+//	Final step of the IIA and LK algorithms from the sums of 
+//	packedSums, as in the short versions.  A singular system (no 
+//	texture) gives zero flow.
+/*********************************************************************/
+
+void ArduEyeOFOClass::solveIIA(int32_t *sums, short scale, short *ofx, short *ofy)
+{
+  int32_t A=sums[0], BD=sums[1], C=sums[2], E=sums[3], F=sums[4];
+
+  int64_t top1=( (int64_t)(C)*E - (int64_t)(F)*BD );
+  int64_t top2=( (int64_t)(A)*F - (int64_t)(C)*BD );
+  int64_t bottom=( (int64_t)(A)*E - (int64_t)(BD)*BD );
+
+  if (!bottom)
+  {
+    *ofx=*ofy=0;
+    return;
+  }
+  *ofx = (short)((2*scale*top1)/bottom);
+  *ofy = (short)((2*scale*top2)/bottom);
+}
+
+void ArduEyeOFOClass::solveLK(int32_t *sums, short scale, short *ofx, short *ofy)
+{
+  int32_t A11=sums[0], A12=sums[1], b1=sums[2], A22=sums[3], b2=sums[4];
+
+  int64_t detA = ( (int64_t)(A11)*A22 - (int64_t)(A12)*A12 );
+
+  if (!detA)
+  {
+    *ofx=*ofy=0;
+    return;
+  }
+  *ofx = (short)(( (int64_t)(b1)*A22 - (int64_t)(b2)*A12 ) * scale / detA);
+  *ofy = (short)(( (int64_t)(b2)*A11 - (int64_t)(b1)*A12 ) * scale / detA);
+}
@@ -57,6 +57,49 @@ July 10, 2012: initial release
   #include "WProgram.h"
   #endif
 
+//per stage timing hooks, compiled out unless ARDUEYE_PROF is 1
+#include <ArduEye_Prof.h>
+
+//frame objects (CYE_Frame)
+#include <CYE_Images_v1.h>
+
+/*********************************************************************/
+// Fixed point filters, see LPF_Q15
+//
+// Filtered values are Q8.8 shorts (256 is 1.0, range -128 to just
+// under 128), inputs are whole numbers such as the flow of IIA/LK and
+// saturate to that range.  Coefficients are Q15 (OFO_Q15(0.35)), the
+// biquad's are Q14 since its feedback coefficients reach 2.  Each 
+// filter runs over a batch of n values, e.g. a grid of flow vectors,
+// with one state per value.  The OFO_Q macros are for constants, 
+// they are evaluated by the compiler.
+
+#define OFO_Q8(x) ((short)((x)*256.0+((x)<0 ? -0.5 : 0.5)))
+#define OFO_Q14(x) ((short)((x)*16384.0+((x)<0 ? -0.5 : 0.5)))
+#define OFO_Q15(x) ((short)((x)*32768.0+0.5>=32767.0 ? 32767 : (x)*32768.0+((x)<0 ? -0.5 : 0.5)))
+
+//longest window of the median filter
+#define OFO_MEDIAN_MAX 7
+
+//second order section in Q14, y=b0*x+b1*x1+b2*x2-a1*y1-a2*y2
+struct OFOBiquad
+{
+  short b0,b1,b2,a1,a2;
+};
+
+//state of a biquad for one value: last two inputs and outputs, Q8.8
+struct OFOBiquadState
+{
+  short x1,x2,y1,y2;
+};
+
+//state of an alpha-beta tracker for one value: estimate and its 
+//change per frame, Q8.8
+struct OFOAlphaBeta
+{
+  short x,v;
+};
+
 
 /*********************************************************************/
 /*********************************************************************/
@@ -74,6 +117,18 @@ class ArduEyeOFOClass
 	// Low Pass Filters an OF value with coefficient alpha
       void LPF(short *filtered_OF,short *new_OF,float alpha);
 
+	// Fixed point filters of n values at once (see above): first
+	// order low pass, biquad, alpha-beta tracker and median of the
+	// last len values.  out gets the filtered values rounded.
+	void LPF_Q15(short *state, const short *in, short *out, short n, short alpha);
+	void Biquad(const OFOBiquad *c, OFOBiquadState *state, const short *in, short *out, short n);
+	void AlphaBeta(OFOAlphaBeta *state, const short *in, short *out, short n, short alpha, short beta);
+	void Median(short *hist, unsigned char len, unsigned char *pos, const short *in, short *out, short n);
+
+	// Biquad low pass coefficients for a cutoff of fc times the 
+	// frame rate (0-0.5) and quality q (0.7071 is Butterworth)
+	static void BiquadLowPass(OFOBiquad *c, float fc, float q);
+
 	// Optical Accumulation using thresholding
       short Accumulate(short *new_OF,short *acc_OF,short threshold);
 
@@ -103,6 +158,36 @@ class ArduEyeOFOClass
 	void LK_Square_2D(char *curr_img, char *last_img, short rows, 				short cols, short scale,short *ofx,short *ofy);
 	void LK_Square_2D(short *curr_img, short *last_img, short rows, 				short cols, short scale,short *ofx,short *ofy);
 
+	// The same algorithms on CYE_Frame objects.  Dimensions and 
+	// pixel format come from the frames; if the two frames do not
+	// match, or are unsigned char, the output is zero.  Packed
+	// frames (CYE_FRAME_PACK10/12) of any width are unpacked 
+	// CYE_PACK_MAXCOLS pixels at a time.  IIA_1D takes the pixels 
+	// of every format in raster order as one line.
+	void IIA_1D(CYE_Frame *curr, CYE_Frame *last, short scale, short *out);
+	void IIA_Plus_2D(CYE_Frame *curr, CYE_Frame *last, short scale, short *ofx, short *ofy);
+	void IIA_Square_2D(CYE_Frame *curr, CYE_Frame *last, short scale, short *ofx, short *ofy);
+	void LK_Plus_2D(CYE_Frame *curr, CYE_Frame *last, short scale, short *ofx, short *ofy);
+	void LK_Square_2D(CYE_Frame *curr, CYE_Frame *last, short scale, short *ofx, short *ofy);
+
+  // library-accessible "private" interface
+  private:
+
+	// checks that two frames can be used together, zeroes the
+	// outputs if not
+	char framesUsable(CYE_Frame *curr, CYE_Frame *last, short *ofx, short *ofy);
+
+	// IIA_1D over frames read in pieces (packed or long frames)
+	void partsIIA_1D(CYE_Frame *curr, CYE_Frame *last, short scale, short *out);
+
+	// gradient sums of the 2D algorithms over packed frames, read
+	// with a rolling window of unpacked rows
+	char packedSums(CYE_Frame *curr, CYE_Frame *last, char square, int32_t *sums);
+
+	// final step of IIA and LK from the gradient sums
+	void solveIIA(int32_t *sums, short scale, short *ofx, short *ofy);
+	void solveLK(int32_t *sums, short scale, short *ofx, short *ofy);
+
 };
 
 //class instance
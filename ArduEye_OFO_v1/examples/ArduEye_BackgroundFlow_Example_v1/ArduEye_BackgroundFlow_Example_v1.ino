@@ -0,0 +1,152 @@
+/* ARDUEYE_BACKGROUNDFLOW_EXAMPLE_V1
+ 
+ This sketch computes optical flow while the next image is 
+ being acquired.  The ArduEyeSMH library reads the vision chip 
+ from the ADC interrupt (startBackground) into three frames, 
+ and each time a new frame is complete loop() computes the 
+ optical flow between it and the previous frame.  The sketch 
+ hands the ADC interrupt to the library with one line, see ISR 
+ below.
+ 
+ Flow is printed as "x y" over the serial port.  The onboard
+ ADC is used, external ADCs are not supported in background.
+ 
+ This example supports a Stonyman chip with cell phone optics
+*/
+
+/*
+===============================================================================
+ Copyright (c) 2012 Centeye, Inc. 
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without 
+ modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, 
+ this list of conditions and the following disclaimer.
+ 
+ Redistributions in binary form must reproduce the above copyright notice, 
+ this list of conditions and the following disclaimer in the documentation 
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+ EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+ OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+ The views and conclusions contained in the software and documentation are 
+ those of the authors and should not be interpreted as representing official 
+ policies, either expressed or implied, of Centeye, Inc.
+ ===============================================================================
+ */
+
+//=============================================================================
+// INCLUDE FILES. The top files are part of the ArduEye library and should
+// be included in the Arduino "libraries" folder.
+
+#include <ArduEye_SMH.h>  //Stonyman/Hawksbill vision chip library
+#include <ArduEye_Prof.h> //per stage timing, see ARDUEYE_PROF
+#include <ArduEye_OFO.h>  //Optical Flow support
+#include <CYE_Images_v1.h>  //Some image support functions
+
+#include <SPI.h>  //needed by the ArduEye_SMH library
+#include <EEPROM.h>  //needed by the ArduEye_SMH library
+
+//==============================================================================
+// GLOBAL VARIABLES
+
+//three frames for the background readout plus a copy of the last
+//frame: 4 arrays of 10x10 fit an uno, 16x16 a mega 2560
+#if defined(__AVR_ATmega2560__)  
+  #define MAX_ROWS 16
+  #define MAX_COLS 16
+  #define SKIP_PIXELS 4
+  #define START_ROW 24
+  #define START_COL 24  
+#elif defined (__AVR_ATmega8__)||(__AVR_ATmega168__)||(__AVR_ATmega168P__)||(__AVR_ATmega328P__)
+  #define MAX_ROWS 10    
+  #define MAX_COLS 10
+  #define SKIP_PIXELS 8
+  #define START_ROW 16
+  #define START_COL 16
+#else 
+  #  error "Code only supports ATmega 2560 and ATmega 8/168/328"
+#endif
+#define MAX_PIXELS (MAX_ROWS*MAX_COLS)
+
+short img_buf[SMH_BG_SLOTS][MAX_PIXELS];  //filled by the background readout
+CYE_Frame frames[SMH_BG_SLOTS];           //frames around img_buf
+short last_buf[MAX_PIXELS];               //copy of the previous frame
+CYE_Frame last;                           //frame around last_buf
+char haveLast=0;                          //last holds a frame
+
+short chipSelect=0;            //which vision chip to read from
+
+//optical flow X and Y
+short OFX=0,OFY=0;
+
+//the ADC interrupt steps the background readout (the library leaves
+//ADC_vect to the sketch unless built with SMH_USE_BG_ISR)
+#if defined(SMH_BG_ISR) && !defined(SMH_USE_BG_ISR)
+ISR(ADC_vect) { ArduEyeSMH.backgroundStep(); }
+#endif
+
+//=======================================================================
+// ARDUINO SETUP AND LOOP FUNCTIONS
+
+void setup() 
+{
+  unsigned char i;
+
+  // initialize serial port
+  Serial.begin(115200);
+  
+  //initialize ArduEye Stonyman
+  ArduEyeSMH.begin();
+  
+  //set the initial binning on the vision chip
+  ArduEyeSMH.setBinning(SKIP_PIXELS,SKIP_PIXELS);
+
+  //set up the frames and start reading in the background
+  for (i=0; i<SMH_BG_SLOTS; ++i)
+    CYE_FrameInit(&frames[i],img_buf[i],MAX_ROWS,MAX_COLS,CYE_FRAME_SHORT);
+  CYE_FrameInit(&last,last_buf,MAX_ROWS,MAX_COLS,CYE_FRAME_SHORT);
+
+  if (!ArduEyeSMH.startBackground(frames,START_ROW,SKIP_PIXELS,START_COL,SKIP_PIXELS,chipSelect))
+    Serial.println("background acquisition not supported");
+}
+
+void loop() 
+{
+  CYE_Frame *current;
+
+  //newest complete frame, the chip is already reading the next one
+  current=ArduEyeSMH.getBackgroundFrame();
+  if (!current)
+    return;
+
+  //flow between the previous and this frame
+  if (haveLast)
+  {
+    ArduEyeOFO.IIA_Plus_2D(current,&last,200,&OFX,&OFY);
+
+    Serial.print(OFX);
+    Serial.print(" ");
+    Serial.println(OFY);
+  }
+
+  //current goes back to the readout at the next getBackgroundFrame,
+  //so keep a copy for the next flow calculation
+  CYE_ImgShortCopy((short *)current->pixels,last_buf,MAX_PIXELS);
+  last.timestamp=current->timestamp;
+  last.seq=current->seq;
+  haveLast=1;
+
+  PROF_FRAME_END();
+}
@@ -0,0 +1,344 @@
+/* ARDUEYE_FILTERBENCH_V1
+
+ This sketch measures the fixed point flow filters of the ArduEye_OFO
+ library (LPF_Q15, Biquad, AlphaBeta and Median) against the float
+ LPF and against float versions of the same filters.  No vision chip
+ is needed: the filters run on a synthetic grid of flow values with
+ steps, ramps and noise, and full scale steps between +127 and -128
+ that drive the states into saturation.  For each filter it prints 
+ the time in microseconds and CPU cycles per value, and the largest
+ difference from the float version in 1/256 (one Q8.8 step).
+
+ Type "b" into the serial terminal to run the benchmark again.
+*/
+
+/*
+===============================================================================
+ Copyright (c) 2012 Centeye, Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ Redistributions of source code must retain the above copyright notice,
+ this list of conditions and the following disclaimer.
+
+ Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are
+ those of the authors and should not be interpreted as representing official
+ policies, either expressed or implied, of Centeye, Inc.
+ ===============================================================================
+ */
+
+//=============================================================================
+// INCLUDE FILES. The top files are part of the ArduEye library and should
+// be included in the Arduino "libraries" folder.
+
+#include <ArduEye_Prof.h> //per stage timing, see ARDUEYE_PROF
+#include <ArduEye_OFO.h>  //Optical Flow support
+#include <CYE_Images_v1.h>  //Some image support functions
+
+//==============================================================================
+// GLOBAL VARIABLES
+
+//a 4x4 grid of flow vectors, X and Y: 32 values filtered per frame
+#define BENCH_VALUES 32
+#define BENCH_FRAMES 200       //frames compared with the float filters
+#define BENCH_REPS 50          //calls timed per filter
+#define BENCH_SAT 4            //last values step between the extremes
+#define BENCH_SAT_FRAMES 50    //frames between those steps
+
+//filter settings
+#define LPF_ALPHA 0.35
+#define BIQUAD_FC 0.1
+#define BIQUAD_Q 0.7071
+#define AB_ALPHA 0.5
+#define AB_BETA 0.1
+#define MEDIAN_LEN 5
+
+short flow[BENCH_VALUES];      //flow of the current frame
+short out[BENCH_VALUES];       //filtered flow
+
+short lpfState[BENCH_VALUES];
+OFOBiquad biquad;
+OFOBiquadState biquadState[BENCH_VALUES];
+OFOAlphaBeta abState[BENCH_VALUES];
+short medianHist[BENCH_VALUES*MEDIAN_LEN];
+unsigned char medianPos;
+
+//float versions
+float lpfRef[BENCH_VALUES];
+float biquadRef[BENCH_VALUES][4];    //x1,x2,y1,y2
+float abRef[BENCH_VALUES][2];        //x,v
+float bb0,bb1,bb2,ba1,ba2;           //unrounded biquad coefficients
+
+unsigned long noiseSeed;
+
+// Command inputs - for receiving commands from user via Serial terminal
+char command; // command character
+
+
+//=======================================================================
+// ARDUINO SETUP AND LOOP FUNCTIONS
+
+void setup()
+{
+  // initialize serial port
+  Serial.begin(115200);
+
+  ArduEyeOFO.BiquadLowPass(&biquad,BIQUAD_FC,BIQUAD_Q);
+
+  runBench();
+}
+
+void loop()
+{
+  if (Serial.available()>0)
+  {
+    command=Serial.read();
+    if (command=='b')
+      runBench();
+  }
+}
+
+
+//=======================================================================
+// FUNCTIONS DEFINED FOR THIS SKETCH
+
+// makeFlow fills flow[] with frame f of the test signal: an offset per
+// value, a step at frame 60 on even values, a ramp on odd values and
+// +-3 of noise, all within the Q8.8 range.  The last BENCH_SAT values
+// step between +127 and -128 every BENCH_SAT_FRAMES frames instead.
+void makeFlow(short f)
+{
+  short i,v;
+
+  for (i=0; i<BENCH_VALUES; ++i)
+  {
+    if (i>=BENCH_VALUES-BENCH_SAT)
+    {
+      flow[i]=(((f/BENCH_SAT_FRAMES)+i)&1) ? -128 : 127;
+      continue;
+    }
+    v=((i*7)%21)-10;
+    if (!(i&1))
+      v+=(f>=60) ? 40 : 0;
+    else
+      v+=((f%100)-50)/2;
+    noiseSeed=noiseSeed*1103515245UL+12345;
+    v+=(short)((noiseSeed>>16)%7)-3;
+    flow[i]=v;
+  }
+}
+
+// resetFilters zeroes all states, fixed and float
+void resetFilters()
+{
+  short i;
+
+  noiseSeed=1;
+  medianPos=0;
+  for (i=0; i<BENCH_VALUES; ++i)
+  {
+    lpfState[i]=0;
+    lpfRef[i]=0;
+    biquadState[i].x1=biquadState[i].x2=biquadState[i].y1=biquadState[i].y2=0;
+    biquadRef[i][0]=biquadRef[i][1]=biquadRef[i][2]=biquadRef[i][3]=0;
+    abState[i].x=abState[i].v=0;
+    abRef[i][0]=abRef[i][1]=0;
+  }
+  for (i=0; i<BENCH_VALUES*MEDIAN_LEN; ++i)
+    medianHist[i]=0;
+}
+
+// medianRef is the median of the last MEDIAN_LEN inputs of value i,
+// by counting rather than sorting
+short medianRef(short i)
+{
+  short *h=medianHist+i*MEDIAN_LEN;
+  unsigned char j,k,below,same;
+
+  for (j=0; j<MEDIAN_LEN; ++j)
+  {
+    below=same=0;
+    for (k=0; k<MEDIAN_LEN; ++k)
+    {
+      if (h[k]<h[j]) below++;
+      if (h[k]==h[j]) same++;
+    }
+    if ((below<=MEDIAN_LEN/2)&&(below+same>MEDIAN_LEN/2))
+      return h[j];
+  }
+  return 0;
+}
+
+// satRef limits a float state to the range of a Q8.8 short, as the
+// fixed point filters saturate theirs
+float satRef(float v)
+{
+  if (v>32767.0/256)
+    return 32767.0/256;
+  if (v<-128)
+    return -128;
+  return v;
+}
+
+// printResult prints the time per value of a filter in microseconds
+// and CPU cycles, and its largest errors in Q8.8 steps on the test
+// signal and on the saturating steps (-1: not compared)
+void printResult(const char *name, unsigned long us, long err, long errSat)
+{
+  unsigned long us100 = (us*100)/((unsigned long)BENCH_REPS*BENCH_VALUES);
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(us100/100);
+  Serial.print(".");
+  if ((us100%100)<10)
+    Serial.print("0");
+  Serial.print(us100%100);
+  Serial.print(" us/value, ");
+  Serial.print((us100*(F_CPU/1000000L))/100);
+  Serial.print(" cycles/value");
+  if (err>=0)
+  {
+    Serial.print(", max error ");
+    Serial.print(err);
+    Serial.print("/256, saturated ");
+    Serial.print(errSat);
+    Serial.print("/256");
+  }
+  Serial.println();
+}
+
+// noteError keeps the largest error of a filter, separately for the
+// saturating values.  ref is the float state of value i: its output
+// must be within 1 of ref rounded and limited to -128..127, or the
+// error counts the output difference in Q8.8 steps.
+void noteError(long *err, long *errSat, short i, long e, float ref)
+{
+  long r=(ref<0) ? (long)(ref-0.5) : (long)(ref+0.5);
+
+  r=(r>127) ? 127 : (r<-128) ? -128 : r;
+  if ((labs(out[i]-r)>1)&&(labs(out[i]-r)*256>e))
+    e=labs(out[i]-r)*256;
+  if (i<BENCH_VALUES-BENCH_SAT)
+  {
+    if (e>*err) *err=e;
+  }
+  else if (e>*errSat) *errSat=e;
+}
+
+// compareFilters runs the fixed point filters and their float
+// versions side by side and returns the largest state differences,
+// indexed LPF_Q15, Biquad, AlphaBeta, Median
+void compareFilters(long *err, long *errSat)
+{
+  short f,i;
+  float x,y,z;
+
+  resetFilters();
+  for (i=0; i<4; ++i)
+    err[i]=errSat[i]=0;
+
+  for (f=0; f<BENCH_FRAMES; ++f)
+  {
+    makeFlow(f);
+
+    ArduEyeOFO.LPF_Q15(lpfState,flow,out,BENCH_VALUES,OFO_Q15(LPF_ALPHA));
+    for (i=0; i<BENCH_VALUES; ++i)
+    {
+      x=flow[i];
+      lpfRef[i]+=(x-lpfRef[i])*LPF_ALPHA;
+      noteError(&err[0],&errSat[0],i,labs(lpfState[i]-(long)(lpfRef[i]*256)),lpfRef[i]);
+    }
+
+    ArduEyeOFO.Biquad(&biquad,biquadState,flow,out,BENCH_VALUES);
+    for (i=0; i<BENCH_VALUES; ++i)
+    {
+      x=flow[i];
+      y=satRef(bb0*x+bb1*biquadRef[i][0]+bb2*biquadRef[i][1]-ba1*biquadRef[i][2]-ba2*biquadRef[i][3]);
+      biquadRef[i][1]=biquadRef[i][0];
+      biquadRef[i][0]=x;
+      biquadRef[i][3]=biquadRef[i][2];
+      biquadRef[i][2]=y;
+      noteError(&err[1],&errSat[1],i,labs(biquadState[i].y1-(long)(y*256)),y);
+    }
+
+    ArduEyeOFO.AlphaBeta(abState,flow,out,BENCH_VALUES,OFO_Q15(AB_ALPHA),OFO_Q15(AB_BETA));
+    for (i=0; i<BENCH_VALUES; ++i)
+    {
+      x=flow[i];
+      y=satRef(abRef[i][0]+abRef[i][1]);
+      z=satRef(x-y);
+      abRef[i][0]=satRef(y+z*AB_ALPHA);
+      abRef[i][1]=satRef(abRef[i][1]+z*AB_BETA);
+      noteError(&err[2],&errSat[2],i,labs(abState[i].x-(long)(abRef[i][0]*256)),abRef[i][0]);
+    }
+
+    ArduEyeOFO.Median(medianHist,MEDIAN_LEN,&medianPos,flow,out,BENCH_VALUES);
+    for (i=0; i<BENCH_VALUES; ++i)
+      noteError(&err[3],&errSat[3],i,labs(out[i]-medianRef(i))*256,medianRef(i));
+  }
+}
+
+// runBench times every filter over BENCH_REPS frames and prints the
+// results with the errors of compareFilters
+void runBench()
+{
+  long err[4],errSat[4];
+  unsigned long t;
+  short r,i;
+  float w0=2*PI*BIQUAD_FC,alpha=sin(w0)/(2*BIQUAD_Q),a0=1+alpha;
+
+  bb0=(1-cos(w0))/2/a0;
+  bb1=(1-cos(w0))/a0;
+  bb2=bb0;
+  ba1=-2*cos(w0)/a0;
+  ba2=(1-alpha)/a0;
+
+  compareFilters(err,errSat);
+
+  resetFilters();
+  makeFlow(0);
+
+  t=micros();
+  for (r=0; r<BENCH_REPS; ++r)
+    for (i=0; i<BENCH_VALUES; ++i)
+      ArduEyeOFO.LPF(&out[i],&flow[i],LPF_ALPHA);
+  printResult("LPF (float)",micros()-t,-1,-1);
+
+  t=micros();
+  for (r=0; r<BENCH_REPS; ++r)
+    ArduEyeOFO.LPF_Q15(lpfState,flow,out,BENCH_VALUES,OFO_Q15(LPF_ALPHA));
+  printResult("LPF_Q15",micros()-t,err[0],errSat[0]);
+
+  t=micros();
+  for (r=0; r<BENCH_REPS; ++r)
+    ArduEyeOFO.Biquad(&biquad,biquadState,flow,out,BENCH_VALUES);
+  printResult("Biquad",micros()-t,err[1],errSat[1]);
+
+  t=micros();
+  for (r=0; r<BENCH_REPS; ++r)
+    ArduEyeOFO.AlphaBeta(abState,flow,out,BENCH_VALUES,OFO_Q15(AB_ALPHA),OFO_Q15(AB_BETA));
+  printResult("AlphaBeta",micros()-t,err[2],errSat[2]);
+
+  t=micros();
+  for (r=0; r<BENCH_REPS; ++r)
+    ArduEyeOFO.Median(medianHist,MEDIAN_LEN,&medianPos,flow,out,BENCH_VALUES);
+  printResult("Median 5",micros()-t,err[3],errSat[3]);
+}
@@ -60,12 +60,14 @@
 
 #include <ArduEye_SMH.h>  //Stonyman/Hawksbill vision chip library
 #include <ArduEye_GUI.h>  //ArduEye processing GUI interface
+#include <ArduEye_Prof.h> //per stage timing, see ARDUEYE_PROF
 #include <ArduEye_OFO.h>  //Optical Flow support
 #include <CYE_Images_v1.h>  //Some image support functions
 
 
 #include <SPI.h>  //SPI library is needed to use an external ADC
                   //not supported for MEGA 2560
+#include <EEPROM.h>  //EEPROM library is needed for stored profiles
 
 //==============================================================================
 // GLOBAL VARIABLES
@@ -100,8 +102,9 @@
 
 // recall from note above that image arrays are stored row-size in a 1D array
 
-short last_img[MAX_PIXELS];         //1D image array
-short current_img[MAX_PIXELS];
+short img_buf[2][MAX_PIXELS];  //pixel buffers of the two frames
+CYE_Frame frames[2];           //frames around img_buf
+CYE_FrameRing ring;            //current and last frame, swapped each loop
 short row=MAX_ROWS;            //maximum rows allowed by memory
 short col=MAX_COLS;            //maximum cols allowed by memory
 short skiprow=SKIP_PIXELS;     //pixels to be skipped during readout because of downsampling
@@ -111,13 +114,16 @@ short sc=START_COL;          //first pixel col to read
 
 short chipSelect=0;            //which vision chip to read from
 
-// FPN calibration. To save memory we are placing the FPN calibration
-// array in an unsigned char, since the variation between pixels may be 
-// expressed with a single byte. Variable mask_base holds an offset value 
-// applied to the entire FPN array. Thus the FPN mask for pixel i will be the 
-// value mask[i]+mask_base.
-unsigned char mask[MAX_PIXELS]; // 16x16 FPN calibration image
-short mask_base=0; // FPN calibration image base.
+// FPN calibration. fpn_offset holds the per pixel offsets averaged
+// over several frames by the "f" command, and fpn the window they
+// belong to.  getImage subtracts them as the pixels are read, so the
+// flow sees the calibrated image without a second pass over it.  
+// The "f" command also stores them in EEPROM with the biases and 
+// binning, and setup() loads them back, so the calibration survives a
+// power cycle.  Until calibrated the offsets are 0 and the image is 
+// just negated.
+short fpn_offset[MAX_PIXELS]; // FPN calibration offsets
+SMHFPN fpn={START_ROW,MAX_ROWS,SKIP_PIXELS,START_COL,MAX_COLS,SKIP_PIXELS,fpn_offset,0};
 
 // Command inputs - for receiving commands from user via Serial terminal
 char command; // command character
@@ -128,9 +134,10 @@ char vectors[2];
 
 char OFType=0;
 
-//optical flow X and Y
-short filtered_OFX=0,filtered_OFY=0;
-short OFX=0,OFY=0;
+//optical flow X and Y, filtered in fixed point (Q8.8 states)
+short OF[2]={0,0};
+short filtered_OF[2]={0,0};
+short lpfState[2]={0,0};
 
 //default ADC is the Arduino onboard ADC
 unsigned char adcType=SMH1_ADCTYPE_ONBOARD;
@@ -147,29 +154,41 @@ void setup()
   //initialize SPI (needed for external ADC
   SPI.begin();
   
-  //initialize ArduEye Stonyman
-  ArduEyeSMH.begin();
-  
-  //set the initial binning on the vision chip
-  ArduEyeSMH.setBinning(skipcol,skiprow);
+  //initialize ArduEye Stonyman with the binning and, if one was 
+  //stored with the "f" command, the FPN calibration of this chip
+  if (ArduEyeSMH.begin(chipSelect,skipcol,skiprow,&fpn))
+    Serial.println("FPN profile loaded");
+
+  //set up the current and last frame
+  CYE_FrameInit(&frames[0],img_buf[0],row,col,CYE_FRAME_SHORT);
+  CYE_FrameInit(&frames[1],img_buf[1],row,col,CYE_FRAME_SHORT);
+  CYE_FrameRingInit(&ring,frames,2);
 }
 
 void loop() 
 {
 
+  CYE_Frame *current=CYE_FrameRingGet(&ring,0);
+  CYE_Frame *last=CYE_FrameRingGet(&ring,1);
+
   //process commands from serial (should be performed once every execution of loop())
   processCommands();
 
-  //get an image from the stonyman chip
-  ArduEyeSMH.getImage(current_img,sr,row,skiprow,sc,col,skipcol,adcType,chipSelect);
-    
-  //apply an FPNMask to the image.  This needs to be calculated with the "f" command
-  //while the vision chip is covered with a white sheet of paper to expose it to 
-  //uniform illumination.  Once calculated, it will remove fixed-pattern noise  
-  ArduEyeSMH.applyMask(current_img,row*col,mask,mask_base);
+  //get an image from the stonyman chip with the FPN removed.  The FPN
+  //needs to be calibrated with the "f" command while the vision chip is
+  //covered with a white sheet of paper to expose it to uniform 
+  //illumination.  Once calibrated, it will remove fixed-pattern noise.
+  //A stored profile with a different window than the frames is not 
+  //acquired, so skip the flow rather than run it on old pixels
+  if (!ArduEyeSMH.getImage(current,&fpn,adcType,chipSelect))
+  {
+    Serial.println("FPN window does not match the frames");
+    delay(1000);
+    return;
+  }
   
   //if GUI is enabled then send image for display
-  ArduEyeGUI.sendImage(row,col,current_img,row*col);
+  ArduEyeGUI.sendImage(current);
   
   /***********************************************************************************/
   /***********************************************************************************/
@@ -181,33 +200,30 @@ void loop()
   
   //Image Interpolation 2D with standard "plus" shifting
   if(OFType==0)
-    ArduEyeOFO.IIA_Plus_2D(current_img,last_img,row,col,200,&OFX,&OFY);
+    ArduEyeOFO.IIA_Plus_2D(current,last,200,&OF[0],&OF[1]);
   //Image Interpolation 2D with compact "square" shifting
   if(OFType==1)
-    ArduEyeOFO.IIA_Square_2D(current_img,last_img,row,col,200,&OFX,&OFY);
+    ArduEyeOFO.IIA_Square_2D(current,last,200,&OF[0],&OF[1]);
   //Lucas Kanade 2D with standard "plus" shifting
   if(OFType==2)
-    ArduEyeOFO.LK_Plus_2D(current_img,last_img,row,col,200,&OFX,&OFY);
+    ArduEyeOFO.LK_Plus_2D(current,last,200,&OF[0],&OF[1]);
   //Lucas Kanade 2D with compact "square" shifting
   if(OFType==3)
-    ArduEyeOFO.LK_Square_2D(current_img,last_img,row,col,200,&OFX,&OFY);
+    ArduEyeOFO.LK_Square_2D(current,last,200,&OF[0],&OF[1]);
 
-  //low pass filter the X shift
-  ArduEyeOFO.LPF(&filtered_OFX,&OFX,0.35);
-  
-  //low pass filter the Y shift
-  ArduEyeOFO.LPF(&filtered_OFY,&OFY,0.35);
+  //low pass filter the X and Y shifts, without float math
+  ArduEyeOFO.LPF_Q15(lpfState,OF,filtered_OF,2,OFO_Q15(0.35));
   
   //put filtered shifts into array to send to GUI
-  vectors[0]=filtered_OFX;    //vector1 x
-  vectors[1]=filtered_OFY;     //vector1 y
+  vectors[0]=filtered_OF[0];    //vector1 x
+  vectors[1]=filtered_OF[1];     //vector1 y
 
   //send shifts to be displayed on GUI
   ArduEyeGUI.sendVectors(1,1,vectors,1);
   
-  //copy current_img to last_img so two frames are kept
-  //for optical flow calculation
-  CYE_ImgShortCopy(current_img,last_img,row*col);
+  //the current frame becomes the last frame, and the next image is
+  //acquired into the old last frame (pointers are swapped, no copy)
+  CYE_FrameRingRotate(&ring);
   
   //small delay
   delay(5);
@@ -250,10 +266,11 @@ void processCommands()
       }
       break;
 
-    // calculate FPN mask and apply it to current image
+    // calibrate the FPN offsets, averaged over 16 frames, and store 
+    // them for the next power up
     case 'f': 
-      ArduEyeSMH.getImage(current_img,sr,row,skiprow,sc,col,skipcol,adcType,chipSelect);
-      ArduEyeSMH.calcMask(current_img,row*col,mask,&mask_base);
+      ArduEyeSMH.calibrateFPN(&fpn,adcType,chipSelect,16);
+      ArduEyeSMH.saveProfile(chipSelect,&fpn);
       Serial.println("FPN Mask done");  
       break;   
       
@@ -267,6 +284,9 @@ void processCommands()
       chipSelect=commandArgument;
       sprintf(charbuf,"chip select = %d",chipSelect);
       Serial.println(charbuf);
+      //switch to the stored calibration of that chip, if any
+      if (!ArduEyeSMH.loadProfile(chipSelect,ArduEyeSMH.binMask(skipcol,0),ArduEyeSMH.binMask(skiprow,0),&fpn))
+        memset(fpn_offset,0,sizeof(fpn_offset));
       break;
 
     // ? - print up command list
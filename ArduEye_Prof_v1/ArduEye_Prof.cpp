@@ -0,0 +1,182 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_Prof.cpp
+//	ArduEyeProf Library for per stage timing of the ArduEye libraries
+//	
+//	Frame totals, rings and statistics.  See ArduEye_Prof.h.
+//
+/*********************************************************************/
+/*********************************************************************/
+
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+
+//supports older version of ARDUINO IDE
+#if defined(ARDUINO) && ARDUINO >= 100
+  #include "Arduino.h"
+  #else
+  #include "WProgram.h"
+  #endif
+#include "ArduEye_Prof.h"
+
+#if ARDUEYE_PROF
+
+//class instance to be referenced in sketch
+ArduEyeProfClass ArduEyeProf;
+
+//stage names for printStats
+static const char *profStageNames[PROF_NUM_STAGES]=
+{
+  "acquire","address","fpn","flow","gui","user"
+};
+
+/*********************************************************************/
+//	Constructor
+/*********************************************************************/
+
+ArduEyeProfClass::ArduEyeProfClass(void)
+{
+  reset();
+}
+
+/*********************************************************************/
+//	add
+//	Adds "us" microseconds to "stage" of the current frame.  A stage
+//	entered several times per frame (e.g. PROF_ADDRESS once per row)
+//	is summed.
+/*********************************************************************/
+
+void ArduEyeProfClass::add(unsigned char stage,unsigned long us)
+{
+  if (stage<PROF_NUM_STAGES)
+    frame[stage]+=us;
+}
+
+/*********************************************************************/
+//	endFrame
+//	Copies the totals of the current frame into the ring of each 
+//	stage, overwriting the oldest frame once the ring is full
+/*********************************************************************/
+
+void ArduEyeProfClass::endFrame(void)
+{
+  unsigned char s;
+
+  for (s=0; s<PROF_NUM_STAGES; ++s)
+  {
+    ring[s][head]=frame[s];
+    frame[s]=0;
+  }
+
+  head=(head+1)%PROF_RING_SIZE;
+  if (frames<PROF_RING_SIZE)
+    frames++;
+}
+
+/*********************************************************************/
+//	getStats
+//	Computes min/mean/max of a stage over the frames in the ring
+/*********************************************************************/
+
+void ArduEyeProfClass::getStats(unsigned char stage,ProfStats *stats)
+{
+  unsigned long sum=0;
+  unsigned char i;
+
+  stats->minval=0;
+  stats->meanval=0;
+  stats->maxval=0;
+  stats->frames=frames;
+
+  if ((stage>=PROF_NUM_STAGES)||(frames==0))
+    return;
+
+  stats->minval=0xFFFFFFFF;
+  for (i=0; i<frames; ++i)
+  {
+    unsigned long v=ring[stage][i];
+    sum+=v;
+    if (v<stats->minval)
+      stats->minval=v;
+    if (v>stats->maxval)
+      stats->maxval=v;
+  }
+  stats->meanval=sum/frames;
+}
+
+/*********************************************************************/
+//	printStats
+//	Prints one line per stage: name, min, mean and max in 
+//	microseconds over the frames in the ring
+/*********************************************************************/
+
+void ArduEyeProfClass::printStats(void)
+{
+  ProfStats st;
+  unsigned char s;
+
+  for (s=0; s<PROF_NUM_STAGES; ++s)
+  {
+    getStats(s,&st);
+    Serial.print(profStageNames[s]);
+    Serial.print(": min ");
+    Serial.print(st.minval);
+    Serial.print(" mean ");
+    Serial.print(st.meanval);
+    Serial.print(" max ");
+    Serial.print(st.maxval);
+    Serial.println(" us");
+  }
+}
+
+/*********************************************************************/
+//	reset
+//	Clears the current frame and all rings
+/*********************************************************************/
+
+void ArduEyeProfClass::reset(void)
+{
+  unsigned char s,i;
+
+  for (s=0; s<PROF_NUM_STAGES; ++s)
+  {
+    frame[s]=0;
+    for (i=0; i<PROF_RING_SIZE; ++i)
+      ring[s][i]=0;
+  }
+  head=0;
+  frames=0;
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_Prof.h
+//	ArduEyeProf Library for per stage timing of the ArduEye libraries
+//	
+//	Scoped timers placed in the acquisition (ArduEye_SMH), FPN 
+//	correction (applyMask), optical flow (ArduEye_OFO) and GUI 
+//	(ArduEye_GUI) functions add their run time to the current frame.
+//	PROF_FRAME_END() pushes the frame totals into a small ring buffer
+//	per stage, from which min/mean/max are computed.
+//
+//	Profiling is compiled in only when ARDUEYE_PROF is set to 1 below.
+//	At 0 the timers and the profiler compile to nothing, so the 
+//	libraries run exactly the same code as without this library.
+//
+/*********************************************************************/
+/*********************************************************************/
+
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+
+#ifndef ARDUEYE_PROF_H
+#define ARDUEYE_PROF_H
+
+//supports older version of ARDUINO IDE
+#if defined(ARDUINO) && ARDUINO >= 100
+  #include "Arduino.h"
+  #else
+  #include "WProgram.h"
+  #endif
+
+/*********************************************************************/
+// Compile-time switch, set to 1 for a profiling build
+
+#ifndef ARDUEYE_PROF
+#define ARDUEYE_PROF 0
+#endif
+
+//frames kept per stage for the statistics
+#define PROF_RING_SIZE 8
+
+/*********************************************************************/
+// Stages
+
+#define PROF_ACQUIRE	0	//getImage, whole readout
+#define PROF_ADDRESS	1	//pointer/value pulses at line starts
+				//(part of PROF_ACQUIRE)
+#define PROF_FPN	2	//applyMask
+#define PROF_FLOW	3	//optical flow kernels
+#define PROF_GUI	4	//sendImage
+#define PROF_USER	5	//free for the sketch
+#define PROF_NUM_STAGES	6
+
+#if ARDUEYE_PROF
+
+//statistics of one stage over the frames in the ring, microseconds
+struct ProfStats
+{
+  unsigned long minval,meanval,maxval;
+  unsigned char frames;
+};
+
+/*********************************************************************/
+/*********************************************************************/
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEyeProfClass
+/*********************************************************************/
+/*********************************************************************/
+
+class ArduEyeProfClass
+{
+  // user-accessible "public" interface
+  public:
+
+    ArduEyeProfClass(void);		//constructor
+
+    // adds time in microseconds to a stage of the current frame
+    void add(unsigned char stage,unsigned long us);
+
+    // stores the current frame totals in the rings and starts a 
+    // new frame
+    void endFrame(void);
+
+    // min/mean/max of a stage over the last PROF_RING_SIZE frames
+    void getStats(unsigned char stage,ProfStats *stats);
+
+    // prints the statistics of all stages over Serial
+    void printStats(void);
+
+    // clears all frames
+    void reset(void);
+
+  // library-accessible "private" interface
+  private:
+    unsigned long ring[PROF_NUM_STAGES][PROF_RING_SIZE];
+    unsigned long frame[PROF_NUM_STAGES];	//current frame totals
+    unsigned char head;				//next ring entry
+    unsigned char frames;			//valid ring entries
+};
+
+//class instance
+extern ArduEyeProfClass ArduEyeProf;
+
+/*********************************************************************/
+//	ProfScope
+//	Scoped timer: measures from construction to the end of the 
+//	enclosing block and adds the time to a stage
+/*********************************************************************/
+
+class ProfScope
+{
+  public:
+    ProfScope(unsigned char s) : stage(s), start(micros()) {}
+    ~ProfScope() { ArduEyeProf.add(stage,micros()-start); }
+
+  private:
+    unsigned char stage;
+    unsigned long start;
+};
+
+#define PROF_SCOPE(stage) ProfScope _profScope(stage)
+#define PROF_FRAME_END() ArduEyeProf.endFrame()
+
+#else
+
+#define PROF_SCOPE(stage)
+#define PROF_FRAME_END()
+
+#endif
+
+#endif
@@ -54,75 +54,36 @@ policies, either expressed or implied, of Centeye, Inc.
   #include "WProgram.h"
   #endif
 
-/*********************************************************************/
-//loads pin definitions based on the board type
-//set in the Arduino IDE
-//currently supports ATmega2560/8/168/328
+//per stage timing hooks, compiled out unless ARDUEYE_PROF is 1
+#include <ArduEye_Prof.h>
 
-#if defined(__AVR_ATmega2560__)
-   	#  include "pin_defs_2560.h"	//2560 defs
-#elif defined (__AVR_ATmega8__)||(__AVR_ATmega168__)|(__AVR_ATmega168P__)||(__AVR_ATmega328P__)
-	#  include "pin_defs_168_328.h"	//8/168/328 defs
-#else 
-	#  error "Code only supports ATmega 2560 and ATmega 8/168/328"
-#endif
+//frame objects (CYE_Frame)
+#include <CYE_Images_v1.h>
 
 /*********************************************************************/
-//copy pin defs from loaded pin_def headers
-
-#define RESP_PORT  SMH_RESP_PORT
-#define RESP_DDR	 SMH_RESP_DDR
-#define RESP	 SMH_RESP_PIN
-
-#define INCP_PORT	 SMH_INCP_PORT
-#define INCP_DDR   SMH_INCP_DDR
-#define INCP	 SMH_INCP_PIN
-	
-#define RESV_PORT	 SMH_RESV_PORT
-#define RESV_DDR	 SMH_RESV_DDR
-#define RESV	 SMH_RESV_PIN
-
-#define INCV_PORT	 SMH_INCV_PORT
-#define INCV_DDR	 SMH_INCV_DDR
-#define INCV	 SMH_INCV_PIN
+//pin traits of the supported boards (SMHPinsDefault is the pin set
+//of the board set in the Arduino IDE)
 
-#define INPHI_PORT SMH_INPHI_PORT
-#define INPHI_DDR  SMH_INPHI_DDR
-#define INPHI	 SMH_INPHI_PIN
-
-#define ADC_SS_PORT SMH_ADC_SS_PORT
-#define ADC_SS_DDR  SMH_ADC_SS_DDR
-#define ADC_SS      SMH_ADC_SS_PIN
-
-#define ANALOG_PORT SMH_ANALOG_PORT
-#define ANALOG_DDR  SMH_ANALOG_DDR
-#define ANALOG0	  SMH_ANALOG0
-#define ANALOG1	  SMH_ANALOG1
-#define ANALOG2	  SMH_ANALOG2
-#define ANALOG3	  SMH_ANALOG3
+#include "ArduEye_SMH_Pins.h"
 
 /*********************************************************************/
-//MACROS to pulse chip lines
+//MACROS to pulse chip lines on the default pin set (ArduEyeSMH).
+//Library code uses the pin set of its chip, Pins::INCV::pulse().
 
-#define SMH1_ResP_Pulse {RESP_PORT|=RESP;RESP_PORT&=~RESP;}
+#define SMH1_ResP_Pulse {SMHPinsDefault::RESP::pulse();}
 	
-#define SMH1_IncP_Pulse {INCP_PORT|=INCP;INCP_PORT&=~INCP;}
+#define SMH1_IncP_Pulse {SMHPinsDefault::INCP::pulse();}
 
-#define SMH1_ResV_Pulse {RESV_PORT|=RESV;RESV_PORT&=~RESV;}
+#define SMH1_ResV_Pulse {SMHPinsDefault::RESV::pulse();}
 	
-#define SMH1_IncV_Pulse {INCV_PORT|=INCV;INCV_PORT&=~INCV;}
+#define SMH1_IncV_Pulse {SMHPinsDefault::INCV::pulse();}
 
 /*********************************************************************/
 //MACROS for inphi (delay is inserted between high and low)
 
-#define SMH1_InPhi_SetHigh {INPHI_PORT|=INPHI;}
+#define SMH1_InPhi_SetHigh {SMHPinsDefault::INPHI::high();}
 	
-#define SMH1_InPhi_SetLow {INPHI_PORT&=~INPHI;}	
-
-/*********************************************************************/
-//MACRO to set all pins low
-
-#define SMH1_SetAllLow {RESP_PORT&=~RESP;INCP_PORT&=~INCP;RESV_PORT&=~RESV;INCV_PORT&=~INCV;INPHI_PORT&=~INPHI;} 
+#define SMH1_InPhi_SetLow {SMHPinsDefault::INPHI::low();}	
 
 /*********************************************************************/
 //SMH System Registers
@@ -136,6 +97,40 @@ policies, either expressed or implied, of Centeye, Inc.
 #define SMH_SYS_NBIAS 6		//nbias
 #define SMH_SYS_AOBIAS 7	//analog out bias
 
+#define SMH_SYS_NUMREGS 8	//number of system registers
+
+/*********************************************************************/
+//Number of vision chips supported on ANALOG0-3
+
+#define SMH_MAX_CHIPS 4
+
+/*********************************************************************/
+//Shadow register support
+
+//marks a shadow pointer or register value as unknown, which forces
+//the next write to pulse RESP/RESV before incrementing
+#define SMH_SHADOW_UNKNOWN -1
+
+//largest value a register shadow may hold.  The system registers 
+//are 8 bits wide and wrap past it, so a shadow incremented beyond it
+//becomes unknown.  The pointer shadow only holds register numbers
+//(below SMH_SYS_NUMREGS) and needs no limit.
+#define SMH_SHADOW_MAX 0xFF
+
+//set to 1 to count RESP/INCP/RESV/INCV pulses (see getPulseCount).
+//Left at 0 the increments compile out and cost nothing per pulse;
+//the counter itself is always a member so the class layout does not
+//depend on the setting.  The library is compiled once, so set it for
+//the whole build (compiler flag), not in a sketch.  Host builds 
+//count by default.
+#ifndef SMH_COUNT_PULSES
+#if defined(_ARDUEYE_HOST_ARDUINO_H_INCLUDED)
+#define SMH_COUNT_PULSES 1
+#else
+#define SMH_COUNT_PULSES 0
+#endif
+#endif
+
 /*********************************************************************/
 //default values
 
@@ -150,6 +145,14 @@ policies, either expressed or implied, of Centeye, Inc.
 #define SMH_GAIN_DEFAULT 0	//no amp gain
 #define SMH_SELAMP_DEFAULT 0	//amp bypassed
 
+/*********************************************************************/
+// Readout timing model, see predictPixelRate
+
+//SPI clock used with the external ADCs (Arduino default is F_CPU/4)
+#ifndef SMH_SPI_CLOCK_HZ
+#define SMH_SPI_CLOCK_HZ (F_CPU/4)
+#endif
+
 /*********************************************************************/
 // ADC types
 
@@ -161,19 +164,302 @@ policies, either expressed or implied, of Centeye, Inc.
 #define SMH1_ADCTYPE_MCP3201_2 2
 // MCP3001, Microchip, 10bits, 200ksps
 #define SMH1_ADCTYPE_MCP3001 3
+// ARDUINO ONBOARD ADC, programmed directly in free-running mode
+// with the prescaler set by setADCPrescaler, 10 bits
+#define SMH1_ADCTYPE_ONBOARD_FAST 4
+// as above, left adjusted (ADLAR) 8 bit result
+#define SMH1_ADCTYPE_ONBOARD_FAST8 5
+
+// default onboard ADC prescaler for the fast ADC types (1MHz ADC
+// clock at 16MHz, about 13us per pixel)
+#define SMH_ADC_PRESCALER_DEFAULT 16
+
+//number of ADC types above, each has its own timing profile
+#define SMH_NUM_ADCTYPES 6
+
+/*********************************************************************/
+// Pixel timing profiles, see setTiming and calibrateTiming
+
+//per pixel delays in microseconds: settling after the address 
+//change, INPHI pulse width (amplifier only) and settling before the
+//sample.  A zero settling delay is skipped.
+struct SMHTiming
+{
+  unsigned char settle1,inphi,settle2;
+};
+
+//default profile, the delays the readout loops always used
+#define SMH_TIMING_SETTLE1_DEFAULT 1
+#define SMH_TIMING_INPHI_DEFAULT 2
+#define SMH_TIMING_SETTLE2_DEFAULT 1
+
+//calibrateTiming: reference delays, window size and frames averaged
+#define SMH_CAL_REF_US 4
+#define SMH_CAL_SIZE 8
+#define SMH_CAL_PIXELS (SMH_CAL_SIZE*SMH_CAL_SIZE)
+#define SMH_CAL_FRAMES 4
+
+/*********************************************************************/
+// Background acquisition, see startBackground
+
+//on AVR the readout is stepped by the ADC conversion complete 
+//interrupt, on a Linux or Mac host build by a thread.  The library 
+//leaves ADC_vect to the sketch, which hands it to the readout with
+//  ISR(ADC_vect) { ArduEyeSMH.backgroundStep(); }
+//Define SMH_USE_BG_ISR for the whole build to have ArduEye_SMH.cpp
+//define it instead.
+#if defined(__AVR__)
+#define SMH_BG_ISR 1
+#elif defined(__linux__) || defined(__APPLE__)
+#define SMH_BG_THREAD 1
+#include <pthread.h>
+#endif
+
+//number of frame slots used by background acquisition
+#define SMH_BG_SLOTS 3
+
+//flag in the shared slot index: frame not yet taken by the consumer
+#define SMH_BG_FRESH 0x80
+
+//background states, one step per conversion: converting the pixel,
+//moving the row or column register, settling (a conversion whose 
+//result is dropped stands in for each delay)
+#define SMH_BG_SAMPLE 0
+#define SMH_BG_ROW 1
+#define SMH_BG_COLUMN 2
+#define SMH_BG_SETTLE1 3
+#define SMH_BG_INPHI 4
+#define SMH_BG_SETTLE2 5
+
+//most INCV pulses sent in one background step
+#define SMH_BG_PULSES 16
+
+/*********************************************************************/
+// Multi-ROI acquisition, see getImageROIs
+
+//maximum number of regions read in one getImageROIs call
+#define SMH_MAX_ROIS 8
+
+//returned by SMHROIScan when no row or column is left
+#define SMH_ROI_END 0xFF
+
+//one rectangular region, same window parameters as getImage, and
+//the array receiving its pixels raster-wise
+struct SMHROI
+{
+  unsigned char rowstart,numrows,rowskip;
+  unsigned char colstart,numcols,colskip;
+  short *img;
+};
+
+//one pixel address for getPixels
+struct SMHPixel
+{
+  unsigned char row,col;
+};
+
+//one peak found by findPeaks.  row/col is the brightest pixel of 
+//the peak, row_q8/col_q8 the weighted centroid (Q8).  The sums are
+//accumulated during the readout.
+struct SMHPeak
+{
+  unsigned char row,col;
+  short weight;			//brightness above threshold
+  unsigned short row_q8,col_q8;
+  long sumw,sumwr,sumwc;
+};
+
+/*********************************************************************/
+//	SMHROIScan
+//	Scan order planner for getImageROIs.  Visits the union of the
+//	pixels of all ROIs with rows ascending and, within a row, columns
+//	ascending, so the chip is only moved forward with INCV except for
+//	the return to the first column of each row.  Pixels shared by 
+//	several ROIs are visited once.  Because every ROI is visited in
+//	raster order each one is written sequentially to its own array.
+//
+//	Usage: for (row=nextRow(); row!=SMH_ROI_END; row=nextRow())
+//	         for (col=nextCol(); col!=SMH_ROI_END; col=nextCol())
+//	           store(pixel value at row,col);
+//	The planner needs no chip access, so a host build can print the
+//	scan order it produces.
+/*********************************************************************/
+
+class SMHROIScan
+{
+public:
+  SMHROIScan(SMHROI *rois, unsigned char numrois);
+
+  //next row to visit, SMH_ROI_END when done
+  unsigned char nextRow(void);
+
+  //next column in the current row, SMH_ROI_END at the end of the row
+  unsigned char nextCol(void);
+
+  //stores a value into every ROI containing the current pixel
+  void store(short val);
+
+private:
+  SMHROI *rois;
+  unsigned char numrois;
+  unsigned char rownext[SMH_MAX_ROIS],rowsleft[SMH_MAX_ROIS];
+  unsigned char colnext[SMH_MAX_ROIS],colsleft[SMH_MAX_ROIS];
+  short *pimg[SMH_MAX_ROIS];	//next output pixel of each ROI
+  unsigned char rowmask;	//ROIs containing the current row
+  unsigned char pixmask;	//ROIs containing the current pixel
+};
+
+/*********************************************************************/
+// Projections, see getImageProjections
+
+//normalization of a projection to the mean of the line, other values
+//of "norm" are a right shift of the sum
+#define SMH_PROJ_MEAN -1
+
+/*********************************************************************/
+// Fixed pattern noise, see calibrateFPN
+
+//per pixel gain of SMHFPN in Q7, this value is a gain of 1
+#define SMH_FPN_GAIN_ONE 128
+
+//calibration of a window: per pixel offsets (the average of several
+//frames under uniform light) and optionally per pixel gains (from a
+//second, brighter uniform light), applied by getImage(fpn) as each
+//pixel is read.  offset and gain hold numrows*numcols values, gain 
+//may be NULL.
+struct SMHFPN
+{
+  unsigned char rowstart,numrows,rowskip;
+  unsigned char colstart,numcols,colskip;
+  short *offset;
+  unsigned char *gain;
+};
+
+/*********************************************************************/
+// Stored profiles, see saveProfile and loadProfile
+
+//EEPROM range used for profiles, override to share the EEPROM with
+//the sketch
+#ifndef SMH_PROFILE_ADDR
+#define SMH_PROFILE_ADDR 0
+#endif
+#ifndef SMH_PROFILE_END
+#define SMH_PROFILE_END (E2END+1)
+#endif
+
+// A profile is:
+//   1 byte   SMH_PROFILE_VALID, or SMH_PROFILE_DELETED once replaced
+//   1 byte   flags, SMH_PROFILE_GAIN if gains follow the offsets
+//   9 bytes  key: chip, HSW, VSW, rowstart, numrows, rowskip, 
+//            colstart, numcols, colskip
+//   7 bytes  VREF, NBIAS, AOBIAS (low byte first) and CONFIG
+//   timing   settle1, inphi, settle2 of each ADC type
+//   data     numrows*numcols offsets (low byte first), then gains
+//   2 bytes  CRC-16 (CCITT, low byte first) of all but the first byte
+// Profiles follow each other, any other first byte ends the list.
+#define SMH_PROFILE_VALID 0xA5
+#define SMH_PROFILE_DELETED 0x00
+#define SMH_PROFILE_GAIN 1
+#define SMH_PROFILE_KEY 9
+#define SMH_PROFILE_HEADER (18+3*SMH_NUM_ADCTYPES)
+
+/*********************************************************************/
+// Binning, see setSwitches and planBinning
+
+//largest on-chip binning (HSW/VSW join pixels within groups of 8)
+#define SMH_BIN_MAX 8
+
+//window and switch registers chosen by planBinning for a target
+//resolution and field of view, applied with setBinning(plan)
+struct SMHBinPlan
+{
+  unsigned char rowstart,numrows,rowskip;
+  unsigned char colstart,numcols,colskip;
+  unsigned char hbin,vbin;		//super pixel size
+  unsigned char hsw,vsw;		//switch masks
+};
 
 /*********************************************************************/
+// Auto exposure, see autoExposure
+
+//histogram bins of getHistogram (the ADC range is split evenly)
+#define SMH_AE_BINS 32
+
+//range of the bias registers
+#define SMH_BIAS_MAX 63
+
+//highest amplifier gain (setAmpGain)
+#define SMH_GAIN_MAX 7
 
+//autoExposureStep results, OR'ed together
+#define SMH_AE_VREF 1		//VREF changed
+#define SMH_AE_AOBIAS 2		//AOBIAS changed
+#define SMH_AE_GAIN 4		//amplifier gain changed
+
+//settings and state of the auto exposure loop, set up with
+//autoExposureInit.  Levels are in histogram bins.
+struct SMHExposure
+{
+  // settings
+  unsigned char lowPct,highPct;	//percentiles bounding the image range
+  unsigned char clipPct;	//% of pixels in an end bin = clipped
+  unsigned char spreadLow;	//range below this: more gain
+  unsigned char spreadHigh;	//range above this: less gain
+  unsigned char centerBand;	//recenter when off center by more
+  unsigned char hold;		//frames a gain change must be wanted
+
+  // registers
+  unsigned char vref,aobias,gain;
+
+  // state
+  signed char vrefDir,aobiasDir;	//+1 if raising it raises the output
+  unsigned char lo,hi;		//percentile bins of the last histogram
+  char centering;		//recentering until within centerBand/2
+  signed char want;		//gain change wanted (+1/-1)
+  unsigned char wantCount;	//frames it has been wanted
+  char moved;			//register moved in the last step
+  signed char movedBy;		//and by how much
+  unsigned char lastCenter;	//image center before the move (bins*2)
+};
 
 /*********************************************************************/
+// Binary dump, see chipToBinary
+//
+// A dump is one frame:
+//   2 bytes  SMH_DUMP_SYNC0, SMH_DUMP_SYNC1
+//   8 bytes  header: bits (10 or 12), ADC type, rows, cols, 
+//            rowstart, colstart, rowskip, colskip
+//   data     pixels raster-wise, packed in groups: 10 bits as 4 
+//            pixels in 5 bytes (the high 8 bits of each, then the low
+//            2 bits of all four, pixel 0 in bits 0-1), 12 bits as 2 
+//            pixels in 3 bytes (high 8 bits of each, then the low 4 
+//            bits, pixel 0 in bits 0-3).  The last group is padded
+//            with zero pixels.
+//   2 bytes  Fletcher-16 of header and data, low sum first
+// host/ArduEye_DumpDecode.cpp converts captured dumps to .mat or raw.
+
+#define SMH_DUMP_SYNC0 0xCE
+#define SMH_DUMP_SYNC1 0x5A
+#define SMH_DUMP_HEADER 8	//header bytes after the sync bytes
+
+/*********************************************************************/
+
+
 /*********************************************************************/
 /*********************************************************************/
 /*********************************************************************/
-//	ArduEyeSMHClass
+/*********************************************************************/
+//	ArduEyeSMHChip
+//	Driver of one vision chip, on the pins of the pin set Pins (see
+//	ArduEye_SMH_Pins.h).  ArduEyeSMHClass is the driver on the 
+//	default pin set of the board; for a chip on other pins include
+//	ArduEye_SMH_Impl.h in the sketch and declare e.g. 
+//	ArduEyeSMHChip<MyPins> chip2;
 /*********************************************************************/
 /*********************************************************************/
 
-class ArduEyeSMHClass 
+template<class Pins>
+class ArduEyeSMHChip 
 {
 
 private:
@@ -181,13 +467,135 @@ private:
   //indicates whether amplifier is in use	
   char useAmp;
 
+  //indicates whether external ADC readout is pipelined
+  char pipelined;
+
+  //ADPS bits and sample/hold time for the fast onboard ADC types
+  unsigned char adcPrescalerBits;
+  unsigned char adcHoldUs;
+
+  //ADC setup found by selectADC, given back by deselectADC
+  unsigned char adcSaveSRA,adcSaveSRB,adcSaveMUX;
+
+  //sequence number of the next frame acquired into a CYE_Frame
+  unsigned short frameSeq;
+
+  //background acquisition state.  The three slots form a triple
+  //buffer: the ISR fills bgBack, the sketch owns bgFront and bgMiddle
+  //is exchanged between them.
+  CYE_Frame *bgFrames;
+  volatile unsigned char bgMiddle;
+  unsigned char bgBack,bgFront;
+  volatile char bgRunning;
+  unsigned char bgRow,bgCol;
+  unsigned short bgIndex;
+  unsigned char bgRowstart,bgRowskip,bgColstart,bgColskip;
+  char bgAnain;
+  unsigned char bgState,bgPulses,bgWait;	//step, INCV pulses and conversions left
+  unsigned char bgSettle1,bgInphi,bgSettle2;	//conversions per delay
+#if defined(SMH_BG_THREAD)
+  pthread_t bgThread;
+  static void *bgThreadMain(void *arg);
+#endif
+
+  //runs the background states up to the next conversion
+  void bgAdvance(void);
+
+  //starts one background conversion
+  void bgConvert(void);
+
+  //applyMask for CYE_FRAME_PACK10/12 frames
+  void applyMaskPacked(CYE_Frame *frame, unsigned char *mask, short mask_base);
+
+  //profile helpers: the key bytes of a profile, and the address of
+  //the valid profile with a key (-1 if none).  If "end" is given the
+  //whole list is scanned and end gets the address after it.
+  static void profileKey(unsigned char *key, char chip, unsigned char hsw, unsigned char vsw, const SMHFPN *fpn);
+  static int findProfile(const unsigned char *key, int *end);
+
+  //calibrateFPN helper: sums numframes frames of the window of fpn
+  void sumFrames(unsigned short *sum, const SMHFPN *fpn, char ADCType, char anain, unsigned char numframes);
+
+  //per pixel timing profile of each ADC type
+  SMHTiming timing[SMH_NUM_ADCTYPES];
+
+  //calibrateTiming helper: summed frames and their mean difference
+  unsigned short timingError(char ADCType, char anain, unsigned char rowstart, unsigned char colstart, short *sum, const short *ref);
+
+  //shadow copy of the chip pointer register
+  char ptrShadow;
+
+  //shadow copies of the eight system register values
+  short regShadow[SMH_SYS_NUMREGS];
+
+  //number of pointer/value pulses emitted since last reset (only
+  //counted with SMH_COUNT_PULSES)
+  unsigned long pulseCount;
+
+  //adds val increments to the shadow of the current register
+  void shadowIncrement(short val);
+
+  //select/deselect the analog input before/after a readout
+  void selectADC(char ADCType,char anain);
+  void deselectADC(char ADCType,char anain);
+
+  //picks the readout loop for the current amplifier setting
+  template<char ADCType,char Pipelined,class Sink>
+  void readoutAmp(Sink &sink, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char anain);
+
+  //readout loop specialized on ADC type, amplifier use, pipelining 
+  //and sink
+  template<char ADCType,char UseAmp,char Pipelined,class Sink>
+  void readoutCore(Sink &sink, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char anain);
+
+  //readout loop for getImageROIs
+  template<char ADCType,char UseAmp>
+  void readoutROICore(SMHROIScan &scan, char anain);
+
+  //readout loop for getPixels
+  template<char ADCType,char UseAmp>
+  void readoutPixelCore(const SMHPixel *pixels, const short *order, short n, short *out, char anain);
+
+  //readout loop for the free-running onboard ADC
+  template<char Bits8,char UseAmp,class Sink>
+  void readoutFreeCore(Sink &sink, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char anain);
+
+  //settles the addressed pixel and starts a free-running conversion
+  //on it
+  template<char Bits8,char UseAmp>
+  void freeWarmUp(const SMHTiming &tm, char anain);
+
+  //readout loop sampling several chips at each pixel address
+  template<char ADCType,char UseAmp>
+  void readoutMultiCore(short **imgs, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, unsigned char chipmask);
+
 public:
 
+/*********************************************************************/
+// Constructor, marks all shadow registers as unknown
+
+  ArduEyeSMHChip(void);
+
 /*********************************************************************/
 // Initialize the vision chip for image readout
   
   void begin(short vref=SMH_VREF_5V0,short nbias=SMH_NBIAS_5V0,short aobias=SMH_AOBIAS_5V0,char gain=SMH_GAIN_DEFAULT,char selamp=SMH_SELAMP_DEFAULT); 
 
+  //begin() with the stored profile of a chip, binning and FPN window
+  char begin(char chip, short hbin, short vbin, SMHFPN *fpn);
+
+/*********************************************************************/
+// Stored profiles (EEPROM)
+
+  //stores biases, binning, timing and FPN calibration as a profile
+  char saveProfile(char chip, const SMHFPN *fpn);
+
+  //loads and applies a stored profile, 0 if there is none
+  char loadProfile(char chip, unsigned char hsw, unsigned char vsw, SMHFPN *fpn);
+
+  //removes all stored profiles
+  void eraseProfiles(void);
+
 /*********************************************************************/
 // Chip Register and Value Manipulation
 
@@ -224,6 +632,44 @@ public:
   //set hsw and vsw registers to bin on-chip
   void setBinning(short hbin,short vbin);
 
+  //same with super pixels starting at hoffset/voffset (offset binning)
+  void setBinning(short hbin,short vbin,unsigned char hoffset,unsigned char voffset);
+
+  //set binning from a plan of planBinning
+  void setBinning(const SMHBinPlan *plan);
+
+  //set raw HSW/VSW switch masks, skipped when already set
+  void setSwitches(unsigned char hsw,unsigned char vsw);
+
+  //switch mask for bin 1, 2, 4 or 8 with the super pixels starting at offset
+  static unsigned char binMask(char bin,unsigned char offset);
+
+  //plans binning and window for a target resolution and field of view
+  static char planBinning(unsigned char rows, unsigned char cols, unsigned char fovrow, unsigned char fovrows, unsigned char fovcol, unsigned char fovcols, SMHBinPlan *plan);
+
+  //set onboard ADC clock divider for the fast onboard ADC types
+  void setADCPrescaler(unsigned char div);
+
+  //sets or gets the per pixel timing profile of an ADC type
+  void setTiming(char ADCType, SMHTiming t);
+  SMHTiming getTiming(char ADCType);
+
+  //finds the shortest timing profile within a noise tolerance
+  unsigned short calibrateTiming(char ADCType, char anain, unsigned char rowstart, unsigned char colstart, short tolerance, short *buf);
+
+  //overlap SPI transfers with column increments (external ADCs)
+  void setPipelined(char state);
+
+  //predicted readout rate in pixels per second for an ADC type
+  unsigned long predictPixelRate(char ADCType);
+
+  //forget shadow register values so the next writes reset the chip
+  void invalidateShadows(void);
+
+  //number of RESP/INCP/RESV/INCV pulses (needs SMH_COUNT_PULSES)
+  unsigned long getPulseCount(void);
+  void resetPulseCount(void);
+
 /*********************************************************************/
 // Bias functions
 
@@ -248,27 +694,119 @@ public:
   //applies pre-calculated FPN mask to an image
   void applyMask(short *img, short size, unsigned char *mask, short mask_base);
 
+  //applies pre-calculated FPN mask to an 8 bit image from getImage
+  void applyMask(char *img, short size, unsigned char *mask, unsigned char shift);
+  void applyMask(unsigned char *img, short size, unsigned char *mask, unsigned char shift);
+  void applyMask(CYE_Frame *frame, unsigned char *mask, short mask_base);
+
+  //averages frames under uniform light into FPN offsets, and under a
+  //second brighter light into per pixel gains
+  unsigned char calibrateFPN(SMHFPN *fpn, char ADCType, char anain, unsigned char numframes);
+  char calibrateFPNGain(SMHFPN *fpn, short *scratch, char ADCType, char anain, unsigned char numframes);
+
   //gets an image from the vision chip
   void getImage(short *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned 	char numcols, unsigned char colskip, char ADCType,char anain);
 
+  //gets an 8 bit image, each pixel is (ADC value-offset)>>shift
+  void getImage(char *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, short offset, unsigned char shift);
+  void getImage(unsigned char *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, short offset, unsigned char shift);
+
+  //gets an image into a frame, window size taken from the frame
+  void getImage(CYE_Frame *frame, unsigned char rowstart, unsigned char rowskip, unsigned char colstart, unsigned char colskip, char ADCType, char anain, short offset=0);
+
+  //gets the window of fpn with the FPN corrected as it is read, the
+  //frame version returns 0 if the frame does not match the window
+  void getImage(short *img, const SMHFPN *fpn, char ADCType, char anain);
+  char getImage(CYE_Frame *frame, const SMHFPN *fpn, char ADCType, char anain);
+
+  //gets an image one row at a time, handing each row to rowfunc 
+  //so no frame buffer is needed (see ArduEye_SMH_Readout.h)
+  template<class F>
+  void getImageRows(short *rowbuf, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, F &rowfunc);
+
+  //gets the same box section from several chips in one pass,
+  //returns 0 for an ADC type that cannot read several chips
+  char getImageMulti(short **imgs, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, unsigned char chipmask);
+
+  //gets several rectangular regions in one planned scan
+  void getImageROIs(SMHROI *rois, unsigned char numrois, char ADCType, char anain);
+
+  //gets a list of scattered pixels, results in list order
+  void getPixels(const SMHPixel *pixels, short n, short *out, short *order, char ADCType, char anain);
+
+  //acquires frames in the background while the sketch processes
+  char startBackground(CYE_Frame *frames, unsigned char rowstart, unsigned char rowskip, unsigned char colstart, unsigned char colskip, char anain);
+  void stopBackground(void);
+
+  //newest completed background frame, NULL if none since last call
+  CYE_Frame *getBackgroundFrame(void);
+
+  //one step of the background state machine (called by the ISR)
+  void backgroundStep(void);
+
   //gets a image from the vision chip, sums each row and returns one pixel for the row
   void getImageRowSum(short *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned 	char numcols, unsigned char colskip, char ADCType,char anain);
  
   //gets a image from the vision chip, sums each col and returns one pixel for the col
   void getImageColSum(short *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned 	char numcols, unsigned char colskip, char ADCType,char anain);
 
+  //row and column projections (and optionally the image) in one pass
+  void getImageProjections(short *rowproj, short *colproj, long *colacc, short *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, char norm);
+
   //takes an image and returns the maximum value row and col
   void findMax(unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType,char anain,unsigned char *max_row, unsigned char *max_col);
 
+  //coarse binned search followed by a full resolution search around
+  //the winner, with a sub-pixel centroid
+  void findMaxCoarseToFine(unsigned char rowstart, unsigned char numrows, unsigned char colstart, unsigned char numcols, char bin, char ADCType, char anain, unsigned char *max_row, unsigned char *max_col, unsigned short *row_q8, unsigned short *col_q8);
+
+  //finds the k brightest separated peaks while reading the chip
+  unsigned char findPeaks(unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, short threshold, unsigned char minsep, SMHPeak *peaks, unsigned char k);
+
+  //same for a recorded image
+  unsigned char findPeaks(const short *img, unsigned char numrows, unsigned char numcols, char brighthigh, short threshold, unsigned char minsep, SMHPeak *peaks, unsigned char k);
+
+  //histogram of a binned pre-frame, SMH_AE_BINS bins
+  void getHistogram(unsigned short *hist, unsigned char rowstart, unsigned char numrows, unsigned char colstart, unsigned char numcols, char bin, char ADCType, char anain);
+
+  //auto exposure: sets up the loop from the current registers
+  void autoExposureInit(SMHExposure *ae);
+
+  //one step of the loop on a histogram, does not touch the chip
+  char autoExposureStep(SMHExposure *ae, const unsigned short *hist);
+
+  //one step of the loop on the chip: histogram, step and register update
+  char autoExposure(SMHExposure *ae, unsigned char rowstart, unsigned char numrows, unsigned char colstart, unsigned char numcols, char bin, char ADCType, char anain);
+
   //prints the entire vision chip over serial as a Matlab array
   void chipToMatlab(char whichchip,char ADCType,char anain);
 
   //prints a section of the vision chip over serial as a Matlab array
   void sectionToMatlab(unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, unsigned char 	anain);   
 
+  //writes the entire vision chip over serial as a packed binary dump
+  void chipToBinary(char whichchip,char ADCType,char anain);
+
+  //writes a section of the vision chip over serial as a packed binary dump
+  void sectionToBinary(unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain);
+
+  //reads a box section of the chip into a pixel sink, all of the
+  //functions above are built on this (see ArduEye_SMH_Readout.h)
+  template<class Sink>
+  void readout(Sink &sink, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain);
+
 };
 
+//driver on the default pins of the board
+typedef ArduEyeSMHChip<SMHPinsDefault> ArduEyeSMHClass;
+
 //external definition of ArduEyeSMH class instance
 extern ArduEyeSMHClass ArduEyeSMH;
 
+//templated readout engine
+#include "ArduEye_SMH_Readout.h"
+
+//the default driver is compiled once, in ArduEye_SMH.cpp
+extern template class ArduEyeSMHChip<SMHPinsDefault>;
+
 #endif
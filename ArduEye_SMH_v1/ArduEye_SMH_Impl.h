@@ -0,0 +1,2999 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_SMH_Impl.h
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Basic functions to operate Stonyman/Hawksbill with ArduEye boards
+//	Supports all Arduino boards that use the ATMega 8/168/328/2560
+//	NOTE: ATMega 2560 SPI for external ADC is not supported.
+//
+//	Definitions of ArduEyeSMHChip.  ArduEye_SMH.cpp compiles them for
+//	the default pin set; include this file in a sketch only to drive
+//	a chip on another pin set.
+//
+//	Working revision started July 9, 2012
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+#ifndef _ARDUEYE_SMH_IMPL_H_INCLUDED
+#define _ARDUEYE_SMH_IMPL_H_INCLUDED
+
+#include "ArduEye_SMH.h"
+#include <EEPROM.h>	//EEPROM required for stored profiles
+
+/*********************************************************************/
+//	Constructor
+//	The register contents of the chip are not known until begin() 
+//	clears them, so all shadow values start out unknown
+/*********************************************************************/
+
+template<class Pins>
+ArduEyeSMHChip<Pins>::ArduEyeSMHChip(void)
+{
+  useAmp=0;
+  pipelined=0;
+  frameSeq=0;
+  bgRunning=0;
+  setADCPrescaler(SMH_ADC_PRESCALER_DEFAULT);
+  adcSaveSRA=adcSaveSRB=adcSaveMUX=0;
+  for (char i=0; i<SMH_NUM_ADCTYPES; ++i)
+  {
+    timing[(unsigned char)i].settle1=SMH_TIMING_SETTLE1_DEFAULT;
+    timing[(unsigned char)i].inphi=SMH_TIMING_INPHI_DEFAULT;
+    timing[(unsigned char)i].settle2=SMH_TIMING_SETTLE2_DEFAULT;
+  }
+  invalidateShadows();
+  resetPulseCount();
+}
+
+/*********************************************************************/
+//	begin
+//	Initializes the vision chips for normal operation.  Sets vision
+//	chip pins to low outputs, clears chip registers, sets biases and
+//	config register.  If no parameters are passed in, default values
+//	are used.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::begin(short vref,short nbias,short aobias,char gain,char selamp)
+{
+  //a chip may have been swapped since the last begin(), so do not
+  //trust the shadow registers
+  invalidateShadows();
+
+  //set all digital pins to output
+  Pins::RESP::output();
+  Pins::INCP::output();
+  Pins::RESV::output();
+  Pins::INCV::output();
+  Pins::INPHI::output();
+
+  //set external ADC SS to high
+  Pins::ADC_SS::output();
+  Pins::ADC_SS::high();
+ 
+  //set all pins low
+  Pins::RESP::low();
+  Pins::INCP::low();
+  Pins::RESV::low();
+  Pins::INCV::low();
+  Pins::INPHI::low();
+
+  //clear all chip register values
+  clearValues();
+
+  //set up biases
+  setBiases(vref,nbias,aobias);
+
+  short config=gain+(selamp*8)+(16);
+  
+  //turn chip on with config value
+  setPointerValue(SMH_SYS_CONFIG,config);
+  
+  //if amp is used, set useAmp variable
+  if(selamp==1)
+   useAmp=1;
+  else
+   useAmp=0;
+
+}
+
+/*********************************************************************/
+//	begin (profile)
+//	Initializes the vision chip as begin() and then, in one pass over
+//	the EEPROM, loads the stored profile of chip "chip" at binning 
+//	hbin x vbin for the window of "fpn": biases, amplifier, binning,
+//	timing and the FPN offsets (and gains if fpn->gain is set).  If 
+//	there is no valid profile the defaults of begin() and the binning
+//	are set, the offsets are zeroed and 0 is returned.  Calibrate then
+//	(e.g. calibrateFPN) and store the result with saveProfile.
+//
+//	EXAMPLE:
+//	short offset[100]; SMHFPN fpn={16,10,8,16,10,8,offset,0};
+//	if (!begin(0,8,8,&fpn)) { calibrateFPN(&fpn,...); saveProfile(0,&fpn); }
+/*********************************************************************/
+
+template<class Pins>
+char ArduEyeSMHChip<Pins>::begin(char chip, short hbin, short vbin, SMHFPN *fpn)
+{
+  short i,n=fpn->numrows*fpn->numcols;
+
+  begin();
+
+  if (loadProfile(chip,binMask(hbin,0),binMask(vbin,0),fpn))
+    return 1;
+
+  setBinning(hbin,vbin);
+  for (i=0; i<n; ++i)
+    fpn->offset[i]=0;
+  if (fpn->gain)
+    for (i=0; i<n; ++i)
+      fpn->gain[i]=SMH_FPN_GAIN_ONE;
+  return 0;
+}
+
+/*********************************************************************/
+//	smhCRC16
+//	CRC-16 (CCITT, polynomial 0x1021) of the stored profiles, one byte
+//	at a time.  Start with 0xFFFF.
+/*********************************************************************/
+
+static inline unsigned short smhCRC16(unsigned short crc, unsigned char b)
+{
+  unsigned char i;
+
+  crc ^= (unsigned short)b<<8;
+  for (i=0; i<8; ++i)
+    crc = (crc&0x8000) ? (crc<<1)^0x1021 : crc<<1;
+  return crc;
+}
+
+/*********************************************************************/
+//	smhProfileRead, smhProfileWrite
+//	One EEPROM byte of a profile, added to the CRC.  Bytes that already
+//	hold the value are not rewritten, to spare the EEPROM.
+/*********************************************************************/
+
+static inline unsigned char smhProfileRead(int addr, unsigned short *crc)
+{
+  unsigned char b=EEPROM.read(addr);
+
+  *crc=smhCRC16(*crc,b);
+  return b;
+}
+
+static inline void smhProfileWrite(int addr, unsigned char b, unsigned short *crc)
+{
+  if (EEPROM.read(addr)!=b)
+    EEPROM.write(addr,b);
+  *crc=smhCRC16(*crc,b);
+}
+
+/*********************************************************************/
+//	profileKey
+//	Key of a profile: chip, switch masks and window
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::profileKey(unsigned char *key, char chip, unsigned char hsw, unsigned char vsw, const SMHFPN *fpn)
+{
+  key[0]=chip;
+  key[1]=hsw;
+  key[2]=vsw;
+  key[3]=fpn->rowstart;
+  key[4]=fpn->numrows;
+  key[5]=fpn->rowskip;
+  key[6]=fpn->colstart;
+  key[7]=fpn->numcols;
+  key[8]=fpn->colskip;
+}
+
+/*********************************************************************/
+//	findProfile
+//	Walks the profile list from SMH_PROFILE_ADDR reading only the 
+//	headers.  Returns the address of the valid profile with "key" or 
+//	-1.  Without "end" the walk stops at that profile, with it the 
+//	whole list is walked and end gets the address after the last 
+//	profile.
+/*********************************************************************/
+
+template<class Pins>
+int ArduEyeSMHChip<Pins>::findProfile(const unsigned char *key, int *end)
+{
+  int addr=SMH_PROFILE_ADDR,found=-1;
+  unsigned char magic,flags,i,match;
+  short n;
+
+  while (addr+SMH_PROFILE_HEADER+2<=SMH_PROFILE_END)
+  {
+    magic=EEPROM.read(addr);
+    if ((magic!=SMH_PROFILE_VALID)&&(magic!=SMH_PROFILE_DELETED))
+      break;
+
+    flags=EEPROM.read(addr+1);
+    match=(magic==SMH_PROFILE_VALID)&&(found<0);
+    for (i=0; i<SMH_PROFILE_KEY; ++i)
+      if (EEPROM.read(addr+2+i)!=key[i])
+        match=0;
+    if (match)
+    {
+      found=addr;
+      if (!end)
+        return found;
+    }
+
+    n=EEPROM.read(addr+6)*EEPROM.read(addr+9);	//numrows*numcols
+    addr+=SMH_PROFILE_HEADER+2*n+((flags&SMH_PROFILE_GAIN) ? n : 0)+2;
+  }
+
+  if (end)
+    *end=addr;
+  return found;
+}
+
+/*********************************************************************/
+//	saveProfile
+//	Stores the current biases, amplifier setting, binning switches 
+//	and timing profiles with the FPN calibration of "fpn" (offsets, and
+//	gains if fpn->gain is set) under the key chip, binning, window.
+//	A profile with the same key and layout is rewritten in place, 
+//	otherwise the new profile is appended and the old one marked 
+//	deleted afterwards, so a reset while saving leaves the old one or
+//	a profile that fails its CRC.  Returns 0 if the chip was not set
+//	up with begin() or the EEPROM range is full (see eraseProfiles).
+//	"chip" identifies the chip, e.g. its analog input.
+/*********************************************************************/
+
+template<class Pins>
+char ArduEyeSMHChip<Pins>::saveProfile(char chip, const SMHFPN *fpn)
+{
+  unsigned char key[SMH_PROFILE_KEY],flags=fpn->gain ? SMH_PROFILE_GAIN : 0;
+  unsigned short crc=0xFFFF;
+  short i,n=fpn->numrows*fpn->numcols;
+  int addr,old,end,a;
+  char r;
+
+  for (r=SMH_SYS_VSW; r<SMH_SYS_NUMREGS; ++r)
+    if (regShadow[(unsigned char)r]==SMH_SHADOW_UNKNOWN)
+      return 0;
+
+  profileKey(key,chip,regShadow[SMH_SYS_HSW],regShadow[SMH_SYS_VSW],fpn);
+  old=findProfile(key,&end);
+
+  if ((old>=0)&&(EEPROM.read(old+1)==flags))
+    addr=old;	//same layout, rewrite in place
+  else
+  {
+    addr=end;
+    if (addr+SMH_PROFILE_HEADER+2*n+(fpn->gain ? n : 0)+2>SMH_PROFILE_END)
+      return 0;
+  }
+
+  a=addr+1;
+  smhProfileWrite(a++,flags,&crc);
+  for (i=0; i<SMH_PROFILE_KEY; ++i)
+    smhProfileWrite(a++,key[i],&crc);
+  for (r=SMH_SYS_VREF; r<SMH_SYS_NUMREGS; ++r)
+  {
+    if (r==SMH_SYS_CONFIG)
+      continue;
+    smhProfileWrite(a++,regShadow[(unsigned char)r]&0xFF,&crc);
+    smhProfileWrite(a++,regShadow[(unsigned char)r]>>8,&crc);
+  }
+  smhProfileWrite(a++,regShadow[SMH_SYS_CONFIG],&crc);
+  for (i=0; i<SMH_NUM_ADCTYPES; ++i)
+  {
+    smhProfileWrite(a++,timing[i].settle1,&crc);
+    smhProfileWrite(a++,timing[i].inphi,&crc);
+    smhProfileWrite(a++,timing[i].settle2,&crc);
+  }
+  for (i=0; i<n; ++i)
+  {
+    smhProfileWrite(a++,fpn->offset[i]&0xFF,&crc);
+    smhProfileWrite(a++,fpn->offset[i]>>8,&crc);
+  }
+  if (fpn->gain)
+    for (i=0; i<n; ++i)
+      smhProfileWrite(a++,fpn->gain[i],&crc);
+  EEPROM.write(a,crc&0xFF);
+  EEPROM.write(a+1,crc>>8);
+
+  if (addr!=old)
+  {
+    // end the list after the new profile, then make it valid
+    if (a+2<SMH_PROFILE_END)
+      EEPROM.write(a+2,0xFF);
+    EEPROM.write(addr,SMH_PROFILE_VALID);
+    if (old>=0)
+      EEPROM.write(old,SMH_PROFILE_DELETED);
+  }
+
+  return 1;
+}
+
+/*********************************************************************/
+//	loadProfile
+//	Finds the profile of chip "chip", switch masks hsw/vsw (see 
+//	binMask) and the window of "fpn" and reads it in one pass, the 
+//	FPN data straight into fpn's arrays.  Only if the CRC matches are
+//	the biases, amplifier, binning and timing applied; otherwise the
+//	offsets are zeroed.  Gains stored without fpn->gain are skipped, 
+//	missing gains are set to 1.  Returns 1 if a profile was applied;
+//	if there is none fpn is left unchanged.
+/*********************************************************************/
+
+template<class Pins>
+char ArduEyeSMHChip<Pins>::loadProfile(char chip, unsigned char hsw, unsigned char vsw, SMHFPN *fpn)
+{
+  unsigned char key[SMH_PROFILE_KEY],hdr[SMH_PROFILE_HEADER],g;
+  unsigned short crc=0xFFFF,stored;
+  short i,n=fpn->numrows*fpn->numcols;
+  int addr,a;
+
+  profileKey(key,chip,hsw,vsw,fpn);
+  addr=findProfile(key,0);
+  if (addr<0)
+    return 0;
+
+  for (i=1; i<SMH_PROFILE_HEADER; ++i)
+    hdr[i]=smhProfileRead(addr+i,&crc);
+  a=addr+SMH_PROFILE_HEADER;
+  for (i=0; i<n; ++i)
+  {
+    fpn->offset[i]=smhProfileRead(a++,&crc);
+    fpn->offset[i]|=(short)smhProfileRead(a++,&crc)<<8;
+  }
+  for (i=0; i<n; ++i)
+  {
+    g=SMH_FPN_GAIN_ONE;
+    if (hdr[1]&SMH_PROFILE_GAIN)
+      g=smhProfileRead(a++,&crc);
+    if (fpn->gain)
+      fpn->gain[i]=g;
+  }
+  stored=EEPROM.read(a)|((unsigned short)EEPROM.read(a+1)<<8);
+
+  if (stored!=crc)
+  {
+    for (i=0; i<n; ++i)
+      fpn->offset[i]=0;
+    if (fpn->gain)
+      for (i=0; i<n; ++i)
+        fpn->gain[i]=SMH_FPN_GAIN_ONE;
+    return 0;
+  }
+
+  setBiases(hdr[11]|(hdr[12]<<8),hdr[13]|(hdr[14]<<8),hdr[15]|(hdr[16]<<8));
+  setConfig(hdr[17]&7,(hdr[17]>>3)&1,(hdr[17]>>4)&1);
+  setSwitches(hsw,vsw);
+  for (i=0; i<SMH_NUM_ADCTYPES; ++i)
+  {
+    timing[i].settle1=hdr[18+3*i];
+    timing[i].inphi=hdr[19+3*i];
+    timing[i].settle2=hdr[20+3*i];
+  }
+
+  return 1;
+}
+
+/*********************************************************************/
+//	eraseProfiles
+//	Ends the profile list at its first byte, the next saveProfile 
+//	starts over at SMH_PROFILE_ADDR
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::eraseProfiles(void)
+{
+  EEPROM.write(SMH_PROFILE_ADDR,0xFF);
+}
+
+/*********************************************************************/
+//	setPointer
+//	Sets the pointer system register to the desired value.  The 
+//	pointer can only be incremented, so RESP is pulsed only when the 
+//	target is below the current (shadowed) pointer or the pointer is 
+//	unknown.  Otherwise only the missing INCP pulses are sent.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setPointer(char ptr)
+{
+  char cur=ptrShadow;
+
+  if((cur==SMH_SHADOW_UNKNOWN)||(ptr<cur))
+  {
+    // clear pointer
+    Pins::RESP::pulse();
+#if SMH_COUNT_PULSES
+    pulseCount++;
+#endif
+    cur=0;
+  }
+
+  // increment pointer to desired value
+  for (char i=cur; i<ptr; ++i) 
+    Pins::INCP::pulse();
+
+#if SMH_COUNT_PULSES
+  if(ptr>cur)
+    pulseCount+=ptr-cur;
+#endif
+
+  ptrShadow=ptr;
+}
+
+/*********************************************************************/
+//	setValue
+//	Sets the value of the current register.  If the shadow copy of
+//	the register is known and not above the target, RESV is skipped
+//	and only the forward INCV pulses are sent.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setValue(short val) 
+{
+  short cur=SMH_SHADOW_UNKNOWN;
+  char known=(ptrShadow>=0)&&(ptrShadow<SMH_SYS_NUMREGS);
+
+  if(known)
+    cur=regShadow[(unsigned char)ptrShadow];
+
+  if((cur==SMH_SHADOW_UNKNOWN)||(val<cur))
+  {
+    // clear value
+    Pins::RESV::pulse();
+#if SMH_COUNT_PULSES
+    pulseCount++;
+#endif
+    cur=0;
+  }
+
+  // increment value
+  for (short i=cur; i<val; ++i) 
+    Pins::INCV::pulse();
+
+#if SMH_COUNT_PULSES
+  if(val>cur)
+    pulseCount+=val-cur;
+#endif
+
+  if(known)
+    regShadow[(unsigned char)ptrShadow]=(val>SMH_SHADOW_MAX)?SMH_SHADOW_UNKNOWN:((val>0)?val:0);
+}
+
+/*********************************************************************/
+//	incValue
+//	Sets the pointer system register to the desired value.  Value is
+//	not reset so the current value must be taken into account
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::incValue(short val) 
+{
+  for (short i=0; i<val; ++i) //increment pointer
+    Pins::INCV::pulse();
+
+  shadowIncrement(val);
+}
+
+/*********************************************************************/
+//	shadowIncrement
+//	Accounts for val INCV pulses that were already sent to the chip:
+//	advances the shadow of the current register and the pulse count
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::shadowIncrement(short val)
+{
+  if(val<=0)
+    return;
+
+#if SMH_COUNT_PULSES
+  pulseCount+=val;
+#endif
+
+  // keep the shadow of the current register in step
+  if((ptrShadow>=0)&&(ptrShadow<SMH_SYS_NUMREGS))
+  {
+    short *shadow=&regShadow[(unsigned char)ptrShadow];
+
+    if((*shadow==SMH_SHADOW_UNKNOWN)||(*shadow>SMH_SHADOW_MAX-val))
+      *shadow=SMH_SHADOW_UNKNOWN;
+    else
+      *shadow+=val;
+  }
+}
+
+/*********************************************************************/
+//	invalidateShadows
+//	Marks the pointer and all register shadows as unknown.  Call 
+//	this after driving the chip lines outside of this class, the 
+//	next pointer and value writes will then start with a reset.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::invalidateShadows(void)
+{
+  ptrShadow=SMH_SHADOW_UNKNOWN;
+
+  for (char i=0; i!=SMH_SYS_NUMREGS; ++i)
+    regShadow[(unsigned char)i]=SMH_SHADOW_UNKNOWN;
+}
+
+/*********************************************************************/
+//	getPulseCount / resetPulseCount
+//	Number of RESP, INCP, RESV and INCV pulses sent to the chip.
+//	Only counted when SMH_COUNT_PULSES is set to 1, otherwise zero.
+/*********************************************************************/
+
+template<class Pins>
+unsigned long ArduEyeSMHChip<Pins>::getPulseCount(void)
+{
+  return pulseCount;
+}
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::resetPulseCount(void)
+{
+  pulseCount=0;
+}
+
+/*********************************************************************/
+//	pulseInphi
+//	Operates the amplifier.  Sets inphi pin high, delays to allow
+//	value time to settle, and then brings it low.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::pulseInphi(char delay) 
+{
+  Pins::INPHI::high();
+  if (delay>0)
+    delayMicroseconds(delay);
+  Pins::INPHI::low();
+}
+
+/*********************************************************************/
+//	setPointerValue
+//	Sets the pointer to a register and sets the value of that        
+//	register
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setPointerValue(char ptr,short val)
+{
+	setPointer(ptr);	//set pointer to register
+      setValue(val);	//set value of that register
+}
+
+/*********************************************************************/
+//	clearValues
+//	Resets the value of all registers to zero
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::clearValues(void)
+{
+    for (char i=0; i!=8; ++i)
+    	setPointerValue(i,0);	//set each register to zero
+}
+
+/*********************************************************************/
+//	setVREF
+//	Sets the VREF register value (0-63)
+/*********************************************************************/
+
+template<class Pins>
+void  ArduEyeSMHChip<Pins>::setVREF(short vref)
+{
+  setPointerValue(SMH_SYS_VREF,vref);
+}
+
+/*********************************************************************/
+//	setNBIAS
+//	Sets the NBIAS register value (0-63)
+/*********************************************************************/
+
+template<class Pins>
+void  ArduEyeSMHChip<Pins>::setNBIAS(short nbias)
+{
+  setPointerValue(SMH_SYS_NBIAS,nbias);
+}
+
+/*********************************************************************/
+//	setAOBIAS
+//	Sets the AOBIAS register value (0-63)
+/*********************************************************************/
+
+template<class Pins>
+void  ArduEyeSMHChip<Pins>::setAOBIAS(short aobias)
+{
+  setPointerValue(SMH_SYS_AOBIAS,aobias);
+}
+
+/*********************************************************************/
+//	setBiasesVdd
+//	Sets biases based on chip voltage
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setBiasesVdd(char vddType)
+{
+  
+  // determine biases. Only one option for now.
+  switch (vddType) 
+  {
+    case SMH1_VDD_5V0:	//chip receives 5V
+    default:
+      setPointerValue(SMH_SYS_NBIAS,SMH_NBIAS_5V0);
+	setPointerValue(SMH_SYS_AOBIAS,SMH_AOBIAS_5V0);
+	setPointerValue(SMH_SYS_VREF,SMH_VREF_5V0);
+    break;
+  }
+}
+
+/*********************************************************************/
+//	setBiases
+//	Sets all three biases
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setBiases(short vref,short nbias,short aobias)
+{
+   	setPointerValue(SMH_SYS_NBIAS,nbias);
+	setPointerValue(SMH_SYS_AOBIAS,aobias);
+	setPointerValue(SMH_SYS_VREF,vref);
+}
+
+/*********************************************************************/
+//	setConfig
+//	Sets configuration register
+//	cvdda:  (1) connect vdda, always should be connected
+//	selamp: (0) bypasses amplifier, (1) connects it
+//	gain: amplifier gain 1-7
+//	EXAMPLE 1: To configure the chip to bypass the amplifier:
+//	setConfig(0,0,1);
+//	EXAMPLE 2: To use the amplifier and set the gain to 4:
+//	setConfig(4,1,1);
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setConfig(char gain, char selamp, char cvdda) 
+{
+   short config=gain+(selamp*8)+(cvdda*16);	//form register value
+
+   if(selamp==1)	//if selamp is 1, set useAmp variable to 1
+     useAmp=1;
+   else 
+     useAmp=0;
+  
+   // Note that config will have the following form binary form:
+   // 000csggg where c=cvdda, s=selamp, ggg=gain (3 bits)
+   // Note that there is no overflow detection in the input values.
+   setPointerValue(SMH_SYS_CONFIG,config);
+}
+
+/*********************************************************************/
+//	setAmpGain
+//	A friendlier version of setConfig.  If amplifier gain is set to 
+//	zero, amplifier is bypassed.  Otherwise the appropriate amplifier
+//	gain (range 1-7) is set.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setAmpGain(char gain)
+{
+   short config;
+
+   if((gain>0)&&(gain<8))	//if gain is a proper value, connect amp
+   {
+    config=gain+8+16;	//gain+(selamp=1)+(cvdda=1)
+    useAmp=1;	//using amplifier
+   }
+   else	//if gain is zero or outside range, bypass amp
+   {
+    config=16;	//(cvdda=1)
+    useAmp=0;	//bypassing amplifier
+   }
+
+   setPointerValue(SMH_SYS_CONFIG,config);	//set config register
+}
+
+/*********************************************************************/
+//	setAnalogInput
+//	Sets the analog pin for one vision chip to be an input.
+//	This is for the Arduino onboard ADC, not an external ADC
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setAnalogInput(char analogInput)
+{
+ switch (analogInput)
+ {
+    case 0:
+      Pins::ANALOG0::input();	//set chip 0 as analog input
+      break;
+    case 1:
+      Pins::ANALOG1::input();
+      break;
+    case 2:
+      Pins::ANALOG2::input();
+      break;
+    case 3:
+      Pins::ANALOG3::input();
+      break;
+  }
+}
+
+/*********************************************************************/
+//	setADCInput
+//	Sets the analog pin to be a digital output and select a chip
+//	to connect to the external ADC.  The state can be used to
+//	deselect a particular chip as well.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setADCInput(char ADCInput,char state)
+{
+  
+  // make sure A# pin is set to be a digital output
+  switch (ADCInput){
+    case 0:
+      Pins::ANALOG0::output(); // set A0 to output
+      if (state)
+        Pins::ANALOG0::high(); // turn on
+      else
+        Pins::ANALOG0::low(); // turn off
+      break;
+    case 1:
+      Pins::ANALOG1::output(); // set A1 to output
+      if (state)
+        Pins::ANALOG1::high(); // turn on
+      else
+        Pins::ANALOG1::low(); // turn off
+      break;
+    case 2:
+      Pins::ANALOG2::output(); // set A2 to output
+      if (state)
+        Pins::ANALOG2::high(); // turn on
+      else
+        Pins::ANALOG2::low(); // turn off
+      break;
+    case 3:
+      Pins::ANALOG3::output(); // set A3 to output
+      if (state)
+        Pins::ANALOG3::high(); // turn on
+      else
+        Pins::ANALOG3::low(); // turn off
+      break;
+  }
+}
+
+/*********************************************************************/
+//	selectADC
+//	Prepares the analog input of one chip before a readout.  The 
+//	onboard ADC and the ArduEye Bug MCP3201 read the chip through
+//	an Arduino analog pin, the other external ADCs need the chip to
+//	be enabled with setADCInput.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::selectADC(char ADCType,char anain)
+{
+  if(ADCType==SMH1_ADCTYPE_ONBOARD)	//if using onboard ADC
+     setAnalogInput(anain);		//set analog input to Arduino
+  else if((ADCType==SMH1_ADCTYPE_ONBOARD_FAST)||(ADCType==SMH1_ADCTYPE_ONBOARD_FAST8))
+  {
+     setAnalogInput(anain);
+#if defined(ADCSRA) && defined(ADATE)
+     adcSaveSRA = ADCSRA;
+     adcSaveSRB = ADCSRB;
+     adcSaveMUX = ADMUX;
+
+     // channel and reference (AVcc, as analogRead) once per frame,
+     // left adjusted for the 8 bit type
+     ADMUX = _BV(REFS0) | (anain & 0x07) | ((ADCType==SMH1_ADCTYPE_ONBOARD_FAST8) ? _BV(ADLAR) : 0);
+     ADCSRB = 0;	// auto trigger source: free running
+     ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADSC) | adcPrescalerBits;
+#endif
+  }
+  else if(ADCType==SMH1_ADCTYPE_MCP3201_2)
+  { 
+     setAnalogInput(anain);
+     Pins::ADC_SS::high(); // make sure SS is high
+  }
+  else	//if using external ADC
+  {
+    setADCInput(anain,1); // enable chip
+    Pins::ADC_SS::high(); // make sure SS is high
+  }
+}
+
+/*********************************************************************/
+//	deselectADC
+//	Disables the chip again after a readout with an external ADC.
+//	After the fast onboard types the ADC is given back as selectADC
+//	found it, e.g. set up for analogRead with the prescaler of the
+//	Arduino core or of the sketch.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::deselectADC(char ADCType,char anain)
+{
+  if((ADCType==SMH1_ADCTYPE_ONBOARD_FAST)||(ADCType==SMH1_ADCTYPE_ONBOARD_FAST8))
+  {
+#if defined(ADCSRA) && defined(ADATE)
+    // stop free running and let the last conversion end, so no 
+    // conversion of the chip is left for the next analogRead
+    ADCSRA &= ~_BV(ADATE);
+    while (ADCSRA & _BV(ADSC))
+      ;
+    ADMUX = adcSaveMUX;
+    ADCSRB = adcSaveSRB;
+    ADCSRA = (adcSaveSRA & ~_BV(ADSC)) | _BV(ADIF);	// flag cleared
+#endif
+    return;
+  }
+
+  if((ADCType!=SMH1_ADCTYPE_ONBOARD)&&(ADCType!=SMH1_ADCTYPE_MCP3201_2))
+   setADCInput(anain,0); // disable chip
+}
+
+/*********************************************************************/
+//	setBinning
+//	Configures binning in the focal plane using the VSW and HSW
+//	system registers. The super pixels are aligned with the top left 
+//	of the image.  This function is for the Stonyman chip only. 
+//	VARIABLES:
+//	hbin: set to 1, 2, 4, or 8 to bin horizontally by that amount
+//	vbin: set to 1, 2, 4, or 8 to bin vertically by that amount
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setBinning(short hbin,short vbin)
+{
+  setSwitches(binMask(hbin,0),binMask(vbin,0));
+}
+
+/*********************************************************************/
+//	setBinning (offset)
+//	Offset binning: as above, but the super pixels start at column
+//	hoffset and row voffset (mod the bin size) instead of 0, e.g. to
+//	center a super pixel on a feature or to align the super pixels 
+//	with a window that does not start on a multiple of the bin.
+//	VARIABLES:
+//	hbin,vbin: 1, 2, 4 or 8
+//	hoffset,voffset: first column/row of a super pixel
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setBinning(short hbin,short vbin,unsigned char hoffset,unsigned char voffset)
+{
+  setSwitches(binMask(hbin,hoffset),binMask(vbin,voffset));
+}
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setBinning(const SMHBinPlan *plan)
+{
+  setSwitches(plan->hsw,plan->vsw);
+}
+
+/*********************************************************************/
+//	setSwitches
+//	Writes raw switch masks to HSW and VSW.  Bit k of a mask joins
+//	pixel k-1 and pixel k of every group of 8 (bit 0 joins the last
+//	pixel of the previous group to the first one), so any pattern of
+//	super pixel widths repeating every 8 pixels can be set, e.g. 0x0E
+//	bins pixels 0-3 and leaves 4-7 at full resolution.  A register
+//	whose shadow already holds the mask is not touched, so calling
+//	this before every frame costs nothing once the binning is set.
+//	VARIABLES:
+//	hsw: horizontal switch mask
+//	vsw: vertical switch mask
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setSwitches(unsigned char hsw,unsigned char vsw)
+{
+  if (regShadow[SMH_SYS_HSW]!=hsw)
+    setPointerValue(SMH_SYS_HSW,hsw);
+  if (regShadow[SMH_SYS_VSW]!=vsw)
+    setPointerValue(SMH_SYS_VSW,vsw);
+}
+
+/*********************************************************************/
+//	binMask
+//	Switch mask for super pixels of "bin" pixels (1, 2, 4 or 8, other
+//	values give 1) starting at pixel "offset": every bit is set except
+//	those of the first pixel of each super pixel.  binMask(2,0) is 
+//	0xAA, binMask(4,0) 0xEE, binMask(8,0) 0xFE, binMask(2,1) 0x55.
+/*********************************************************************/
+
+template<class Pins>
+unsigned char ArduEyeSMHChip<Pins>::binMask(char bin,unsigned char offset)
+{
+  unsigned char mask=0xFF;
+  unsigned char k;
+
+  if ((bin!=2)&&(bin!=4)&&(bin!=8))
+    return 0;
+
+  for (k=offset%bin; k<8; k+=bin)
+    mask&=~(1<<k);
+  return mask;
+}
+
+/*********************************************************************/
+//	planBinning
+//	Picks on-chip binning and a readout window to acquire a field of
+//	view at a target resolution.  For each axis the sample spacing is
+//	fov/target, the bin is the largest of 8, 4, 2, 1 not above it and
+//	the spacing is rounded down to a multiple of the bin, so super 
+//	pixels tile the samples without gaps; the sampled span is centered
+//	in the field of view and the super pixels are offset to start at
+//	the first sample.  Binning is free at readout, so this reads each
+//	sample once instead of summing pixels in software.  No chip access,
+//	apply with setBinning(plan) and read with the window of the plan.
+//
+//	VARIABLES:
+//	rows,cols: target resolution
+//	fovrow,fovrows,fovcol,fovcols: field of view, in chip pixels
+//	plan (output): window and switch masks
+//	Returns 1 if the plan reaches the target, 0 if the field of view
+//	has fewer pixels than the target (the plan is then at full 
+//	resolution, clipped to the field of view).
+//
+//	EXAMPLE:
+//	planBinning(14,14,0,112,0,112,&plan): whole Stonyman at 14x14,
+//	bin 8, skip 8.  planBinning(10,10,0,112,0,112,&plan): bin 8, 
+//	skip 8, rows and columns 16 to 95 (the nearest whole tiling).
+/*********************************************************************/
+
+static inline char smhPlanAxis(unsigned char target, unsigned char fovstart, unsigned char fovsize, unsigned char *start, unsigned char *num, unsigned char *skip, unsigned char *bin)
+{
+  unsigned char step,b;
+  char ok=1;
+
+  if (!fovsize)
+    fovsize=1;
+  if (!target || target>fovsize)
+  {
+    target=fovsize;
+    ok=0;
+  }
+
+  step=fovsize/target;
+  for (b=SMH_BIN_MAX; b>step; b/=2)
+    ;
+  step-=step%b;
+
+  *bin=b;
+  *skip=step;
+  *num=target;
+  *start=fovstart+(fovsize-(unsigned short)target*step)/2;
+  return ok;
+}
+
+template<class Pins>
+char ArduEyeSMHChip<Pins>::planBinning(unsigned char rows, unsigned char cols, unsigned char fovrow, unsigned char fovrows, unsigned char fovcol, unsigned char fovcols, SMHBinPlan *plan)
+{
+  char ok;
+
+  ok=smhPlanAxis(rows,fovrow,fovrows,&plan->rowstart,&plan->numrows,&plan->rowskip,&plan->vbin);
+  ok&=smhPlanAxis(cols,fovcol,fovcols,&plan->colstart,&plan->numcols,&plan->colskip,&plan->hbin);
+  plan->vsw=binMask(plan->vbin,plan->rowstart);
+  plan->hsw=binMask(plan->hbin,plan->colstart);
+  return ok;
+}
+
+/*********************************************************************/
+//	setADCPrescaler
+//	Sets the onboard ADC clock divider (2, 4, 8, 16, 32, 64 or 128)
+//	used by SMH1_ADCTYPE_ONBOARD_FAST and _FAST8.  A conversion takes
+//	13 ADC clocks, so at 16MHz a divider of 16 gives about 13us per
+//	pixel against 112us for analogRead.  The AVR ADC is specified
+//	for full 10 bit accuracy up to 200kHz (divider 128 at 16MHz), 
+//	faster clocks trade noise for speed; the benchmark example
+//	characterizes this.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setADCPrescaler(unsigned char div)
+{
+  unsigned char us=F_CPU/1000000L;	//cycles per microsecond
+
+  // ADPS bits are log2 of the divider
+  adcPrescalerBits=1;
+  while ((adcPrescalerBits<7)&&((1<<adcPrescalerBits)<div))
+    adcPrescalerBits++;
+
+  // the sample/hold window closes 1.5 ADC clocks into a conversion,
+  // wait two ADC clocks before changing the column
+  adcHoldUs=(2*(1<<adcPrescalerBits)+us-1)/us;
+}
+
+/*********************************************************************/
+//	setPipelined
+//	Enables (1) or disables (0) pipelined readout for the MCP3001 and
+//	MCP3201 external ADCs.  When pipelined, the column register is 
+//	advanced and the next pixel settles while the low SPI byte of the
+//	current pixel is still shifting out.  Has no effect on the 
+//	onboard ADC.  Requires an SPI clock of 8MHz or less (the Arduino
+//	default is 4MHz).
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setPipelined(char state)
+{
+  pipelined=state;
+}
+
+/*********************************************************************/
+//	setTiming
+//	Sets the per pixel timing profile used with an ADC type by all 
+//	readout functions: t.settle1 microseconds of settling after the
+//	address change, an INPHI pulse of t.inphi microseconds when the 
+//	amplifier is used, and t.settle2 microseconds before the sample.
+//	The profile is a plain struct, so a calibrated one (see 
+//	calibrateTiming) can be stored and set again at startup.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::setTiming(char ADCType, SMHTiming t)
+{
+  if ((ADCType>=0)&&(ADCType<SMH_NUM_ADCTYPES))
+    timing[(unsigned char)ADCType]=t;
+}
+
+/*********************************************************************/
+//	getTiming
+//	Returns the timing profile of an ADC type (the default profile 
+//	for an unknown type)
+/*********************************************************************/
+
+template<class Pins>
+SMHTiming ArduEyeSMHChip<Pins>::getTiming(char ADCType)
+{
+  SMHTiming t={SMH_TIMING_SETTLE1_DEFAULT,SMH_TIMING_INPHI_DEFAULT,SMH_TIMING_SETTLE2_DEFAULT};
+
+  if ((ADCType>=0)&&(ADCType<SMH_NUM_ADCTYPES))
+    t=timing[(unsigned char)ADCType];
+  return t;
+}
+
+/*********************************************************************/
+//	timingError
+//	Reads SMH_CAL_FRAMES frames of the calibration window with the 
+//	current profile, summing them into "sum".  If "ref" is given,
+//	returns the mean absolute difference to it per pixel and frame,
+//	in ADC counts times 16.
+/*********************************************************************/
+
+template<class Pins>
+unsigned short ArduEyeSMHChip<Pins>::timingError(char ADCType, char anain, unsigned char rowstart, unsigned char colstart, short *sum, const short *ref)
+{
+  short *frame=sum+SMH_CAL_PIXELS;	//scratch for one frame
+  unsigned long err=0;
+  char f;
+  short i;
+
+  for (i=0; i<SMH_CAL_PIXELS; ++i)
+    sum[i]=0;
+
+  for (f=0; f<SMH_CAL_FRAMES; ++f)
+  {
+    getImage(frame,rowstart,SMH_CAL_SIZE,1,colstart,SMH_CAL_SIZE,1,ADCType,anain);
+    for (i=0; i<SMH_CAL_PIXELS; ++i)
+      sum[i]+=frame[i];
+  }
+
+  if (ref)
+    for (i=0; i<SMH_CAL_PIXELS; ++i)
+      err+=abs(sum[i]-ref[i]);
+
+  return (err*16)/((unsigned long)SMH_CAL_PIXELS*SMH_CAL_FRAMES);
+}
+
+/*********************************************************************/
+//	calibrateTiming
+//	Finds the shortest timing profile for an ADC type that keeps the
+//	image within "tolerance" of a slow reference.  An 8x8 window 
+//	(SMH_CAL_SIZE) at rowstart,colstart, preferably with some 
+//	texture, is read with all delays at SMH_CAL_REF_US as reference.
+//	Reading the reference twice gives the temporal noise floor.  The
+//	settle2, settle1 and (with the amplifier) inphi delays are then
+//	lowered one at a time, one microsecond per step, as long as the
+//	mean absolute difference to the reference stays within noise
+//	floor plus tolerance.  The result is set with setTiming.
+//
+//	VARIABLES: 
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//	rowstart, colstart: top left of the calibration window
+//	tolerance: allowed extra error, ADC counts times 16
+//	buf: scratch array of 3*SMH_CAL_PIXELS shorts
+//	returns the frame rate gain over the default profile in percent
+//	(e.g. 130 means 1.3 times the frame rate)
+/*********************************************************************/
+
+template<class Pins>
+unsigned short ArduEyeSMHChip<Pins>::calibrateTiming(char ADCType, char anain, unsigned char rowstart, unsigned char colstart, short tolerance, short *buf)
+{
+  SMHTiming ref={SMH_CAL_REF_US,SMH_CAL_REF_US,SMH_CAL_REF_US};
+  SMHTiming deftm={SMH_TIMING_SETTLE1_DEFAULT,SMH_TIMING_INPHI_DEFAULT,SMH_TIMING_SETTLE2_DEFAULT};
+  SMHTiming best,t;
+  unsigned char *field[3];
+  unsigned short limit;
+  unsigned long tdef,tbest;
+  short *refsum=buf;
+  short *sum=buf+SMH_CAL_PIXELS;	//plus one frame of scratch
+  char i;
+
+  if ((ADCType<0)||(ADCType>=SMH_NUM_ADCTYPES))
+    return 100;
+
+  // reference and noise floor
+  setTiming(ADCType,ref);
+  timingError(ADCType,anain,rowstart,colstart,refsum,0);
+  limit=timingError(ADCType,anain,rowstart,colstart,sum,refsum)+tolerance;
+
+  // shorten one delay at a time
+  best=ref;
+  field[0]=&best.settle2;
+  field[1]=&best.settle1;
+  field[2]=&best.inphi;
+  for (i=0; i<(useAmp ? 3 : 2); ++i)
+  {
+    while (*field[(unsigned char)i]>(i==2 ? 1 : 0))
+    {
+      t=best;
+      (*field[(unsigned char)i])--;
+      setTiming(ADCType,best);
+      if (timingError(ADCType,anain,rowstart,colstart,sum,refsum)>limit)
+      {
+        best=t;		//too noisy, keep the previous value
+        break;
+      }
+    }
+  }
+
+  // frame rate gain over the default profile
+  setTiming(ADCType,deftm);
+  tdef=micros();
+  timingError(ADCType,anain,rowstart,colstart,sum,0);
+  tdef=micros()-tdef;
+
+  setTiming(ADCType,best);
+  tbest=micros();
+  timingError(ADCType,anain,rowstart,colstart,sum,0);
+  tbest=micros()-tbest;
+
+  return tbest ? (tdef*100)/tbest : 100;
+}
+
+/*********************************************************************/
+//	predictPixelRate
+//	Timing model of the readout loop.  Returns the predicted number 
+//	of pixels per second for an ADC type with the current amplifier
+//	and pipelining settings, for a window read with colskip=1 and 
+//	without per-row overhead.  Useful to compare ADC types and 
+//	readout modes without hardware, e.g. on a host build.
+//
+//	The model counts CPU cycles: settling delays, the INPHI pulse,
+//	the ADC conversion or SPI transfer (at SMH_SPI_CLOCK_HZ), one 
+//	INCV pulse and a fixed loop/sink overhead.
+/*********************************************************************/
+
+//fixed cycle costs used by the model
+#define SMH_MODEL_LOOP_CYCLES 24	//loop, pointer and sink overhead
+#define SMH_MODEL_INCV_CYCLES 4		//one INCV pulse
+#define SMH_MODEL_CALL_CYCLES 12	//call overhead of a delay or read
+#define SMH_MODEL_ONBOARD_CYCLES (13*128)	//conversion at prescaler 128
+
+template<class Pins>
+unsigned long ArduEyeSMHChip<Pins>::predictPixelRate(char ADCType)
+{
+  unsigned long us=F_CPU/1000000L;	//cycles per microsecond
+  unsigned long spibyte=8*(F_CPU/SMH_SPI_CLOCK_HZ)+SMH_MODEL_CALL_CYCLES;
+  unsigned long cycles;
+  SMHTiming tm=getTiming(ADCType);
+  unsigned long settle1=tm.settle1*us + (tm.settle1 ? SMH_MODEL_CALL_CYCLES : 0);
+
+  // loop overhead, one column increment and the settling delay 
+  // right before sampling
+  cycles = SMH_MODEL_LOOP_CYCLES + SMH_MODEL_INCV_CYCLES;
+  cycles += tm.settle2*us + (tm.settle2 ? SMH_MODEL_CALL_CYCLES : 0);
+
+  // amplifier pulse
+  if (useAmp)
+    cycles += tm.inphi*us + SMH_MODEL_CALL_CYCLES;
+
+  switch (ADCType) 
+  {
+    case SMH1_ADCTYPE_ONBOARD:
+      cycles += settle1;	//first settling delay
+      cycles += SMH_MODEL_ONBOARD_CYCLES + SMH_MODEL_CALL_CYCLES;
+      break;
+    case SMH1_ADCTYPE_ONBOARD_FAST:
+    case SMH1_ADCTYPE_ONBOARD_FAST8:
+      // one conversion per pixel unless the loop work is longer
+      cycles += adcHoldUs*us + SMH_MODEL_CALL_CYCLES;
+      if (cycles < 13UL*(1<<adcPrescalerBits))
+        cycles = 13UL*(1<<adcPrescalerBits);
+      break;
+    case SMH1_ADCTYPE_MCP3001:
+    case SMH1_ADCTYPE_MCP3201:
+    case SMH1_ADCTYPE_MCP3201_2:
+      if (pipelined)	//first settling delay hidden in low byte
+        cycles += spibyte + (spibyte>settle1 ? spibyte : settle1);
+      else
+        cycles += settle1 + 2*spibyte;
+      break;
+    default:
+      cycles += settle1;
+      break;
+  }
+
+  return F_CPU/cycles;
+}
+
+/*********************************************************************/
+//	calcMask
+//	Expose the vision chip to uniform texture (such as a white piece
+//	of paper placed over the optics).  Take an image using the 
+//	getImage function.  Pass the short "img" array and the "size"
+//	number of pixels, along with a unsigned char "mask" array to hold
+//	the FPN mask and mask_base for the FPN mask base.  Function will
+//	populate the mask array and mask_base variable with the FPN mask,
+//	which can then be used with the applMask function.  Pixels more
+//	than 255 above mask_base are saturated to 255; if that matters
+//	use calibrateFPN, which keeps 16 bit offsets.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::calcMask(short *img, short size, unsigned char *mask,short *mask_base)
+{
+ 	*mask_base = 10000; // e.g. "high"
+
+      for (int i=0; i<size; ++i)
+        if (img[i]<(*mask_base))	//find the min value for mask_base
+          *mask_base = img[i];
+
+      // generate calibration mask
+      for (int i=0; i<size; ++i)
+      {
+        short d = img[i] - *mask_base;	//subtract min value for mask
+        mask[i] = (d>255) ? 255 : d;
+      }
+}
+
+/*********************************************************************/
+//	applyMask
+//	given the "mask" and "mask_base" variables calculated in        
+//	calcMask, and a current image, this function will subtract the
+//	mask to provide a calibrated image.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::applyMask(short *img, short size, unsigned char *mask, short mask_base)
+{
+  PROF_SCOPE(PROF_FPN);
+
+	 // Subtract calibration mask
+  	 for (int i=0; i<size;++i) 
+	{
+    		img[i] -= mask_base+mask[i];  //subtract FPN mask
+    		img[i]=-img[i];          //negate image so it displays properly
+ 	}
+}
+
+/*********************************************************************/
+//	applyMask (8 bit)
+//	Same as above for an 8 bit image taken with the 8 bit getImage.
+//	Take the image with offset=mask_base so only the mask remains to
+//	be subtracted, and pass the same "shift" used for the image.  The
+//	mask is scaled down by shift, the result is clamped to the pixel
+//	range and inverted (negated for char, 255-x for unsigned char) so
+//	it displays like the short version.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::applyMask(char *img, short size, unsigned char *mask, unsigned char shift)
+{
+  PROF_SCOPE(PROF_FPN);
+
+  for (int i=0; i<size; ++i)
+    img[i] = smhClamp8<char>(-(img[i]-(mask[i]>>shift)));
+}
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::applyMask(unsigned char *img, short size, unsigned char *mask, unsigned char shift)
+{
+  PROF_SCOPE(PROF_FPN);
+
+  for (int i=0; i<size; ++i)
+    img[i] = 255-smhClamp8<unsigned char>(img[i]-(mask[i]>>shift));
+}
+
+/*********************************************************************/
+//	applyMask (frame)
+//	Applies the FPN mask to a CYE_Frame of any pixel format.  For 8 
+//	bit frames the mask is scaled by the frame's shift (mask_base is
+//	expected to have been used as the acquisition offset).
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::applyMask(CYE_Frame *frame, unsigned char *mask, short mask_base)
+{
+  switch (frame->format)
+  {
+    case CYE_FRAME_CHAR:
+      applyMask((char *)frame->pixels,CYE_FrameNumPix(frame),mask,frame->shift);
+      break;
+    case CYE_FRAME_UCHAR:
+      applyMask((unsigned char *)frame->pixels,CYE_FrameNumPix(frame),mask,frame->shift);
+      break;
+    case CYE_FRAME_PACK10:
+    case CYE_FRAME_PACK12:
+      applyMaskPacked(frame,mask,mask_base);
+      break;
+    default:
+      applyMask((short *)frame->pixels,CYE_FrameNumPix(frame),mask,mask_base);
+      break;
+  }
+}
+
+/*********************************************************************/
+//	applyMaskPacked
+//	applyMask for packed frames, CYE_PACK_MAXCOLS pixels of a row at
+//	a time.  The result is inverted as full scale-(value-mask_base-
+//	mask) rather than negated so it stays in the unsigned pixel range,
+//	and clamped to it.  The mask is scaled down by frame->shift like 
+//	the image.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::applyMaskPacked(CYE_Frame *frame, unsigned char *mask, short mask_base)
+{
+  PROF_SCOPE(PROF_FPN);
+
+  short part[CYE_PACK_MAXCOLS];
+  short full=(frame->format==CYE_FRAME_PACK12) ? 4095 : 1023;
+  unsigned char r,c,n,col;
+
+  for (r=0; r<frame->rows; ++r)
+    for (col=0; col<frame->cols; col+=n)
+    {
+      n=(frame->cols-col>CYE_PACK_MAXCOLS) ? CYE_PACK_MAXCOLS : frame->cols-col;
+      CYE_FrameGetRowPart(frame,r,col,n,part);
+      for (c=0; c<n; ++c)
+        part[c]=full-(part[c]-((mask_base+*mask++)>>frame->shift));
+      CYE_FramePutRowPart(frame,r,col,n,part);
+    }
+}
+
+/*********************************************************************/
+//	sumFrames
+//	Sums "numframes" frames of the window of fpn into "sum", one
+//	unsigned short per pixel.  The caller limits numframes so the sums
+//	cannot overflow.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::sumFrames(unsigned short *sum, const SMHFPN *fpn, char ADCType, char anain, unsigned char numframes)
+{
+  short i,n=fpn->numrows*fpn->numcols;
+
+  for (i=0; i<n; ++i)
+    sum[i]=0;
+
+  while (numframes--)
+  {
+    SMHSumSink sink(sum);
+    readout(sink,fpn->rowstart,fpn->numrows,fpn->rowskip,fpn->colstart,fpn->numcols,fpn->colskip,ADCType,anain);
+  }
+}
+
+/*********************************************************************/
+//	calibrateFPN
+//	Expose the vision chip to uniform texture (as for calcMask) and 
+//	fill in the window, offset and (optionally) gain of "fpn".  This
+//	function averages "numframes" frames of the window into 16 bit 
+//	per pixel offsets, so the random noise of a single frame does not
+//	end up in the calibration and no offset is truncated.  The sums 
+//	are kept in the offset array itself, so numframes is limited to 
+//	what fits in 16 bits: 64 frames for 10 bit ADCs, 16 for the 12 
+//	bit MCP3201.  Gains, if fpn->gain is set, are reset to 1.  Returns
+//	the number of frames averaged.
+//
+//	EXAMPLE:
+//	short offset[64]; SMHFPN fpn={16,8,1,24,8,1,offset,0};
+//	calibrateFPN(&fpn,SMH1_ADCTYPE_ONBOARD,0,32);
+//	getImage(img,&fpn,SMH1_ADCTYPE_ONBOARD,0);
+/*********************************************************************/
+
+template<class Pins>
+unsigned char ArduEyeSMHChip<Pins>::calibrateFPN(SMHFPN *fpn, char ADCType, char anain, unsigned char numframes)
+{
+  PROF_SCOPE(PROF_FPN);
+
+  unsigned short *sum=(unsigned short *)fpn->offset;
+  unsigned short maxframes=65535/smhADCFull(ADCType);
+  short i,n=fpn->numrows*fpn->numcols;
+
+  if (numframes>maxframes)
+    numframes=maxframes;
+  if (numframes<1)
+    numframes=1;
+
+  sumFrames(sum,fpn,ADCType,anain,numframes);
+
+  for (i=0; i<n; ++i)
+    fpn->offset[i]=(sum[i]+(numframes>>1))/numframes;
+
+  if (fpn->gain)
+    for (i=0; i<n; ++i)
+      fpn->gain[i]=SMH_FPN_GAIN_ONE;
+
+  return numframes;
+}
+
+/*********************************************************************/
+//	calibrateFPNGain
+//	Second point of a two point calibration.  After calibrateFPN, 
+//	expose the chip to a uniform light of a clearly different level 
+//	and call this function: it averages "numframes" frames into 
+//	"scratch" (numrows*numcols shorts, e.g. the image buffer) and sets
+//	each pixel's gain so its response between the two lights matches
+//	the window average.  Gains are Q7 (SMH_FPN_GAIN_ONE is 1) and 
+//	saturate at 255, pixels that did not respond keep a gain of 1.
+//	Returns 0 if fpn has no gain array or the two lights read the 
+//	same on average, 1 otherwise.
+/*********************************************************************/
+
+template<class Pins>
+char ArduEyeSMHChip<Pins>::calibrateFPNGain(SMHFPN *fpn, short *scratch, char ADCType, char anain, unsigned char numframes)
+{
+  PROF_SCOPE(PROF_FPN);
+
+  unsigned short *sum=(unsigned short *)scratch;
+  unsigned short maxframes=65535/smhADCFull(ADCType);
+  short i,d,n=fpn->numrows*fpn->numcols;
+  long total=0,mean;
+
+  if (!fpn->gain)
+    return 0;
+  if (numframes>maxframes)
+    numframes=maxframes;
+  if (numframes<1)
+    numframes=1;
+
+  sumFrames(sum,fpn,ADCType,anain,numframes);
+
+  // response of each pixel between the two lights
+  for (i=0; i<n; ++i)
+  {
+    scratch[i]=(short)((sum[i]+(numframes>>1))/numframes)-fpn->offset[i];
+    total+=scratch[i];
+  }
+
+  for (i=0; i<n; ++i)
+    fpn->gain[i]=SMH_FPN_GAIN_ONE;
+  if (!total)
+    return 0;
+
+  // gain=mean response/pixel response, same sign as the mean only
+  mean=total*SMH_FPN_GAIN_ONE/n;
+  if (mean<0)
+  {
+    mean=-mean;
+    for (i=0; i<n; ++i)
+      scratch[i]=-scratch[i];
+  }
+  for (i=0; i<n; ++i)
+  {
+    d=scratch[i];
+    if (d>0)
+      fpn->gain[i]=constrain((mean+(d>>1))/d,1,255);
+  }
+
+  return 1;
+}
+
+/*********************************************************************/
+//	getImage
+//	This function acquires a box section of a Stonyman or Hawksbill 
+//	and saves to image array img.  Note that images are read out in 
+//	raster manner (e.g. row wise) and stored as such in a 1D array. 
+//	In this case the pointer img points to the output array. 
+//
+//	VARIABLES: 
+//	img (output): pointer to image array, an array of signed shorts
+//	rowstart: first row to acquire
+//	numrows: number of rows to acquire
+//	rowskip: skipping between rows (useful if binning is used)
+//	colstart: first column to acquire
+//	numcols: number of columns to acquire
+//	colskip: skipping between columns
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//	
+//	EXAMPLES:
+//	getImage(img,16,8,1,24,8,1,SMH1_ADCTYPE_ONBOARD,0): 
+//	Grab an 8x8 window of pixels at raw resolution starting at row 
+//	16, column 24, from chip using onboard ADC at input 0
+//	getImage(img,0,14,8,0,14,8,SMH1_ADCTYPE_MCP3201,2): 
+//	Grab entire Stonyman chip when using
+//	8x8 binning. Grab from input 2.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getImage(short *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType,char anain) 
+{
+  PROF_SCOPE(PROF_ACQUIRE);
+  SMHStoreSink sink(img);
+
+  readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+}
+
+/*********************************************************************/
+//	getImageMulti
+//	Acquires the same box section from several vision chips at once.
+//	The pointer and value lines are shared by all chips, so the row
+//	and column pulse trains are sent only once and every enabled chip
+//	is sampled at each pixel address.  With N chips this cuts the
+//	addressing overhead by almost a factor of N compared to N calls
+//	of getImage.  The amplifier setting applies to all chips.
+//
+//	VARIABLES: 
+//	imgs (output): array of SMH_MAX_CHIPS image pointers, imgs[n] 
+//	receives the image of the chip on analog input n.  Entries for
+//	chips not in chipmask are not used and may be NULL.
+//	rowstart,numrows,rowskip,colstart,numcols,colskip: as getImage
+//	ADCType: which ADC to use, defined ADC_TYPES.  The ArduEye Bug 
+//	(SMH1_ADCTYPE_MCP3201_2) has a single chip and is not supported,
+//	nor is SMH1_ADCTYPE_UNKNOWN.  The free-running types switch the
+//	ADC input for every sample, which costs them about two 
+//	conversions per chip and pixel instead of one.
+//	chipmask: bit n set reads the chip on analog input n
+//	Returns 1, or 0 without reading anything for an unsupported 
+//	ADCType.
+//	
+//	EXAMPLE:
+//	short img0[64],img2[64];
+//	short *imgs[SMH_MAX_CHIPS]={img0,NULL,img2,NULL};
+//	getImageMulti(imgs,16,8,1,24,8,1,SMH1_ADCTYPE_ONBOARD,0x05): 
+//	Grab an 8x8 window from the chips on inputs 0 and 2
+/*********************************************************************/
+
+template<class Pins>
+char ArduEyeSMHChip<Pins>::getImageMulti(short **imgs, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, unsigned char chipmask)
+{
+  char chip,first=-1;
+
+  if ((ADCType!=SMH1_ADCTYPE_ONBOARD)&&(ADCType!=SMH1_ADCTYPE_ONBOARD_FAST)&&(ADCType!=SMH1_ADCTYPE_ONBOARD_FAST8)
+    &&(ADCType!=SMH1_ADCTYPE_MCP3001)&&(ADCType!=SMH1_ADCTYPE_MCP3201))
+    return 0;	//single chip ADC types, nothing to interleave
+
+  // prepare inputs, external ADC chips start out disabled
+  for (chip=0; chip<SMH_MAX_CHIPS; ++chip)
+  {
+    if (!(chipmask&(1<<chip)))
+      continue;
+    if (first<0)
+      first=chip;
+    if ((ADCType==SMH1_ADCTYPE_MCP3001)||(ADCType==SMH1_ADCTYPE_MCP3201))
+      setADCInput(chip,0);
+    else
+      setAnalogInput(chip);
+  }
+  Pins::ADC_SS::high(); // make sure SS is high
+  if (first<0)
+    return 1;
+
+  // free running from the first chip on, given back afterwards
+  if ((ADCType==SMH1_ADCTYPE_ONBOARD_FAST)||(ADCType==SMH1_ADCTYPE_ONBOARD_FAST8))
+    selectADC(ADCType,first);
+
+  switch (ADCType) 
+  {
+    case SMH1_ADCTYPE_ONBOARD:
+      if (useAmp)
+        readoutMultiCore<SMH1_ADCTYPE_ONBOARD,1>(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,chipmask);
+      else
+        readoutMultiCore<SMH1_ADCTYPE_ONBOARD,0>(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,chipmask);
+      break;
+    case SMH1_ADCTYPE_MCP3001:
+      if (useAmp)
+        readoutMultiCore<SMH1_ADCTYPE_MCP3001,1>(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,chipmask);
+      else
+        readoutMultiCore<SMH1_ADCTYPE_MCP3001,0>(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,chipmask);
+      break;
+    case SMH1_ADCTYPE_MCP3201:
+      if (useAmp)
+        readoutMultiCore<SMH1_ADCTYPE_MCP3201,1>(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,chipmask);
+      else
+        readoutMultiCore<SMH1_ADCTYPE_MCP3201,0>(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,chipmask);
+      break;
+    case SMH1_ADCTYPE_ONBOARD_FAST:
+      if (useAmp)
+        readoutMultiCore<SMH1_ADCTYPE_ONBOARD_FAST,1>(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,chipmask);
+      else
+        readoutMultiCore<SMH1_ADCTYPE_ONBOARD_FAST,0>(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,chipmask);
+      deselectADC(ADCType,first);
+      break;
+    case SMH1_ADCTYPE_ONBOARD_FAST8:
+      if (useAmp)
+        readoutMultiCore<SMH1_ADCTYPE_ONBOARD_FAST8,1>(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,chipmask);
+      else
+        readoutMultiCore<SMH1_ADCTYPE_ONBOARD_FAST8,0>(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,chipmask);
+      deselectADC(ADCType,first);
+      break;
+  }
+  return 1;
+}
+
+/*********************************************************************/
+//	getImageROIs
+//	Acquires several rectangular regions of one chip in a single 
+//	scan instead of one getImage call per region.  The scan order is
+//	planned by SMHROIScan: rows ascending, and within each row the
+//	merged columns of all regions ascending, so rows shared by 
+//	several regions are read once, pixels where regions overlap are 
+//	sampled once, and the chip is addressed with forward INCV pulses
+//	only (plus the RESV returning to the first column of each row).
+//	With SMH_COUNT_PULSES set, getPulseCount shows the saving.
+//
+//	VARIABLES: 
+//	rois: array of regions, each with the getImage window parameters
+//	and the array its pixels are stored in (raster order)
+//	numrois: number of regions, up to SMH_MAX_ROIS
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//
+//	EXAMPLE:
+//	short left[64],right[64];
+//	SMHROI rois[2]={{40,8,1,16,8,1,left},{40,8,1,88,8,1,right}};
+//	getImageROIs(rois,2,SMH1_ADCTYPE_ONBOARD,0):
+//	Grab two 8x8 flow patches from the same rows in one pass
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getImageROIs(SMHROI *rois, unsigned char numrois, char ADCType, char anain)
+{
+  SMHROIScan scan(rois,numrois);
+
+  selectADC(ADCType,anain);
+
+  switch (ADCType) 
+  {
+    case SMH1_ADCTYPE_ONBOARD:
+      if (useAmp)
+        readoutROICore<SMH1_ADCTYPE_ONBOARD,1>(scan,anain);
+      else
+        readoutROICore<SMH1_ADCTYPE_ONBOARD,0>(scan,anain);
+      break;
+    case SMH1_ADCTYPE_MCP3001:
+      if (useAmp)
+        readoutROICore<SMH1_ADCTYPE_MCP3001,1>(scan,anain);
+      else
+        readoutROICore<SMH1_ADCTYPE_MCP3001,0>(scan,anain);
+      break;
+    case SMH1_ADCTYPE_MCP3201:
+      if (useAmp)
+        readoutROICore<SMH1_ADCTYPE_MCP3201,1>(scan,anain);
+      else
+        readoutROICore<SMH1_ADCTYPE_MCP3201,0>(scan,anain);
+      break;
+    case SMH1_ADCTYPE_MCP3201_2:
+      if (useAmp)
+        readoutROICore<SMH1_ADCTYPE_MCP3201_2,1>(scan,anain);
+      else
+        readoutROICore<SMH1_ADCTYPE_MCP3201_2,0>(scan,anain);
+      break;
+    case SMH1_ADCTYPE_ONBOARD_FAST:
+      if (useAmp)
+        readoutROICore<SMH1_ADCTYPE_ONBOARD_FAST,1>(scan,anain);
+      else
+        readoutROICore<SMH1_ADCTYPE_ONBOARD_FAST,0>(scan,anain);
+      break;
+    case SMH1_ADCTYPE_ONBOARD_FAST8:
+      if (useAmp)
+        readoutROICore<SMH1_ADCTYPE_ONBOARD_FAST8,1>(scan,anain);
+      else
+        readoutROICore<SMH1_ADCTYPE_ONBOARD_FAST8,0>(scan,anain);
+      break;
+    default:
+      break;
+  }
+
+  deselectADC(ADCType,anain);
+}
+
+/*********************************************************************/
+//	getPixels
+//	Acquires an arbitrary list of pixels, e.g. feature points for 
+//	sparse tracking, instead of a dense box.  The list is sorted by
+//	row then column into "order" (a shell sort of indices, the list
+//	itself is not modified), so the row and column registers are
+//	only moved forward except for one column reset per row visited.
+//	Reading N pixels costs N samples plus the pulses between them
+//	rather than a scan of the bounding box.
+//
+//	VARIABLES: 
+//	pixels: list of n chip addresses (row,col), duplicates allowed
+//	n: number of pixels
+//	out (output): n values, out[i] is the value of pixels[i]
+//	order: scratch array of n shorts, holds the scan order on return
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getPixels(const SMHPixel *pixels, short n, short *out, short *order, char ADCType, char anain)
+{
+  short i,j,gap,k;
+  unsigned short key;
+
+  // sort indices by (row,col)
+  for (i=0; i<n; ++i)
+    order[i]=i;
+  for (gap=n/2; gap>0; gap/=2)
+    for (i=gap; i<n; ++i)
+    {
+      k=order[i];
+      key=((unsigned short)pixels[k].row<<8)|pixels[k].col;
+      for (j=i; j>=gap; j-=gap)
+      {
+        short m=order[j-gap];
+        if ((((unsigned short)pixels[m].row<<8)|pixels[m].col)<=key)
+          break;
+        order[j]=m;
+      }
+      order[j]=k;
+    }
+
+  selectADC(ADCType,anain);
+
+  switch (ADCType) 
+  {
+    case SMH1_ADCTYPE_ONBOARD:
+      if (useAmp)
+        readoutPixelCore<SMH1_ADCTYPE_ONBOARD,1>(pixels,order,n,out,anain);
+      else
+        readoutPixelCore<SMH1_ADCTYPE_ONBOARD,0>(pixels,order,n,out,anain);
+      break;
+    case SMH1_ADCTYPE_MCP3001:
+      if (useAmp)
+        readoutPixelCore<SMH1_ADCTYPE_MCP3001,1>(pixels,order,n,out,anain);
+      else
+        readoutPixelCore<SMH1_ADCTYPE_MCP3001,0>(pixels,order,n,out,anain);
+      break;
+    case SMH1_ADCTYPE_MCP3201:
+      if (useAmp)
+        readoutPixelCore<SMH1_ADCTYPE_MCP3201,1>(pixels,order,n,out,anain);
+      else
+        readoutPixelCore<SMH1_ADCTYPE_MCP3201,0>(pixels,order,n,out,anain);
+      break;
+    case SMH1_ADCTYPE_MCP3201_2:
+      if (useAmp)
+        readoutPixelCore<SMH1_ADCTYPE_MCP3201_2,1>(pixels,order,n,out,anain);
+      else
+        readoutPixelCore<SMH1_ADCTYPE_MCP3201_2,0>(pixels,order,n,out,anain);
+      break;
+    case SMH1_ADCTYPE_ONBOARD_FAST:
+      if (useAmp)
+        readoutPixelCore<SMH1_ADCTYPE_ONBOARD_FAST,1>(pixels,order,n,out,anain);
+      else
+        readoutPixelCore<SMH1_ADCTYPE_ONBOARD_FAST,0>(pixels,order,n,out,anain);
+      break;
+    case SMH1_ADCTYPE_ONBOARD_FAST8:
+      if (useAmp)
+        readoutPixelCore<SMH1_ADCTYPE_ONBOARD_FAST8,1>(pixels,order,n,out,anain);
+      else
+        readoutPixelCore<SMH1_ADCTYPE_ONBOARD_FAST8,0>(pixels,order,n,out,anain);
+      break;
+    default:
+      break;
+  }
+
+  deselectADC(ADCType,anain);
+}
+
+/*********************************************************************/
+//	getImage (8 bit)
+//	Same as getImage but stores 8 bit pixels, half the memory of a 
+//	short image, for the char kernels of ArduEye_OFO.  Each pixel is
+//	(ADC value-offset)>>shift clamped to -128..127 for char or 0..255
+//	for unsigned char.  E.g. with the 10 bit onboard ADC, offset 0 and
+//	shift 2 keep the full range, while offset=mask_base from calcMask
+//	and shift 0 or 1 keep the low contrast detail of a typical scene.
+//	With SMH1_ADCTYPE_ONBOARD_FAST8 the value is already 8 bits, use
+//	shift 0.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getImage(char *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, short offset, unsigned char shift) 
+{
+  PROF_SCOPE(PROF_ACQUIRE);
+  SMHStore8Sink<char> sink(img,offset,shift);
+
+  readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+}
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getImage(unsigned char *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, short offset, unsigned char shift) 
+{
+  PROF_SCOPE(PROF_ACQUIRE);
+  SMHStore8Sink<unsigned char> sink(img,offset,shift);
+
+  readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+}
+
+/*********************************************************************/
+//	getImage (frame)
+//	Acquires into a CYE_Frame.  The number of rows and columns and the
+//	pixel format come from the frame, so they cannot mismatch the 
+//	buffer.  8 bit frames store (ADC value-offset)>>frame->shift as the
+//	8 bit getImage.  Packed frames (CYE_FRAME_PACK10/12) store the ADC
+//	value>>frame->shift packed as it is read, e.g. a 12 bit MCP3201 
+//	into a PACK10 frame with shift 2; a 10 bit 40x40 frame takes 2000
+//	bytes instead of 3200.  The frame gets the acquisition time (micros()) 
+//	and a sequence number that counts up with every frame.
+//
+//	EXAMPLE:
+//	short buf[64]; CYE_Frame f;
+//	CYE_FrameInit(&f,buf,8,8,CYE_FRAME_SHORT);
+//	getImage(&f,16,1,24,1,SMH1_ADCTYPE_ONBOARD,0): 
+//	Grab an 8x8 window starting at row 16, column 24 into f
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getImage(CYE_Frame *frame, unsigned char rowstart, unsigned char rowskip, unsigned char colstart, unsigned char colskip, char ADCType, char anain, short offset) 
+{
+  switch (frame->format)
+  {
+    case CYE_FRAME_CHAR:
+      getImage((char *)frame->pixels,rowstart,frame->rows,rowskip,colstart,frame->cols,colskip,ADCType,anain,offset,frame->shift);
+      break;
+    case CYE_FRAME_UCHAR:
+      getImage((unsigned char *)frame->pixels,rowstart,frame->rows,rowskip,colstart,frame->cols,colskip,ADCType,anain,offset,frame->shift);
+      break;
+    case CYE_FRAME_PACK10:
+      {
+        PROF_SCOPE(PROF_ACQUIRE);
+        SMHStorePackSink<10> sink((unsigned char *)frame->pixels,frame->shift);
+        readout(sink,rowstart,frame->rows,rowskip,colstart,frame->cols,colskip,ADCType,anain);
+      }
+      break;
+    case CYE_FRAME_PACK12:
+      {
+        PROF_SCOPE(PROF_ACQUIRE);
+        SMHStorePackSink<12> sink((unsigned char *)frame->pixels,frame->shift);
+        readout(sink,rowstart,frame->rows,rowskip,colstart,frame->cols,colskip,ADCType,anain);
+      }
+      break;
+    default:
+      getImage((short *)frame->pixels,rowstart,frame->rows,rowskip,colstart,frame->cols,colskip,ADCType,anain);
+      break;
+  }
+
+  frame->timestamp=micros();
+  frame->seq=frameSeq++;
+}
+
+/*********************************************************************/
+//	getImage (FPN)
+//	Acquires the window of "fpn" with the fixed pattern noise removed
+//	as each pixel is read, so there is no second pass over the image 
+//	as with applyMask.  Each pixel is offset-value (negated like 
+//	applyMask, bright is high), times the gain if fpn has one.  The 
+//	frame version needs a CYE_FRAME_SHORT frame of the window size.  
+//	It returns 1, or 0 without acquiring if the frame does not match,
+//	leaving its pixels, seq and timestamp as they were.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getImage(short *img, const SMHFPN *fpn, char ADCType, char anain)
+{
+  PROF_SCOPE(PROF_ACQUIRE);
+  SMHFPNSink sink(img,fpn);
+
+  readout(sink,fpn->rowstart,fpn->numrows,fpn->rowskip,fpn->colstart,fpn->numcols,fpn->colskip,ADCType,anain);
+}
+
+template<class Pins>
+char ArduEyeSMHChip<Pins>::getImage(CYE_Frame *frame, const SMHFPN *fpn, char ADCType, char anain)
+{
+  if (frame->format!=CYE_FRAME_SHORT || frame->rows!=fpn->numrows || frame->cols!=fpn->numcols)
+    return 0;
+
+  getImage((short *)frame->pixels,fpn,ADCType,anain);
+
+  frame->timestamp=micros();
+  frame->seq=frameSeq++;
+  return 1;
+}
+
+/*********************************************************************/
+//	getImageRowSum
+//	This function acquires a box section of a Stonyman or Hawksbill 
+//	and saves to image array img.  However, each row of the image
+//	is summed and returned as a single value (the sum divided by 16,
+//	saturated).  For both projections use getImageProjections.
+//	Note that images are read out in 
+//	raster manner (e.g. row wise) and stored as such in a 1D array. 
+//	In this case the pointer img points to the output array. 
+//
+//	VARIABLES: 
+//	img (output): pointer to image array, an array of signed shorts
+//	rowstart: first row to acquire
+//	numrows: number of rows to acquire
+//	rowskip: skipping between rows (useful if binning is used)
+//	colstart: first column to acquire
+//	numcols: number of columns to acquire
+//	colskip: skipping between columns
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//	
+//	EXAMPLES:
+//	getImage(img,16,8,1,24,8,1,SMH1_ADCTYPE_ONBOARD,0): 
+//	Grab an 8x8 window of pixels at raw resolution starting at row 
+//	16, column 24, from chip using onboard ADC at input 0
+//	getImage(img,0,14,8,0,14,8,SMH1_ADCTYPE_MCP3201,2): 
+//	Grab entire Stonyman chip when using
+//	8x8 binning. Grab from input 2.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getImageRowSum(short *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType,char anain) 
+{
+  SMHRowSumSink sink(img);
+
+  readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+}
+
+/*********************************************************************/
+//	getImageColSum
+//	This function acquires a box section of a Stonyman or Hawksbill 
+//	and saves to image array img.  However, each col of the image
+//	is summed and returned as a single value (the sum divided by 16,
+//	saturated).
+//	Note that images are read out in 
+//	raster manner (e.g. row wise) and stored as such in a 1D array. 
+//	In this case the pointer img points to the output array. 
+//
+//	VARIABLES: 
+//	img (output): pointer to image array, an array of signed shorts
+//	rowstart: first row to acquire
+//	numrows: number of rows to acquire
+//	rowskip: skipping between rows (useful if binning is used)
+//	colstart: first column to acquire
+//	numcols: number of columns to acquire
+//	colskip: skipping between columns
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//	
+//	EXAMPLES:
+//	getImage(img,16,8,1,24,8,1,SMH1_ADCTYPE_ONBOARD,0): 
+//	Grab an 8x8 window of pixels at raw resolution starting at row 
+//	16, column 24, from chip using onboard ADC at input 0
+//	getImage(img,0,14,8,0,14,8,SMH1_ADCTYPE_MCP3201,2): 
+//	Grab entire Stonyman chip when using
+//	8x8 binning. Grab from input 2.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getImageColSum(short *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType,char anain) 
+{
+  SMHColSumSink sink(img);
+
+  readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+}
+
+/*********************************************************************/
+//	getImageProjections
+//	Acquires a box section once and computes both the row projection
+//	(one value per row) and the column projection (one value per 
+//	column), instead of a getImageRowSum and a getImageColSum that 
+//	each scan the window.  Sums are kept in longs, so no window 
+//	overflows, and are normalized at the end: SMH_PROJ_MEAN gives the
+//	mean of each row/column, which keeps the pixel scale and suits
+//	IIA_1D; norm>=0 gives sum>>norm.  The image itself can be stored 
+//	in the same pass.
+//
+//	VARIABLES: 
+//	rowproj (output): numrows shorts, or NULL
+//	colproj (output): numcols shorts, or NULL
+//	colacc: numcols longs of scratch for the column sums, may be NULL
+//	if colproj is NULL
+//	img (output): numrows*numcols shorts as getImage, or NULL
+//	rowstart,numrows,rowskip,colstart,numcols,colskip: window, as 
+//	getImage
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//	norm: SMH_PROJ_MEAN, or right shift of the sums (0 for raw sums,
+//	saturated to a short)
+//
+//	EXAMPLE:
+//	getImageProjections(rp,cp,acc,NULL,0,16,7,0,16,7,
+//	SMH1_ADCTYPE_ONBOARD,0,SMH_PROJ_MEAN): mean rows and columns of
+//	a 16x16 grid over the Stonyman, ready for IIA_1D on each axis
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getImageProjections(short *rowproj, short *colproj, long *colacc, short *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, char norm)
+{
+  PROF_SCOPE(PROF_ACQUIRE);
+  SMHProjSink sink(rowproj,colproj ? colacc : 0,img,numcols,norm);
+
+  readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+  sink.finish(colproj);
+}
+
+
+/*********************************************************************/
+//	findMax
+//	Searches over a block section of a Stonyman or Hawksbill chip
+//	to find the brightest pixel. This function is intended to be used 
+//	for things like finding the location of a pinhole in response to 
+//	a bright light.
+//
+//	VARIABLES: 
+//	rowstart: first row to search
+//	numrows: number of rows to search
+//	rowskip: skipping between rows (useful if binning is used)
+//	colstart: first column to search
+//	numcols: number of columns to search
+//	colskip: skipping between columns
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//	rowwinner: (output) pointer to variable to write row of brightest 
+//	pixel
+//	colwinner: (output) pointer to variable to write column of 
+//	brightest pixel
+//
+//	EXAMPLE:
+//	FindMaxSlow(8,104,1,8,104,1,SMH1_ADCTYPE_ONBOARD,0,&rowwinner,
+//	&colwinner): 
+//	Search rows 8...104 and columns 8...104 for brightest pixel, with 
+//	onboard ADC, chip 0
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::findMax(unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols,unsigned char colskip, char ADCType,char anain,unsigned char *max_row, unsigned char *max_col)
+{
+  SMHMaxSink sink(useAmp);
+
+  readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+
+  *max_row = sink.bestrow;
+  *max_col = sink.bestcol;
+}
+
+/*********************************************************************/
+//	findMaxCoarseToFine
+//	Faster findMax for locating a bright point such as a beacon or
+//	the pinhole of a pinhole camera.  The search window is first 
+//	scanned on a coarse grid with setBinning(bin,bin), one sample per
+//	super pixel.  Binning is then restored to what it was (from the
+//	HSW/VSW shadows, no binning if unknown) and only the winning 
+//	super pixel plus a margin of bin/2 pixels on each side is scanned
+//	at full resolution.  For the whole Stonyman with bin=8 that is
+//	196+256 samples instead of 12544.
+//
+//	The fine pass also computes the intensity weighted centroid of 
+//	the pixels brighter than the mean of the coarse pass, in Q8 (chip
+//	coordinate * 256).  If no pixel is brighter the centroid is the 
+//	brightest pixel.
+//
+//	VARIABLES: 
+//	rowstart,numrows,colstart,numcols: search window, in pixels
+//	bin: 2, 4 or 8, coarse binning (super pixels are aligned with the
+//	top left of the chip as in setBinning)
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//	max_row, max_col (output): brightest pixel, in chip coordinates 
+//	(unlike findMax which returns indices within the window)
+//	row_q8, col_q8 (output): centroid in Q8 chip coordinates, may be
+//	NULL if not needed
+//
+//	EXAMPLE:
+//	findMaxCoarseToFine(0,112,0,112,8,SMH1_ADCTYPE_ONBOARD,0,
+//	&row,&col,&rowq8,&colq8): 
+//	Locate the brightest point on a Stonyman, rowq8/256.0 is the 
+//	sub-pixel row
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::findMaxCoarseToFine(unsigned char rowstart, unsigned char numrows, unsigned char colstart, unsigned char numcols, char bin, char ADCType, char anain, unsigned char *max_row, unsigned char *max_col, unsigned short *row_q8, unsigned short *col_q8)
+{
+  short hsw=regShadow[SMH_SYS_HSW];	//binning to restore
+  short vsw=regShadow[SMH_SYS_VSW];
+  unsigned char crow,ccol,ncrows,nccols;
+  unsigned char frow,fcol,nfrows,nfcols;
+  unsigned char rowend=rowstart+numrows;
+  unsigned char colend=colstart+numcols;
+  short bg;
+
+  if ((bin!=2)&&(bin!=4)&&(bin!=8))
+    bin=8;
+
+  // coarse pass: one sample per super pixel overlapping the window
+  crow=rowstart&~(bin-1);
+  ccol=colstart&~(bin-1);
+  ncrows=(rowend-crow+bin-1)/bin;
+  nccols=(colend-ccol+bin-1)/bin;
+
+  setBinning(bin,bin);
+  SMHMeanMaxSink coarse(useAmp);
+  readout(coarse,crow,ncrows,bin,ccol,nccols,bin,ADCType,anain);
+  bg=coarse.count ? coarse.sum/coarse.count : 0;
+
+  // restore binning
+  setSwitches((hsw==SMH_SHADOW_UNKNOWN)?0:hsw,(vsw==SMH_SHADOW_UNKNOWN)?0:vsw);
+
+  // fine pass: winning super pixel and bin/2 around it, clipped to
+  // the search window
+  crow+=coarse.bestrow*bin;
+  ccol+=coarse.bestcol*bin;
+  frow=(crow>rowstart+bin/2)?crow-bin/2:rowstart;
+  fcol=(ccol>colstart+bin/2)?ccol-bin/2:colstart;
+  nfrows=((crow+bin+bin/2<rowend)?crow+bin+bin/2:rowend)-frow;
+  nfcols=((ccol+bin+bin/2<colend)?ccol+bin+bin/2:colend)-fcol;
+
+  SMHCentroidSink fine(useAmp,bg);
+  readout(fine,frow,nfrows,1,fcol,nfcols,1,ADCType,anain);
+
+  *max_row=frow+fine.bestrow;
+  *max_col=fcol+fine.bestcol;
+
+  if (row_q8&&col_q8)
+  {
+    if (fine.sumw>0)
+    {
+      *row_q8=smhDivQ8(fine.sumwr,fine.sumw);
+      *col_q8=smhDivQ8(fine.sumwc,fine.sumw);
+      *row_q8+=(unsigned short)frow<<8;
+      *col_q8+=(unsigned short)fcol<<8;
+    }
+    else
+    {
+      *row_q8=(unsigned short)(*max_row)<<8;
+      *col_q8=(unsigned short)(*max_col)<<8;
+    }
+  }
+}
+
+/*********************************************************************/
+//	findPeaks
+//	Finds up to k bright, separated peaks, e.g. several beacons, in 
+//	one readout without a frame buffer (see SMHPeakSink).  Pixels 
+//	brighter than "threshold" within minsep of each other belong to
+//	the same peak.  Peaks are returned brightest first with their 
+//	brightest pixel and intensity weighted centroid.
+//
+//	VARIABLES: 
+//	rowstart..colskip: search window, as getImage
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//	threshold: raw ADC value, pixels brighter than it are considered
+//	(below it without the amplifier, above it with, see findMax)
+//	minsep: minimum separation of peaks, in window indices
+//	peaks (output): array of k peaks, positions in chip coordinates
+//	k: maximum number of peaks
+//	returns the number of peaks found
+//
+//	EXAMPLE:
+//	SMHPeak peaks[4];
+//	n=findPeaks(0,56,2,0,56,2,SMH1_ADCTYPE_ONBOARD,0,400,3,peaks,4):
+//	Find up to 4 beacons on a Stonyman read at half resolution
+/*********************************************************************/
+
+template<class Pins>
+unsigned char ArduEyeSMHChip<Pins>::findPeaks(unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, short threshold, unsigned char minsep, SMHPeak *peaks, unsigned char k)
+{
+  SMHPeakSink sink(useAmp,threshold,minsep,peaks,k);
+
+  readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+
+  return sink.finish(rowstart,rowskip,colstart,colskip);
+}
+
+/*********************************************************************/
+//	findPeaks (recorded image)
+//	Same peak detector run over a stored numrows x numcols image, 
+//	e.g. frames recorded from the chip or processed on a host.  Set
+//	brighthigh to 1 if bright pixels have high values (amplifier on,
+//	or after applyMask), 0 for raw unamplified images.  Positions are
+//	image indices.
+/*********************************************************************/
+
+template<class Pins>
+unsigned char ArduEyeSMHChip<Pins>::findPeaks(const short *img, unsigned char numrows, unsigned char numcols, char brighthigh, short threshold, unsigned char minsep, SMHPeak *peaks, unsigned char k)
+{
+  SMHPeakSink sink(brighthigh,threshold,minsep,peaks,k);
+  unsigned char row,col;
+
+  for (row=0; row<numrows; ++row)
+    for (col=0; col<numcols; ++col)
+      sink.pixel(row,col,*img++);
+
+  return sink.finish(0,1,0,1);
+}
+
+/*********************************************************************/
+//	chipToMatlab
+//	This function dumps the entire contents of a Stonyman or 
+//	Hawksbill chip to the Serial monitor in a form that may be copied 
+//	into Matlab. The image is written be stored in matrix Img. 
+//
+//	VARIABLES: 
+//	whichchip(0 or 1): 0 for Stonyman, 1 for Hawksbill
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): Selects one analog input
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::chipToMatlab(char whichchip,char ADCType, char anain) 
+{
+  unsigned char rows,cols;
+  SMHPrintSink sink;
+
+  if (whichchip==1) {
+	  rows=cols=136;	//hawksbill
+  }	else {
+	  rows=cols=112;	//stonyman
+  }	
+  
+  Serial.println("Img = [");
+  readout(sink,0,rows,1,0,cols,1,ADCType,anain);
+  Serial.println("];");
+}
+
+/*********************************************************************/
+//	sectionToMatlab
+//	This function dumps a box section of a Stonyman or Hawksbill 
+//	to the Serial monitor in a form that may be copied into Matlab. 
+//	The image is written to be stored in matrix Img. 
+//
+//	VARIABLES: 
+//	rowstart: first row to acquire
+//	numrows: number of rows to acquire
+//	rowskip: skipping between rows (useful if binning is used)
+//	colstart: first column to acquire
+//	numcols: number of columns to acquire
+//	colskip: skipping between columns
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//
+//	EXAMPLES:
+//	sectionToMatlab(16,8,1,24,8,1,SMH1_ADCTYPE_ONBOARD,0): 
+//	Grab an 8x8 window of pixels at raw resolution starting at row 
+//	16, column 24, from onboard ADC at chip 0
+//	sectionToMatlab(0,14,8,0,14,8,SMH1_ADCTYPE_ONBOARD,2): 
+//	Grab entire Stonyman chip when using 8x8 binning. Grab from input 
+//	2.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::sectionToMatlab(unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, unsigned char anain) 
+{
+  SMHPrintSink sink;
+
+  Serial.println("Img = [");
+  readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+  Serial.println("];");
+}
+
+/*********************************************************************/
+//	chipToBinary
+//	Dumps the entire contents of a Stonyman or Hawksbill chip over 
+//	serial as one packed binary frame (see SMH_DUMP_SYNC0 in 
+//	ArduEye_SMH.h): 12 bits per pixel for the MCP3201, 10 bits for
+//	the other ADCs.  A 112x112 dump is 15692 bytes against about 5 
+//	characters per pixel for chipToMatlab.  Decode the capture with
+//	host/ArduEye_DumpDecode.cpp.
+//
+//	VARIABLES: 
+//	whichchip(0 or 1): 0 for Stonyman, 1 for Hawksbill
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): Selects one analog input
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::chipToBinary(char whichchip,char ADCType, char anain) 
+{
+  unsigned char size=(whichchip==1) ? 136 : 112;
+
+  sectionToBinary(0,size,1,0,size,1,ADCType,anain);
+}
+
+/*********************************************************************/
+//	sectionToBinary
+//	Dumps a box section of a Stonyman or Hawksbill over serial as 
+//	one packed binary frame, as chipToBinary.  The header records
+//	the window, so binned and skipped sections decode with their
+//	chip coordinates.
+//
+//	VARIABLES: 
+//	rowstart,numrows,rowskip,colstart,numcols,colskip: window to 
+//	read, as in sectionToMatlab
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::sectionToBinary(unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain) 
+{
+  if ((ADCType==SMH1_ADCTYPE_MCP3201)||(ADCType==SMH1_ADCTYPE_MCP3201_2))
+  {
+    SMHPackSink<12> sink;
+    sink.header(ADCType,numrows,numcols,rowstart,colstart,rowskip,colskip);
+    readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+    sink.finish();
+  }
+  else
+  {
+    SMHPackSink<10> sink;
+    sink.header(ADCType,numrows,numcols,rowstart,colstart,rowskip,colskip);
+    readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+    sink.finish();
+  }
+}
+
+/*********************************************************************/
+/*********************************************************************/
+//	Background acquisition
+//	The chip is read pixel by pixel from the onboard ADC conversion 
+//	complete interrupt: each interrupt stores the finished pixel,
+//	moves the chip to the next pixel and starts its conversion.  The
+//	conversion time (13 ADC clocks) is free for the sketch, which can
+//	compute optical flow on frame N while frame N+1 is acquired.
+//
+//	Completed frames are handed over through a lock-free triple 
+//	buffer: the interrupt owns one slot (back), the sketch one 
+//	(front), and the third (middle) is exchanged atomically.  The 
+//	interrupt never waits, if the sketch is slow it gets the newest
+//	frame and older ones are dropped.
+//
+//	While running, the background readout owns the chip: the sketch
+//	must not call other acquisition or register functions.
+/*********************************************************************/
+/*********************************************************************/
+
+/*********************************************************************/
+//	smhExchange
+//	Atomically replaces *p with v and returns the old value.  On AVR
+//	a byte access is atomic and only the consumer side needs the
+//	interrupts held off; on a host the compiler builtin is used.
+/*********************************************************************/
+
+static inline unsigned char smhExchange(volatile unsigned char *p, unsigned char v)
+{
+#if defined(SMH_BG_THREAD)
+  return __atomic_exchange_n(p,v,__ATOMIC_ACQ_REL);
+#else
+  unsigned char old,sreg=SREG;
+
+  cli();
+  old=*p;
+  *p=v;
+  SREG=sreg;
+  return old;
+#endif
+}
+
+/*********************************************************************/
+//	startBackground
+//	Starts acquiring frames in the background with the onboard ADC
+//	(at the prescaler set by setADCPrescaler and the timing profile
+//	of SMH1_ADCTYPE_ONBOARD_FAST).  On AVR the sketch must hand the
+//	ADC interrupt to backgroundStep (see SMH_BG_ISR).
+//
+//	VARIABLES: 
+//	frames: array of SMH_BG_SLOTS short frames of the same size, set
+//	up with CYE_FrameInit; their size gives the window size
+//	rowstart,rowskip,colstart,colskip: window, as getImage
+//	anain (0,1,2,3): which analog input to use
+//	returns 1 if started, 0 if not supported on this board
+//
+//	EXAMPLE:
+//	startBackground(frames,16,8,16,8,0);
+//	loop: f=getBackgroundFrame(); if (f) { flow on f and last }
+/*********************************************************************/
+
+template<class Pins>
+char ArduEyeSMHChip<Pins>::startBackground(CYE_Frame *frames, unsigned char rowstart, unsigned char rowskip, unsigned char colstart, unsigned char colskip, char anain)
+{
+#if defined(SMH_BG_ISR) || defined(SMH_BG_THREAD)
+  const SMHTiming tm=timing[SMH1_ADCTYPE_ONBOARD_FAST];
+  unsigned char us=F_CPU/1000000L;		//cycles per microsecond
+  unsigned short conv=13<<adcPrescalerBits;	//cycles per conversion
+  short lead=(3<<adcPrescalerBits)/2;	//sample taken 1.5 ADC clocks in
+
+  if (bgRunning)
+    stopBackground();
+
+  bgFrames=frames;
+  bgBack=0;
+  bgMiddle=1;
+  bgFront=2;
+  bgRowstart=rowstart;
+  bgRowskip=rowskip;
+  bgColstart=colstart;
+  bgColskip=colskip;
+  bgAnain=anain;
+
+  // the delays of the profile in dropped conversions, the sample/hold
+  // lead of the converting one counts towards the last
+  bgSettle1=(tm.settle1*us+conv-1)/conv;
+  bgInphi=useAmp ? (tm.inphi*us+conv-1)/conv : 0;
+  bgSettle2=(tm.settle2*us>lead) ? (tm.settle2*us-lead+conv-1)/conv : 0;
+
+  // first pixel, addressed here rather than in the interrupt
+  setAnalogInput(anain);
+  setPointerValue(SMH_SYS_ROWSEL,rowstart);
+  setPointerValue(SMH_SYS_COLSEL,colstart);
+  bgRow=0;
+  bgCol=0;
+  bgIndex=0;
+  bgState=SMH_BG_SETTLE1;
+  bgWait=bgSettle1;
+  bgAdvance();
+  bgRunning=1;
+
+#if defined(SMH_BG_ISR)
+  // single conversions with interrupt, AVcc reference as analogRead
+  adcSaveSRA = ADCSRA;
+  adcSaveSRB = ADCSRB;
+  adcSaveMUX = ADMUX;
+  ADMUX = _BV(REFS0) | (anain & 0x07);
+  ADCSRA = _BV(ADEN) | _BV(ADIE) | _BV(ADIF) | adcPrescalerBits;
+  bgConvert();
+#else
+  pthread_create(&bgThread,0,bgThreadMain,this);
+#endif
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/*********************************************************************/
+//	stopBackground
+//	Stops background acquisition after the current step and gives 
+//	the ADC back as startBackground found it
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::stopBackground(void)
+{
+  if (!bgRunning)
+    return;
+
+  bgRunning=0;
+#if defined(SMH_BG_ISR)
+  while (ADCSRA & _BV(ADSC))	// let the last conversion finish
+    ;
+  ADMUX = adcSaveMUX;
+  ADCSRB = adcSaveSRB;
+  ADCSRA = (adcSaveSRA & ~_BV(ADSC)) | _BV(ADIF);	// flag cleared
+#elif defined(SMH_BG_THREAD)
+  pthread_join(bgThread,0);
+#endif
+  Pins::INPHI::low();	// stopped during an amplifier pulse
+}
+
+/*********************************************************************/
+//	getBackgroundFrame
+//	Returns the newest frame completed since the last call, or NULL.
+//	The frame belongs to the sketch until the next call, the 
+//	previously returned frame is given back to the readout.
+/*********************************************************************/
+
+template<class Pins>
+CYE_Frame *ArduEyeSMHChip<Pins>::getBackgroundFrame(void)
+{
+  if (!(bgMiddle & SMH_BG_FRESH))
+    return 0;
+
+  bgFront=smhExchange(&bgMiddle,bgFront) & ~SMH_BG_FRESH;
+  return &bgFrames[bgFront];
+}
+
+/*********************************************************************/
+//	bgConvert
+//	Starts a conversion: of the addressed pixel in SMH_BG_SAMPLE,
+//	otherwise one whose result is dropped and which only times the
+//	next step
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::bgConvert(void)
+{
+#if defined(SMH_BG_ISR)
+  ADCSRA |= _BV(ADSC);
+#endif
+}
+
+/*********************************************************************/
+//	backgroundStep
+//	Background state machine, run once per conversion.  After the 
+//	conversion of a pixel it stores it and sets up the move to the
+//	next pixel: the next column, the next row or, after the last 
+//	pixel, the first pixel of the next frame once this one is 
+//	published.  bgAdvance then does the move a step at a time.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::backgroundStep(void)
+{
+  CYE_Frame *f=&bgFrames[bgBack];
+
+  if (bgState==SMH_BG_SAMPLE)
+  {
+    ((short *)f->pixels)[bgIndex++]=SMHADC_Free<0>::single(bgAnain);
+
+    if (++bgCol < f->cols)
+    {
+      // next column
+      bgPulses=bgColskip;
+      bgState=SMH_BG_COLUMN;
+    }
+    else
+    {
+      bgCol=0;
+      setPointer(SMH_SYS_ROWSEL);
+      if (++bgRow < f->rows)
+        bgPulses=bgRowskip;	// next row
+      else
+      {
+        // frame done: publish it and continue in the returned slot
+        f->timestamp=micros();
+        f->seq=frameSeq++;
+        bgBack=smhExchange(&bgMiddle,bgBack|SMH_BG_FRESH) & ~SMH_BG_FRESH;
+        bgRow=0;
+        bgIndex=0;
+        setValue(0);
+        bgPulses=bgRowstart;
+      }
+      bgState=SMH_BG_ROW;
+    }
+  }
+
+  bgAdvance();
+  if (bgRunning)
+    bgConvert();
+}
+
+/*********************************************************************/
+//	bgAdvance
+//	Runs the background states until a conversion is needed.  Each
+//	step sends at most SMH_BG_PULSES INCV pulses (the row, then the
+//	column register) and waits for settling with dropped conversions
+//	instead of delays, so the interrupt stays short however far the
+//	pointer moves.  Ends in SMH_BG_SAMPLE once the pixel has settled.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::bgAdvance(void)
+{
+  unsigned char n,k;
+
+  while (bgState!=SMH_BG_SAMPLE)
+  {
+    if (bgWait)
+    {
+      bgWait--;
+      return;
+    }
+
+    switch (bgState)
+    {
+      case SMH_BG_ROW:
+      case SMH_BG_COLUMN:
+        n=(bgPulses<SMH_BG_PULSES) ? bgPulses : SMH_BG_PULSES;
+        for (k=0; k<n; ++k)
+          Pins::INCV::pulse();
+        shadowIncrement(n);
+        bgPulses-=n;
+        if (bgPulses)
+          bgWait=1;	// the rest in the next step
+        else if (bgState==SMH_BG_ROW)
+        {
+          // row reached, back to the first column
+          setPointer(SMH_SYS_COLSEL);
+          setValue(0);
+          bgPulses=bgColstart;
+          bgState=SMH_BG_COLUMN;
+          bgWait=1;
+        }
+        else
+        {
+          bgState=SMH_BG_SETTLE1;
+          bgWait=bgSettle1;
+        }
+        break;
+
+      case SMH_BG_SETTLE1:
+        if (useAmp)
+        {
+          Pins::INPHI::high();
+          bgState=SMH_BG_INPHI;
+          bgWait=bgInphi;
+        }
+        else
+        {
+          bgState=SMH_BG_SETTLE2;
+          bgWait=bgSettle2;
+        }
+        break;
+
+      case SMH_BG_INPHI:
+        Pins::INPHI::low();
+        bgState=SMH_BG_SETTLE2;
+        bgWait=bgSettle2;
+        break;
+
+      default:	// SMH_BG_SETTLE2: settled
+        bgState=SMH_BG_SAMPLE;
+        break;
+    }
+  }
+}
+
+#if defined(SMH_BG_THREAD)
+/*********************************************************************/
+//	bgThreadMain
+//	Host build: a thread stands in for the interrupt and steps the
+//	state machine until stopBackground
+/*********************************************************************/
+
+template<class Pins>
+void *ArduEyeSMHChip<Pins>::bgThreadMain(void *arg)
+{
+  ArduEyeSMHChip<Pins> *smh=(ArduEyeSMHChip<Pins> *)arg;
+
+  while (__atomic_load_n(&smh->bgRunning,__ATOMIC_ACQUIRE))
+    smh->backgroundStep();
+  return 0;
+}
+#endif
+
+/*********************************************************************/
+/*********************************************************************/
+//	Auto exposure
+//	Keeps the pixel values within the ADC range as the light changes.
+//	Each step reads a cheap binned pre-frame into a histogram and 
+//	looks at the range between two percentiles of it:
+//	- if the range is off center (or piles up in an end bin) VREF is
+//	  moved to recenter it, AOBIAS once VREF is at its limit
+//	- if the range is narrow the amplifier gain is raised, if it is 
+//	  wide or clipped at both ends the gain is lowered
+//	Hysteresis keeps the registers still on a steady scene: 
+//	recentering starts outside centerBand and stops at half of it,
+//	the gain has a dead band between spreadLow and spreadHigh and a
+//	change must be wanted for "hold" frames in a row.
+//
+//	How VREF and AOBIAS move the output depends on the chip and on
+//	the amplifier (which inverts it), so the direction of each is 
+//	learned: if a move shifts the image the wrong way, the direction
+//	is flipped.
+/*********************************************************************/
+/*********************************************************************/
+
+/*********************************************************************/
+//	smhHistShift
+//	Shift mapping an ADC value onto the SMH_AE_BINS histogram bins
+/*********************************************************************/
+
+static inline char smhHistShift(char ADCType)
+{
+  switch (ADCType) 
+  {
+    case SMH1_ADCTYPE_ONBOARD_FAST8:
+      return 3;		// 8 bit
+    case SMH1_ADCTYPE_MCP3201:
+    case SMH1_ADCTYPE_MCP3201_2:
+      return 7;		// 12 bit
+    default:
+      return 5;		// 10 bit
+  }
+}
+
+/*********************************************************************/
+//	getHistogram
+//	Reads a window of the chip with setBinning(bin,bin), one sample
+//	per super pixel, into a histogram.  Binning is restored 
+//	afterwards as in findMaxCoarseToFine.
+//
+//	VARIABLES: 
+//	hist (output): SMH_AE_BINS counts, bin i holds the values 
+//	i*range/SMH_AE_BINS up to the next bin
+//	rowstart,numrows,colstart,numcols: window, in pixels
+//	bin: 1, 2, 4 or 8, binning of the pre-frame
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::getHistogram(unsigned short *hist, unsigned char rowstart, unsigned char numrows, unsigned char colstart, unsigned char numcols, char bin, char ADCType, char anain)
+{
+  short hsw=regShadow[SMH_SYS_HSW];	//binning to restore
+  short vsw=regShadow[SMH_SYS_VSW];
+  unsigned char i;
+
+  if ((bin!=1)&&(bin!=2)&&(bin!=4)&&(bin!=8))
+    bin=8;
+
+  for (i=0; i<SMH_AE_BINS; ++i)
+    hist[i]=0;
+
+  // super pixels are aligned with the top left of the chip
+  rowstart&=~(bin-1);
+  colstart&=~(bin-1);
+
+  SMHHistSink sink(hist,smhHistShift(ADCType));
+
+  if (bin>1)
+    setBinning(bin,bin);
+  readout(sink,rowstart,(numrows+bin-1)/bin,bin,colstart,(numcols+bin-1)/bin,bin,ADCType,anain);
+
+  if (bin>1)
+  {
+    setSwitches((hsw==SMH_SHADOW_UNKNOWN)?0:hsw,(vsw==SMH_SHADOW_UNKNOWN)?0:vsw);
+  }
+}
+
+/*********************************************************************/
+//	autoExposureInit
+//	Sets the auto exposure loop up with default settings, starting 
+//	from the current VREF, AOBIAS and gain.  The settings may be 
+//	changed afterwards.
+/*********************************************************************/
+
+template<class Pins>
+void ArduEyeSMHChip<Pins>::autoExposureInit(SMHExposure *ae)
+{
+  short config=regShadow[SMH_SYS_CONFIG];
+
+  ae->lowPct=2;
+  ae->highPct=98;
+  ae->clipPct=5;
+  ae->spreadLow=SMH_AE_BINS*3/8;
+  ae->spreadHigh=SMH_AE_BINS*7/8;
+  ae->centerBand=3;
+  ae->hold=3;
+
+  ae->vref=(regShadow[SMH_SYS_VREF]==SMH_SHADOW_UNKNOWN)?SMH_VREF_5V0:regShadow[SMH_SYS_VREF];
+  ae->aobias=(regShadow[SMH_SYS_AOBIAS]==SMH_SHADOW_UNKNOWN)?SMH_AOBIAS_5V0:regShadow[SMH_SYS_AOBIAS];
+  ae->gain=(useAmp&&(config!=SMH_SHADOW_UNKNOWN))?(config&7):0;
+
+  ae->vrefDir=1;
+  ae->aobiasDir=1;
+  ae->lo=0;
+  ae->hi=SMH_AE_BINS-1;
+  ae->centering=0;
+  ae->want=0;
+  ae->wantCount=0;
+  ae->moved=0;
+  ae->movedBy=0;
+  ae->lastCenter=SMH_AE_BINS-1;
+}
+
+/*********************************************************************/
+//	autoExposureStep
+//	One step of the auto exposure loop on a histogram.  Only the 
+//	register values in ae are changed, the chip is not touched, so
+//	the loop can be run on recorded histograms.  At most one kind of
+//	change is made per step so the next histogram shows its effect.
+//
+//	VARIABLES: 
+//	ae: loop set up with autoExposureInit
+//	hist: SMH_AE_BINS counts (getHistogram)
+//	returns the SMH_AE_ values of the registers changed, 0 if none
+/*********************************************************************/
+
+template<class Pins>
+char ArduEyeSMHChip<Pins>::autoExposureStep(SMHExposure *ae, const unsigned short *hist)
+{
+  unsigned long total=0,cum=0,lowcount,highcount;
+  unsigned char i,center,spread;
+  char clipLow,clipHigh,found=0,stuck=0;
+  signed char wish;
+  short err,step,val;
+
+  for (i=0; i<SMH_AE_BINS; ++i)
+    total+=hist[i];
+  if (!total)
+    return 0;
+
+  // percentiles
+  lowcount=total*ae->lowPct/100;
+  highcount=total*ae->highPct/100;
+  ae->lo=0;
+  ae->hi=SMH_AE_BINS-1;
+  for (i=0; i<SMH_AE_BINS; ++i)
+  {
+    cum+=hist[i];
+    if (!found && cum>lowcount)
+    {
+      ae->lo=i;
+      found=1;
+    }
+    if (cum>=highcount)
+    {
+      ae->hi=i;
+      break;
+    }
+  }
+  if (ae->hi<ae->lo)
+    ae->hi=ae->lo;
+
+  center=ae->lo+ae->hi;		// in half bins
+  spread=ae->hi-ae->lo;
+  clipLow=(unsigned long)hist[0]*100>(unsigned long)ae->clipPct*total;
+  clipHigh=(unsigned long)hist[SMH_AE_BINS-1]*100>(unsigned long)ae->clipPct*total;
+
+  // learn the direction of the register moved in the last step
+  if (ae->moved)
+  {
+    err=(short)center-ae->lastCenter;
+    if ((err>=2 && ae->movedBy<0) || (err<=-2 && ae->movedBy>0))
+    {
+      if (ae->moved==SMH_AE_VREF)
+        ae->vrefDir=-ae->vrefDir;
+      else
+        ae->aobiasDir=-ae->aobiasDir;
+    }
+    ae->moved=0;
+  }
+
+  // offset: center the range, pushing out of a clipped end
+  err=(short)center-(SMH_AE_BINS-1);
+  if (clipLow && !clipHigh)
+    err=-SMH_AE_BINS;
+  else if (clipHigh && !clipLow)
+    err=SMH_AE_BINS;
+
+  if (!ae->centering && (err>2*ae->centerBand || err<-2*ae->centerBand))
+    ae->centering=1;
+  else if (ae->centering && err<=ae->centerBand && err>=-ae->centerBand)
+    ae->centering=0;
+
+  if (ae->centering)
+  {
+    step=((err<0)?-err:err)/2;
+    if (step<1)
+      step=1;
+    if (step>8)
+      step=8;
+    if (err>0)
+      step=-step;	// output must go down
+
+    ae->lastCenter=center;
+    val=ae->vref+step*ae->vrefDir;
+    if (val>=0 && val<=SMH_BIAS_MAX)
+    {
+      ae->vref=val;
+      ae->moved=SMH_AE_VREF;
+      ae->movedBy=step;
+      return SMH_AE_VREF;
+    }
+    val=ae->aobias+step*ae->aobiasDir;
+    if (val>=0 && val<=SMH_BIAS_MAX)
+    {
+      ae->aobias=val;
+      ae->moved=SMH_AE_AOBIAS;
+      ae->movedBy=step;
+      return SMH_AE_AOBIAS;
+    }
+    stuck=1;	// both at their limits, only the gain is left
+  }
+
+  // gain: fill the range without clipping
+  wish=0;
+  if ((clipLow && clipHigh) || spread>ae->spreadHigh || (stuck && (clipLow || clipHigh)))
+    wish=-1;
+  else if (spread<ae->spreadLow && !clipLow && !clipHigh)
+    wish=1;
+  if ((wish>0 && ae->gain>=SMH_GAIN_MAX) || (wish<0 && ae->gain==0))
+    wish=0;
+
+  if (!wish || wish!=ae->want)
+  {
+    ae->want=wish;
+    ae->wantCount=wish?1:0;
+  }
+  else
+    ae->wantCount++;
+
+  if (!wish || ae->wantCount<ae->hold)
+    return 0;
+
+  // the amplifier inverts the output, switching it flips the 
+  // direction of the offset registers
+  if ((ae->gain==0) != (ae->gain+wish==0))
+  {
+    ae->vrefDir=-ae->vrefDir;
+    ae->aobiasDir=-ae->aobiasDir;
+  }
+  ae->gain+=wish;
+  ae->want=0;
+  ae->wantCount=0;
+  return SMH_AE_GAIN;
+}
+
+/*********************************************************************/
+//	autoExposure
+//	One step of the auto exposure loop on the chip: reads a binned 
+//	histogram, runs autoExposureStep and writes the registers that
+//	changed.  Call it every frame (or every few frames), it costs one
+//	pre-frame of (numrows/bin)*(numcols/bin) pixels.
+//
+//	VARIABLES: 
+//	ae: loop set up with autoExposureInit
+//	rowstart,numrows,colstart,numcols,bin,ADCType,anain: pre-frame, 
+//	as getHistogram
+//	returns the SMH_AE_ values of the registers changed, 0 if none
+//
+//	EXAMPLE:
+//	autoExposureInit(&ae); then every frame
+//	autoExposure(&ae,0,112,0,112,8,SMH1_ADCTYPE_ONBOARD,0);
+/*********************************************************************/
+
+template<class Pins>
+char ArduEyeSMHChip<Pins>::autoExposure(SMHExposure *ae, unsigned char rowstart, unsigned char numrows, unsigned char colstart, unsigned char numcols, char bin, char ADCType, char anain)
+{
+  unsigned short hist[SMH_AE_BINS];
+  char changed;
+
+  getHistogram(hist,rowstart,numrows,colstart,numcols,bin,ADCType,anain);
+  changed=autoExposureStep(ae,hist);
+
+  if (changed & SMH_AE_VREF)
+    setVREF(ae->vref);
+  if (changed & SMH_AE_AOBIAS)
+    setAOBIAS(ae->aobias);
+  if (changed & SMH_AE_GAIN)
+    setAmpGain(ae->gain);
+
+  return changed;
+}
+
+#endif
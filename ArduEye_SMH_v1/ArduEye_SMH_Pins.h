@@ -0,0 +1,174 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_SMH_Pins.h
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Pin traits: the pins connecting a board to a Stonyman/Hawksbill
+//	vision chip, as types.  Each pin is an SMHPin with its port 
+//	address and bit mask as template constants, so on AVR setting or
+//	clearing a pin compiles to a single sbi/cbi instruction (ports 
+//	above the I/O space, e.g. PORTH of the 2560, to a lds/sts pair).
+//	A pin set groups the pins of one chip; ArduEyeSMHChip<PinSet> 
+//	drives a chip through its pin set, so two chips on different 
+//	pins can be run at once.
+//
+//	On a host (non AVR) build the pins write to simulated ports in 
+//	the host backend (host/ArduEye_Host.cpp), which records every
+//	pin transition.
+//
+//	Replaces pin_defs_168_328.h and pin_defs_2560.h
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+#ifndef _ARDUEYE_SMH_PINS_H_INCLUDED
+#define _ARDUEYE_SMH_PINS_H_INCLUDED
+
+#if !defined(__AVR__)
+/*********************************************************************/
+//	Host backend (host/ArduEye_Host.cpp)
+//	Simulated 8 bit ports, addressed like the AVR data memory.  Every
+//	write goes through smhHostPortWrite, which counts the rising 
+//	edges of each pin and calls the pin hook (if set) with the old
+//	and new port value, e.g. to drive a chip emulator.
+/*********************************************************************/
+
+//number of simulated port addresses
+#define SMH_HOST_NUMPORTS 0x110
+
+unsigned char smhHostPortRead(unsigned short port);
+void smhHostPortWrite(unsigned short port, unsigned char val);
+
+//rising edges of the pins in mask since the last reset
+unsigned long smhHostEdges(unsigned short port, unsigned char mask);
+void smhHostResetEdges(void);
+
+//called on every port write that changes a pin
+typedef void (*SMHHostPinHook)(unsigned short port, unsigned char oldval, unsigned char newval);
+void smhHostSetPinHook(SMHHostPinHook hook);
+#endif
+
+//register at a constant data memory address
+#define SMH_PORT8(addr) (*(volatile unsigned char *)(addr))
+
+/*********************************************************************/
+//	SMHPin
+//	One pin: Port is the data memory address of its PORTx register
+//	(DDRx is the address below), Mask the bit within the port.
+/*********************************************************************/
+
+template<unsigned short Port,unsigned char Mask> struct SMHPin
+{
+  enum { port=Port, ddr=Port-1, mask=Mask };
+
+#if defined(__AVR__)
+  static inline void high(void) { SMH_PORT8(Port) |= Mask; }
+  static inline void low(void) { SMH_PORT8(Port) &= (unsigned char)~Mask; }
+  static inline void output(void) { SMH_PORT8(Port-1) |= Mask; }
+  static inline void input(void) { SMH_PORT8(Port-1) &= (unsigned char)~Mask; }
+#else
+  static inline void high(void) { smhHostPortWrite(Port,smhHostPortRead(Port)|Mask); }
+  static inline void low(void) { smhHostPortWrite(Port,smhHostPortRead(Port)&~Mask); }
+  static inline void output(void) { smhHostPortWrite(Port-1,smhHostPortRead(Port-1)|Mask); }
+  static inline void input(void) { smhHostPortWrite(Port-1,smhHostPortRead(Port-1)&~Mask); }
+#endif
+
+  static inline void pulse(void) { high(); low(); }
+};
+
+/*********************************************************************/
+//	Pin sets, one per board.  Every pin set provides:
+//	RESP, INCP, RESV, INCV, INPHI: chip control lines
+//	ANALOG0-3: analog out pins of up to 4 chips (setAnalogInput)
+//	ADC_SS: slave select of the external ADC
+/*********************************************************************/
+
+//ATmega 8/168/328 (Uno).  Arduino pins: RESP 8, INCP 7, RESV 6, 
+//INCV 5, INPHI 4, analog A0-A3, ADC SS 10
+struct SMHPins328
+{
+  typedef SMHPin<0x25,0x01> RESP;	//PB0
+  typedef SMHPin<0x2B,0x80> INCP;	//PD7
+  typedef SMHPin<0x2B,0x40> RESV;	//PD6
+  typedef SMHPin<0x2B,0x20> INCV;	//PD5
+  typedef SMHPin<0x2B,0x10> INPHI;	//PD4
+
+  typedef SMHPin<0x28,0x01> ANALOG0;	//PC0
+  typedef SMHPin<0x28,0x02> ANALOG1;	//PC1
+  typedef SMHPin<0x28,0x04> ANALOG2;	//PC2
+  typedef SMHPin<0x28,0x08> ANALOG3;	//PC3
+
+  typedef SMHPin<0x25,0x04> ADC_SS;	//PB2
+};
+
+//ATmega 2560 (Mega), same Arduino pin numbers as the 328.
+//NOTE: the SPI pins are not on the shield, so the external ADC 
+//can't be used; ADC_SS is still needed to build the library.
+struct SMHPins2560
+{
+  typedef SMHPin<0x102,0x20> RESP;	//PH5
+  typedef SMHPin<0x102,0x10> INCP;	//PH4
+  typedef SMHPin<0x102,0x08> RESV;	//PH3
+  typedef SMHPin<0x2E,0x08> INCV;	//PE3
+  typedef SMHPin<0x34,0x20> INPHI;	//PG5
+
+  typedef SMHPin<0x31,0x01> ANALOG0;	//PF0
+  typedef SMHPin<0x31,0x02> ANALOG1;	//PF1
+  typedef SMHPin<0x31,0x04> ANALOG2;	//PF2
+  typedef SMHPin<0x31,0x08> ANALOG3;	//PF3
+
+  typedef SMHPin<0x25,0x10> ADC_SS;	//PB4
+};
+
+//host build: the 328 layout on the simulated ports
+struct SMHPinsHost : SMHPins328
+{
+};
+
+/*********************************************************************/
+//pin set of the board set in the Arduino IDE, used by ArduEyeSMH
+//currently supports ATmega2560/8/168/328 and host builds
+
+#if defined(__AVR_ATmega2560__)
+typedef SMHPins2560 SMHPinsDefault;
+#elif defined (__AVR_ATmega8__)||(__AVR_ATmega168__)|(__AVR_ATmega168P__)||(__AVR_ATmega328P__)
+typedef SMHPins328 SMHPinsDefault;
+#elif !defined(__AVR__)
+typedef SMHPinsHost SMHPinsDefault;
+#else 
+	#  error "Code only supports ATmega 2560 and ATmega 8/168/328"
+#endif
+
+#endif
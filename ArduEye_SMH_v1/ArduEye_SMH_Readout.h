@@ -0,0 +1,1571 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_SMH_Readout.h
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Compile-time specialized readout engine.  All acquisition 
+//	functions of ArduEyeSMHChip walk the chip through this single
+//	core, which is specialized on ADC type, amplifier use and a 
+//	"sink" that decides what to do with each pixel.
+//
+//	Working revision started July 9, 2012
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+
+#ifndef _ARDUEYE_SMH_READOUT_H_INCLUDED
+#define _ARDUEYE_SMH_READOUT_H_INCLUDED
+
+#include <SPI.h>	//SPI required for external ADC
+
+//pseudo ADC type used for unsupported ADCType values, every pixel
+//reads as 555 like the original acquisition loops did
+#define SMH1_ADCTYPE_UNKNOWN -1
+
+/*********************************************************************/
+/*********************************************************************/
+//	smhDelayUs
+//	delayMicroseconds for the timing profiles, a zero delay is 
+//	skipped (older cores wrap delayMicroseconds(0) to a long delay)
+/*********************************************************************/
+
+static inline void smhDelayUs(unsigned char us)
+{
+  if (us)
+    delayMicroseconds(us);
+}
+
+/*********************************************************************/
+//	smhDivQ8
+//	num/den in Q8 (centroids of findPeaks and findMaxCoarseToFine).
+//	The fraction is found one bit at a time, so the remainder never
+//	needs more than one bit above den: (num%den)<<8 overflows a long
+//	once the weight sum passes 2^23, e.g. a bright 12 bit blob.
+/*********************************************************************/
+
+static inline unsigned short smhDivQ8(unsigned long num, unsigned long den)
+{
+  unsigned long q=num/den,r=num%den;
+  unsigned char i;
+
+  for (i=0; i<8; ++i)
+  {
+    r<<=1;
+    q<<=1;
+    if (r>=den)
+    {
+      r-=den;
+      q|=1;
+    }
+  }
+  return q;
+}
+
+/*********************************************************************/
+//	ADC policies
+//	SMHADC<ADCType,SS>::read(anain) samples one pixel, SS is the
+//	external ADC slave select pin of the pin set.  Each ADC type
+//	is a separate specialization so the SPI byte assembly is inlined
+//	into the readout loop instead of switching on every pixel.
+//
+//	For pipelined readout the sample is split in two: startRead() 
+//	samples the pixel and returns a partial result, finishRead() 
+//	completes it.  For the SPI ADCs startRead() returns once the 
+//	high byte is in (the ADC holds its sample by then) and leaves 
+//	the low byte shifting, so the caller can advance the column while
+//	it clocks out.  Other ADCs do the whole sample in startRead().
+/*********************************************************************/
+/*********************************************************************/
+
+template<char ADCType,class SS> struct SMHADC
+{
+  static inline short read(char anain)
+  {
+    return 555;
+  }
+
+  static inline short startRead(char anain)
+  {
+    return read(anain);
+  }
+
+  static inline short finishRead(short partial)
+  {
+    return partial;
+  }
+};
+
+//onboard Arduino ADC
+template<class SS> struct SMHADC<SMH1_ADCTYPE_ONBOARD,SS>
+{
+  static inline short read(char anain)
+  {
+    return analogRead(anain); // acquire pixel
+  }
+
+  static inline short startRead(char anain)
+  {
+    return read(anain);
+  }
+
+  static inline short finishRead(short partial)
+  {
+    return partial;
+  }
+};
+
+//shared SPI handling of the Microchip MCP3001/MCP3201.  Both shift
+//out a 2 byte frame, Shift is the number of low bits to drop.  SS is
+//the slave select pin (ADC_SS of the pin set).
+template<char Shift,class SS> struct SMHADC_SPI
+{
+  static inline short read(char anain)
+  {
+    unsigned char chigh,clow;
+
+    SS::low();               // turn SS low to start conversion
+    chigh=SPI.transfer(0);   // get high byte
+    clow=SPI.transfer(0);    // get low byte
+    SS::high();              // SS high to stop
+    return assemble(chigh,clow);
+  }
+
+  static inline short startRead(char anain)
+  {
+    unsigned char chigh;
+
+    SS::low();               // turn SS low to start conversion
+    chigh=SPI.transfer(0);   // get high byte, sample is now held
+#if defined(SPDR)
+    SPDR=0;                  // start low byte, don't wait for it
+#endif
+    return chigh;
+  }
+
+  static inline short finishRead(short partial)
+  {
+    unsigned char clow;
+
+#if defined(SPDR)
+    while (!(SPSR & _BV(SPIF)))	// wait for low byte
+      ;
+    clow=SPDR;
+#else
+    clow=SPI.transfer(0);    // get low byte
+#endif
+    SS::high();              // SS high to stop
+    return assemble((unsigned char)partial,clow);
+  }
+
+  static inline short assemble(unsigned char chigh,unsigned char clow)
+  {
+    short val;
+
+    val = ((short)(chigh&0x1F))<<(8-Shift);
+    val += clow>>Shift;
+    return val;
+  }
+};
+
+//Microchip MCP3001, 10 bit
+template<class SS> struct SMHADC<SMH1_ADCTYPE_MCP3001,SS> : SMHADC_SPI<3,SS> 
+{
+};
+
+//Microchip MCP3201, 12 bit
+template<class SS> struct SMHADC<SMH1_ADCTYPE_MCP3201,SS> : SMHADC_SPI<1,SS> 
+{
+};
+
+//Microchip MCP3201 on the ArduEye Bug v1.0, same conversion
+template<class SS> struct SMHADC<SMH1_ADCTYPE_MCP3201_2,SS> : SMHADC_SPI<1,SS> 
+{
+};
+
+/*********************************************************************/
+//	SMHADC_Free
+//	Onboard ADC in free-running mode (SMH1_ADCTYPE_ONBOARD_FAST and
+//	_FAST8), set up once per frame by selectADC.  sync() waits for 
+//	the end of a conversion, at which point the next conversion 
+//	starts and samples the pixel currently addressed.  result() 
+//	returns the last conversion, 8 bits (ADCH with ADLAR) if Bits8.
+//	sync() returns 1 if the conversion had already ended when it was
+//	called, and ended() tells whether that is the case now.
+//	On boards without direct ADC access analogRead is used instead:
+//	sync() samples the addressed pixel and result() returns the
+//	sample taken at the sync() before, as the free-running ADC does.
+//	single() is the result of a single (not free-running) conversion.
+/*********************************************************************/
+
+template<char Bits8> struct SMHADC_Free
+{
+#if !(defined(ADCSRA) && defined(ADATE))
+  static short pending,done;
+#endif
+
+  static inline char ended(void)
+  {
+#if defined(ADCSRA) && defined(ADATE)
+    return (ADCSRA & _BV(ADIF)) != 0;
+#else
+    return 0;
+#endif
+  }
+
+  static inline char sync(char anain)
+  {
+#if defined(ADCSRA) && defined(ADATE)
+    char late=ended();
+
+    while (!(ADCSRA & _BV(ADIF)))	// wait for end of conversion
+      ;
+    ADCSRA |= _BV(ADIF);		// clear flag
+    return late;
+#else
+    done=pending;
+    pending=analogRead(anain);
+    return 0;
+#endif
+  }
+
+  static inline short result(char anain)
+  {
+#if defined(ADCSRA) && defined(ADATE)
+    if (Bits8)
+      return ADCH;
+    return ADCW;
+#else
+    if (Bits8)
+      return done>>2;
+    return done;
+#endif
+  }
+
+  static inline short single(char anain)
+  {
+#if defined(ADCSRA) && defined(ADATE) && !defined(SMH_BG_THREAD)
+    return ADCW;
+#else
+    return analogRead(anain);
+#endif
+  }
+};
+
+#if !(defined(ADCSRA) && defined(ADATE))
+template<char Bits8> short SMHADC_Free<Bits8>::pending=0;
+template<char Bits8> short SMHADC_Free<Bits8>::done=0;
+#endif
+
+//fast onboard ADC outside the free-running loop: wait for the 
+//conversion in progress to end, the next one samples the pixel.
+//readInput() first switches the free-running ADC to input anain 
+//(several chips, getImageMulti).  The channel is taken when the next
+//conversion starts, so if one started before the switch (sync late)
+//it is dropped as well.
+template<char Bits8> struct SMHADC_FreeRead
+{
+  static inline short read(char anain)
+  {
+    SMHADC_Free<Bits8>::sync(anain);
+    SMHADC_Free<Bits8>::sync(anain);
+    return SMHADC_Free<Bits8>::result(anain);
+  }
+
+  static inline short readInput(char anain)
+  {
+#if defined(ADCSRA) && defined(ADATE)
+    ADMUX = (ADMUX & ~0x07) | (anain & 0x07);
+    if (SMHADC_Free<Bits8>::sync(anain))
+      SMHADC_Free<Bits8>::sync(anain);
+    SMHADC_Free<Bits8>::sync(anain);
+    return SMHADC_Free<Bits8>::result(anain);
+#else
+    return read(anain);
+#endif
+  }
+
+  static inline short startRead(char anain)
+  {
+    return read(anain);
+  }
+
+  static inline short finishRead(short partial)
+  {
+    return partial;
+  }
+};
+
+template<class SS> struct SMHADC<SMH1_ADCTYPE_ONBOARD_FAST,SS> : SMHADC_FreeRead<0> 
+{
+};
+
+template<class SS> struct SMHADC<SMH1_ADCTYPE_ONBOARD_FAST8,SS> : SMHADC_FreeRead<1> 
+{
+};
+
+/*********************************************************************/
+/*********************************************************************/
+//	Pixel sinks
+//	A sink receives every pixel of a readout.  Each sink provides:
+//	colMajor: 1 to scan columns in the outer loop, 0 for rows
+//	pixel(row,col,val): called for every pixel, row and col are the
+//	  indices within the acquired window (not chip coordinates)
+//	endLine(): called after each outer line (row, or column if 
+//	  colMajor is set)
+/*********************************************************************/
+/*********************************************************************/
+
+/*********************************************************************/
+//	SMHStoreSink
+//	Stores pixels raster-wise in a 1D array of shorts (getImage)
+/*********************************************************************/
+
+struct SMHStoreSink
+{
+  enum { colMajor=0 };
+
+  short *pimg;	//pointer to next output pixel
+
+  SMHStoreSink(short *img) : pimg(img) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    *pimg = val; // store pixel
+    pimg++; // advance pointer
+  }
+
+  inline void endLine(void) {}
+};
+
+/*********************************************************************/
+//	smhClamp8
+//	Clamps a value to the range of an 8 bit pixel type: -128..127 for
+//	char, 0..255 for unsigned char
+/*********************************************************************/
+
+template<class T> inline T smhClamp8(short val)
+{
+  if ((T)-1 < 0)	//signed
+  {
+    if (val < -128) val = -128;
+    else if (val > 127) val = 127;
+  }
+  else
+  {
+    if (val < 0) val = 0;
+    else if (val > 255) val = 255;
+  }
+  return (T)val;
+}
+
+/*********************************************************************/
+//	SMHStore8Sink
+//	Stores pixels raster-wise in a 1D array of 8 bit pixels (char or
+//	unsigned char), as (val-offset)>>shift clamped to the pixel range
+/*********************************************************************/
+
+template<class T> struct SMHStore8Sink
+{
+  enum { colMajor=0 };
+
+  T *pimg;		//pointer to next output pixel
+  short offset;		//subtracted from the ADC value
+  unsigned char shift;	//right shift after the offset
+
+  SMHStore8Sink(T *img,short off,unsigned char sh) : pimg(img), offset(off), shift(sh) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    *pimg = smhClamp8<T>((val-offset)>>shift);
+    pimg++;
+  }
+
+  inline void endLine(void) {}
+};
+
+/*********************************************************************/
+//	smhADCFull
+//	Largest value an ADC type returns
+/*********************************************************************/
+
+static inline short smhADCFull(char ADCType)
+{
+  switch (ADCType)
+  {
+    case SMH1_ADCTYPE_MCP3201:
+    case SMH1_ADCTYPE_MCP3201_2:
+      return 4095;
+    case SMH1_ADCTYPE_ONBOARD_FAST8:
+      return 255;
+    default:
+      return 1023;
+  }
+}
+
+/*********************************************************************/
+//	SMHSumSink
+//	Adds each pixel to a raster-wise array of unsigned shorts, to 
+//	average frames (calibrateFPN)
+/*********************************************************************/
+
+struct SMHSumSink
+{
+  enum { colMajor=0 };
+
+  unsigned short *psum;	//pointer to next sum
+
+  SMHSumSink(unsigned short *sum) : psum(sum) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    *psum += val;
+    psum++;
+  }
+
+  inline void endLine(void) {}
+};
+
+/*********************************************************************/
+//	SMHFPNSink
+//	Stores pixels raster-wise with the FPN corrected (getImage(fpn)):
+//	offset-val, negated like applyMask so the image displays the same,
+//	times the Q7 gain if there is one.
+/*********************************************************************/
+
+struct SMHFPNSink
+{
+  enum { colMajor=0 };
+
+  short *pimg;			//pointer to next output pixel
+  const short *poffset;		//offset of that pixel
+  const unsigned char *pgain;	//gain of that pixel, NULL if none
+
+  SMHFPNSink(short *img,const SMHFPN *fpn) : pimg(img), poffset(fpn->offset), pgain(fpn->gain) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    val = *poffset++ - val;
+    if (pgain)
+      val = ((long)val * *pgain++) >> 7;
+    *pimg++ = val;
+  }
+
+  inline void endLine(void) {}
+};
+
+/*********************************************************************/
+//	smhPackGroup
+//	Packs one group of pixels, 4 into 5 bytes for 10 bits or 2 into
+//	3 bytes for 12 bits (the layout of CYE_FRAME_PACK10/12 and of the
+//	binary dump).  Returns the number of bytes written.
+/*********************************************************************/
+
+template<char Bits> inline unsigned char smhPackGroup(const short *g, unsigned char *out)
+{
+  if (Bits==12)
+  {
+    out[0]=g[0]>>4;
+    out[1]=g[1]>>4;
+    out[2]=(g[0]&15)|((g[1]&15)<<4);
+    return 3;
+  }
+  out[0]=g[0]>>2;
+  out[1]=g[1]>>2;
+  out[2]=g[2]>>2;
+  out[3]=g[3]>>2;
+  out[4]=(g[0]&3)|((g[1]&3)<<2)|((g[2]&3)<<4)|((g[3]&3)<<6);
+  return 5;
+}
+
+/*********************************************************************/
+//	SMHStorePackSink
+//	Stores pixels straight into a packed frame buffer 
+//	(CYE_FRAME_PACK10/12), as val>>shift clamped to 0..2^Bits-1.  Each
+//	row is padded to a whole group so rows can be unpacked one at a 
+//	time with CYE_FrameGetRow.
+/*********************************************************************/
+
+template<char Bits> struct SMHStorePackSink
+{
+  enum { colMajor=0, group=(Bits==12) ? 2 : 4 };
+
+  unsigned char *pimg;	//next output byte
+  unsigned char shift;	//right shift of the ADC value
+  short grp[4];		//pixels of the group being filled
+  unsigned char n;	//pixels in grp
+
+  SMHStorePackSink(unsigned char *img,unsigned char sh) : pimg(img), shift(sh), n(0) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    val>>=shift;
+    if (val<0)
+      val=0;
+    if (val>(1<<Bits)-1)
+      val=(1<<Bits)-1;
+    grp[n++]=val;
+    if (n==group)
+    {
+      pimg+=smhPackGroup<Bits>(grp,pimg);
+      n=0;
+    }
+  }
+
+  inline void endLine(void)
+  {
+    if (n)
+    {
+      while (n<group)
+        grp[n++]=0;
+      pimg+=smhPackGroup<Bits>(grp,pimg);
+      n=0;
+    }
+  }
+};
+
+/*********************************************************************/
+//	smhNormalize
+//	Scales a long sum of "count" pixels to a short: the mean if norm
+//	is SMH_PROJ_MEAN, else sum>>norm, saturated to the short range
+/*********************************************************************/
+
+static inline short smhNormalize(long sum, unsigned char count, char norm)
+{
+  if (norm==SMH_PROJ_MEAN)
+    sum = count ? sum/count : 0;
+  else
+    sum >>= norm;
+
+  if (sum>32767)
+    return 32767;
+  if (sum<-32768)
+    return -32768;
+  return (short)sum;
+}
+
+/*********************************************************************/
+//	SMHRowSumSink
+//	Sums each row and stores one value per row (getImageRowSum).  
+//	The sum is kept in a long and stored as sum>>4, saturated.
+/*********************************************************************/
+
+struct SMHRowSumSink
+{
+  enum { colMajor=0 };
+
+  short *pimg;	//pointer to next output value
+  long total;	//running sum of current row
+
+  SMHRowSumSink(short *img) : pimg(img), total(0) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    total+=val;	//sum values along row
+  }
+
+  inline void endLine(void)
+  {
+    *pimg = smhNormalize(total,0,4); // store sum/16
+    pimg++; // advance pointer
+    total=0;
+  }
+};
+
+/*********************************************************************/
+//	SMHColSumSink
+//	Sums each column and stores one value per column 
+//	(getImageColSum).  Scans column-wise so only one sum is kept.
+/*********************************************************************/
+
+struct SMHColSumSink : SMHRowSumSink
+{
+  enum { colMajor=1 };
+
+  SMHColSumSink(short *img) : SMHRowSumSink(img) {}
+};
+
+/*********************************************************************/
+//	SMHProjSink
+//	Row and column projections in one raster pass 
+//	(getImageProjections).  The row sum is a single long reset every
+//	row, the column sums are an array of longs supplied by the caller.
+//	Optionally stores the image as well.  Any output may be NULL.
+/*********************************************************************/
+
+struct SMHProjSink
+{
+  enum { colMajor=0 };
+
+  short *rowproj;	//normalized row sums, written at each row end
+  long *colacc;		//column sums, normalized by finish()
+  short *pimg;		//next image pixel, NULL if not stored
+  long rowacc;		//sum of the current row
+  unsigned char row;	//index of the current row
+  unsigned char numcols;
+  char norm;		//SMH_PROJ_MEAN or right shift
+
+  SMHProjSink(short *rp,long *ca,short *img,unsigned char ncols,char nrm) : rowproj(rp), colacc(ca), pimg(img), rowacc(0), row(0), numcols(ncols), norm(nrm)
+  {
+    unsigned char c;
+
+    if (colacc)
+      for (c=0; c<numcols; ++c)
+        colacc[c]=0;
+  }
+
+  inline void pixel(unsigned char r,unsigned char col,short val)
+  {
+    rowacc+=val;
+    if (colacc)
+      colacc[col]+=val;
+    if (pimg)
+      *pimg++ = val;
+  }
+
+  inline void endLine(void)
+  {
+    if (rowproj)
+      rowproj[row] = smhNormalize(rowacc,numcols,norm);
+    row++;
+    rowacc=0;
+  }
+
+  //normalizes the column sums into colproj
+  void finish(short *colproj)
+  {
+    unsigned char c;
+
+    if (colacc && colproj)
+      for (c=0; c<numcols; ++c)
+        colproj[c] = smhNormalize(colacc[c],row,norm);
+  }
+};
+
+/*********************************************************************/
+//	SMHMaxSink
+//	Tracks the brightest pixel (findMax).  Without the amplifier a
+//	bright pixel has a low value, with it the output is inverted.
+/*********************************************************************/
+
+struct SMHMaxSink
+{
+  enum { colMajor=0 };
+
+  char useAmp;		//amplifier inverts pixel polarity
+  unsigned short maxval,minval;
+  unsigned char bestrow,bestcol;
+
+  SMHMaxSink(char amp) : useAmp(amp), maxval(5000), minval(0), bestrow(0), bestcol(0) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    if(useAmp)	//amplifier is inverted
+    {
+      if ((unsigned short)val>minval) 	//find max val (bright)
+      {
+        bestrow=row;
+        bestcol=col;
+        minval=val;
+      }
+    }
+    else		//unamplified
+    {
+      if ((unsigned short)val<maxval) 	//find min val (bright)
+      {
+        bestrow=row;
+        bestcol=col;
+        maxval=val;
+      }
+    }
+  }
+
+  inline void endLine(void) {}
+};
+
+/*********************************************************************/
+//	SMHMeanMaxSink
+//	SMHMaxSink that also sums the pixels, for the background level of
+//	the coarse pass of findMaxCoarseToFine
+/*********************************************************************/
+
+struct SMHMeanMaxSink : SMHMaxSink
+{
+  long sum;
+  short count;
+
+  SMHMeanMaxSink(char amp) : SMHMaxSink(amp), sum(0), count(0) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    SMHMaxSink::pixel(row,col,val);
+    sum+=val;
+    count++;
+  }
+};
+
+/*********************************************************************/
+//	SMHCentroidSink
+//	Brightest pixel plus intensity weighted centroid (fine pass of 
+//	findMaxCoarseToFine).  Each pixel is weighted by how much brighter
+//	it is than "background", pixels darker than it have no weight.
+/*********************************************************************/
+
+struct SMHCentroidSink : SMHMaxSink
+{
+  short background;
+  long sumw,sumwr,sumwc;	//weight, weight*row, weight*col
+
+  SMHCentroidSink(char amp,short bg) : SMHMaxSink(amp), background(bg), sumw(0), sumwr(0), sumwc(0) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    short w;
+
+    SMHMaxSink::pixel(row,col,val);
+
+    w = useAmp ? val-background : background-val;	//brightness
+    if (w>0)
+    {
+      sumw+=w;
+      sumwr+=(long)w*row;
+      sumwc+=(long)w*col;
+    }
+  }
+};
+
+/*********************************************************************/
+//	SMHPeakSink
+//	Streaming top-K peak detector (findPeaks).  Pixels brighter than
+//	"threshold" are grouped into at most k peaks held in the caller's
+//	array, so memory is O(k) and no frame buffer is needed.  A bright
+//	pixel within minsep (in window indices, both axes) of a peak
+//	joins it: it adds to the peak's centroid sums and becomes the 
+//	peak position if it is brighter.  Otherwise it starts a new peak,
+//	replacing the weakest one once all k are in use.  Since pixels 
+//	of a blob are added from the first one seen, the centroid covers
+//	the rows above the brightest pixel too.
+/*********************************************************************/
+
+struct SMHPeakSink
+{
+  enum { colMajor=0 };
+
+  char brightHigh;	//1 if bright pixels have high values
+  short threshold;
+  unsigned char minsep;
+  SMHPeak *peaks;
+  unsigned char k,count;
+
+  SMHPeakSink(char bh,short thr,unsigned char sep,SMHPeak *p,unsigned char kmax) : brightHigh(bh), threshold(thr), minsep(sep), peaks(p), k(kmax), count(0) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    short w = brightHigh ? val-threshold : threshold-val;
+    unsigned char i,weakest;
+    SMHPeak *p;
+
+    if (w<=0)
+      return;
+
+    // join an existing peak
+    for (i=0; i<count; ++i)
+    {
+      p=&peaks[i];
+      if ((unsigned char)(row-p->row+minsep)<=2*minsep &&
+          (unsigned char)(col-p->col+minsep)<=2*minsep)
+      {
+        p->sumw+=w;
+        p->sumwr+=(long)w*row;
+        p->sumwc+=(long)w*col;
+        if (w>p->weight)
+        {
+          p->weight=w;
+          p->row=row;
+          p->col=col;
+        }
+        return;
+      }
+    }
+
+    // new peak, in a free slot or replacing the weakest
+    if (count<k)
+      p=&peaks[count++];
+    else
+    {
+      weakest=0;
+      for (i=1; i<count; ++i)
+        if (peaks[i].weight<peaks[weakest].weight)
+          weakest=i;
+      if (!count || w<=peaks[weakest].weight)
+        return;
+      p=&peaks[weakest];
+    }
+    p->row=row;
+    p->col=col;
+    p->weight=w;
+    p->sumw=w;
+    p->sumwr=(long)w*row;
+    p->sumwc=(long)w*col;
+  }
+
+  inline void endLine(void) {}
+
+  // sorts the peaks brightest first and computes the Q8 centroids, 
+  // mapped to coordinates start+index*skip
+  unsigned char finish(unsigned char rowstart,unsigned char rowskip,unsigned char colstart,unsigned char colskip)
+  {
+    unsigned char i,j;
+    SMHPeak t;
+
+    for (i=1; i<count; ++i)
+      for (j=i; j>0 && peaks[j].weight>peaks[j-1].weight; --j)
+      {
+        t=peaks[j]; peaks[j]=peaks[j-1]; peaks[j-1]=t;
+      }
+
+    for (i=0; i<count; ++i)
+    {
+      SMHPeak *p=&peaks[i];
+      unsigned short rq=smhDivQ8(p->sumwr,p->sumw);
+      unsigned short cq=smhDivQ8(p->sumwc,p->sumw);
+      p->row_q8=((unsigned short)rowstart<<8)+rq*rowskip;
+      p->col_q8=((unsigned short)colstart<<8)+cq*colskip;
+      p->row=rowstart+p->row*rowskip;
+      p->col=colstart+p->col*colskip;
+    }
+
+    return count;
+  }
+};
+
+/*********************************************************************/
+//	SMHHistSink
+//	Histogram of the pixel values (getHistogram).  shift maps the 
+//	ADC range onto the SMH_AE_BINS bins.
+/*********************************************************************/
+
+struct SMHHistSink
+{
+  enum { colMajor=0 };
+
+  unsigned short *hist;
+  char shift;
+
+  SMHHistSink(unsigned short *h,char sh) : hist(h), shift(sh) {}
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    unsigned short bin;
+
+    if (val<0)
+      val=0;
+    bin=(unsigned short)val>>shift;
+    if (bin>=SMH_AE_BINS)
+      bin=SMH_AE_BINS-1;
+    hist[bin]++;
+  }
+
+  inline void endLine(void) {}
+};
+
+/*********************************************************************/
+//	SMHPrintSink
+//	Prints pixels over serial as rows of a Matlab array 
+//	(chipToMatlab, sectionToMatlab)
+/*********************************************************************/
+
+struct SMHPrintSink
+{
+  enum { colMajor=0 };
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    Serial.print(val);
+    Serial.print(" ");
+  }
+
+  inline void endLine(void)
+  {
+    Serial.println(" ");
+  }
+};
+
+/*********************************************************************/
+//	SMHPackSink
+//	Writes pixels over serial packed to Bits (10 or 12) bits, with 
+//	the Fletcher-16 of the frame (chipToBinary, sectionToBinary).  
+//	See ArduEye_SMH.h for the frame layout.  Pixels are clipped to
+//	0..2^Bits-1.
+/*********************************************************************/
+
+template<char Bits>
+struct SMHPackSink
+{
+  enum { colMajor=0, group=(Bits==12) ? 2 : 4 };
+
+  unsigned short sum1,sum2;	//Fletcher-16 sums
+  short grp[4];			//pixels of the group being filled
+  unsigned char n;		//pixels in grp
+
+  SMHPackSink() : sum1(0), sum2(0), n(0) {}
+
+  inline void put(unsigned char b)
+  {
+    Serial.write(b);
+    sum1+=b;
+    if (sum1>=255)
+      sum1-=255;
+    sum2+=sum1;
+    if (sum2>=255)
+      sum2-=255;
+  }
+
+  void header(char ADCType, unsigned char rows, unsigned char cols, unsigned char rowstart, unsigned char colstart, unsigned char rowskip, unsigned char colskip)
+  {
+    Serial.write((unsigned char)SMH_DUMP_SYNC0);
+    Serial.write((unsigned char)SMH_DUMP_SYNC1);
+    put(Bits);
+    put(ADCType);
+    put(rows);
+    put(cols);
+    put(rowstart);
+    put(colstart);
+    put(rowskip);
+    put(colskip);
+  }
+
+  void flushGroup(void)
+  {
+    unsigned char b[5],i,len;
+
+    len=smhPackGroup<Bits>(grp,b);
+    for (i=0; i<len; ++i)
+      put(b[i]);
+    n=0;
+  }
+
+  inline void pixel(unsigned char row,unsigned char col,short val)
+  {
+    if (val<0)
+      val=0;
+    if (val>(1<<Bits)-1)
+      val=(1<<Bits)-1;
+    grp[n++]=val;
+    if (n==group)
+      flushGroup();
+  }
+
+  inline void endLine(void) {}
+
+  //pads and writes the last group, then the checksum
+  void finish(void)
+  {
+    if (n)
+    {
+      while (n<group)
+        grp[n++]=0;
+      flushGroup();
+    }
+    Serial.write((unsigned char)sum1);
+    Serial.write((unsigned char)sum2);
+  }
+};
+
+/*********************************************************************/
+//	SMHRowStreamSink
+//	Collects one row at a time in a reusable row buffer and hands it
+//	to a caller-supplied function or functor (getImageRows).  The
+//	function is called as rowfunc(row,rowbuf,numcols) where row is 
+//	the row index within the acquired window.
+/*********************************************************************/
+
+template<class F>
+struct SMHRowStreamSink
+{
+  enum { colMajor=0 };
+
+  short *rowbuf;	//reusable buffer holding one row
+  short *pimg;		//next pixel in rowbuf
+  unsigned char row;	//index of row being read
+  F &rowfunc;		//called once per finished row
+
+  SMHRowStreamSink(short *buf,F &func) : rowbuf(buf), pimg(buf), row(0), rowfunc(func) {}
+
+  inline void pixel(unsigned char r,unsigned char col,short val)
+  {
+    *pimg = val; // store pixel in row buffer
+    pimg++;
+  }
+
+  inline void endLine(void)
+  {
+    rowfunc(row,rowbuf,(unsigned char)(pimg-rowbuf));
+    pimg=rowbuf;	//reuse buffer for the next row
+    row++;
+  }
+};
+
+/*********************************************************************/
+//	getImageRows
+//	Streaming version of getImage.  Instead of filling a whole frame,
+//	each row is read into rowbuf (numcols shorts) and passed to 
+//	rowfunc before the next row is read, so only one row of RAM is 
+//	needed regardless of the window size.  This lets a 328 process 
+//	full 112x112 Stonyman or 136x136 Hawksbill frames.  The pixels
+//	are continuous-time, so the time rowfunc takes between rows does
+//	not change the pixel values read.
+//
+//	VARIABLES: 
+//	rowbuf: buffer of at least numcols shorts
+//	rowstart,numrows,rowskip,colstart,numcols,colskip: as getImage
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+//	rowfunc: function or functor called as 
+//	rowfunc(unsigned char row, short *pixels, unsigned char numcols)
+//
+//	EXAMPLE:
+//	void processRow(unsigned char row,short *pixels,unsigned char n)
+//	{ ... }
+//	short rowbuf[112];
+//	ArduEyeSMH.getImageRows(rowbuf,0,112,1,0,112,1,
+//	  SMH1_ADCTYPE_ONBOARD,0,processRow);
+/*********************************************************************/
+
+template<class Pins> template<class F>
+void ArduEyeSMHChip<Pins>::getImageRows(short *rowbuf, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, F &rowfunc)
+{
+  SMHRowStreamSink<F> sink(rowbuf,rowfunc);
+
+  readout(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,anain);
+}
+
+/*********************************************************************/
+/*********************************************************************/
+//	readout
+//	Selects the ADC input, picks the readout core specialized for the
+//	ADC type and amplifier setting, and deselects the input again.
+//	The ADC/amplifier switch runs once per call instead of per pixel.
+//
+//	VARIABLES: 
+//	sink: pixel sink receiving every pixel (see above)
+//	rowstart,numrows,rowskip,colstart,numcols,colskip: window to 
+//	read, as in getImage
+//	ADCType: which ADC to use, defined ADC_TYPES
+//	anain (0,1,2,3): which analog input to use
+/*********************************************************************/
+/*********************************************************************/
+
+template<class Pins> template<class Sink>
+void ArduEyeSMHChip<Pins>::readout(Sink &sink, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain)
+{
+  selectADC(ADCType,anain);
+
+  switch (ADCType) 
+  {
+    case SMH1_ADCTYPE_ONBOARD:
+      readoutAmp<SMH1_ADCTYPE_ONBOARD,0>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      break;
+    case SMH1_ADCTYPE_ONBOARD_FAST:
+      if (useAmp)
+        readoutFreeCore<0,1>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      else
+        readoutFreeCore<0,0>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      break;
+    case SMH1_ADCTYPE_ONBOARD_FAST8:
+      if (useAmp)
+        readoutFreeCore<1,1>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      else
+        readoutFreeCore<1,0>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      break;
+    case SMH1_ADCTYPE_MCP3001:
+      if (pipelined)
+        readoutAmp<SMH1_ADCTYPE_MCP3001,1>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      else
+        readoutAmp<SMH1_ADCTYPE_MCP3001,0>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      break;
+    case SMH1_ADCTYPE_MCP3201:
+      if (pipelined)
+        readoutAmp<SMH1_ADCTYPE_MCP3201,1>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      else
+        readoutAmp<SMH1_ADCTYPE_MCP3201,0>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      break;
+    case SMH1_ADCTYPE_MCP3201_2:	//own core so its timing profile is used
+      if (pipelined)
+        readoutAmp<SMH1_ADCTYPE_MCP3201_2,1>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      else
+        readoutAmp<SMH1_ADCTYPE_MCP3201_2,0>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      break;
+    default:
+      readoutCore<SMH1_ADCTYPE_UNKNOWN,0,0>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+      break;
+  }
+
+  deselectADC(ADCType,anain);
+}
+
+/*********************************************************************/
+//	readoutAmp
+//	Picks the readout core for the current amplifier setting
+/*********************************************************************/
+
+template<class Pins> template<char ADCType,char Pipelined,class Sink>
+void ArduEyeSMHChip<Pins>::readoutAmp(Sink &sink, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char anain)
+{
+  if (useAmp)
+    readoutCore<ADCType,1,Pipelined>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+  else
+    readoutCore<ADCType,0,Pipelined>(sink,rowstart,numrows,rowskip,colstart,numcols,colskip,anain);
+}
+
+/*********************************************************************/
+//	readoutCore
+//	The one acquisition loop.  Walks the outer register (ROWSEL, or
+//	COLSEL for column-major sinks) and the inner register through
+//	the window, settles, pulses the amplifier if UseAmp is set and
+//	hands each sample to the sink.  Inner-register increments are 
+//	pulsed directly and the shadow register is updated once per line.
+//
+//	With Pipelined set the loop becomes a two stage software 
+//	pipeline: the first pixel of a line gets the full settling time
+//	(warm-up), then for each pixel the SPI low byte of pixel N clocks
+//	out while the column is advanced to pixel N+1 and it settles.  
+//	finishRead() drains the transfer before the sample is stored.  
+//	The first settling delay is absorbed by the low byte transfer, 
+//	which takes at least 1us at SPI clocks up to 8MHz.
+/*********************************************************************/
+
+template<class Pins> template<char ADCType,char UseAmp,char Pipelined,class Sink>
+void ArduEyeSMHChip<Pins>::readoutCore(Sink &sink, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char anain)
+{
+  unsigned char outer,inner,k;
+  char outerreg,innerreg;
+  unsigned char outerstart,numouter,outerskip;
+  unsigned char innerstart,numinner,innerskip;
+  short val;
+  const SMHTiming tm=timing[(ADCType>=0)?ADCType:SMH1_ADCTYPE_ONBOARD];	//unknown ADC: onboard timing
+
+  if (Sink::colMajor)	//columns in the outer loop
+  {
+    outerreg=SMH_SYS_COLSEL; outerstart=colstart; numouter=numcols; outerskip=colskip;
+    innerreg=SMH_SYS_ROWSEL; innerstart=rowstart; numinner=numrows; innerskip=rowskip;
+  }
+  else			//rows in the outer loop
+  {
+    outerreg=SMH_SYS_ROWSEL; outerstart=rowstart; numouter=numrows; outerskip=rowskip;
+    innerreg=SMH_SYS_COLSEL; innerstart=colstart; numinner=numcols; innerskip=colskip;
+  }
+
+  // Go to first line
+  {
+    PROF_SCOPE(PROF_ADDRESS);
+    setPointerValue(outerreg,outerstart);
+  }
+
+  // Loop through all lines
+  for (outer=0; outer<numouter; ++outer) {
+
+    // Go to first pixel of line
+    {
+      PROF_SCOPE(PROF_ADDRESS);
+      setPointerValue(innerreg,innerstart);
+    }
+
+    // Loop through all pixels of line
+    for (inner=0; inner<numinner; ++inner) {
+
+      // settling delay, overlapped with the SPI transfer of the
+      // previous pixel when pipelined
+      if (!Pipelined || (inner==0))
+        smhDelayUs(tm.settle1);
+
+      // pulse amplifier if needed
+      if (UseAmp) 
+        pulseInphi(tm.inphi);
+
+      // get data value
+      smhDelayUs(tm.settle2);
+
+      if (Pipelined)
+      {
+        // sample pixel N, low byte keeps shifting
+        val = SMHADC<ADCType,typename Pins::ADC_SS>::startRead(anain);
+
+        // go to pixel N+1 while the low byte clocks out
+        for (k=0; k<innerskip; ++k)
+          Pins::INCV::pulse();
+
+        val = SMHADC<ADCType,typename Pins::ADC_SS>::finishRead(val);
+      }
+      else
+      {
+        val = SMHADC<ADCType,typename Pins::ADC_SS>::read(anain);
+
+        // go to next pixel
+        for (k=0; k<innerskip; ++k)
+          Pins::INCV::pulse();
+      }
+
+      if (Sink::colMajor)
+        sink.pixel(inner,outer,val);
+      else
+        sink.pixel(outer,inner,val);
+    }
+
+    // account for the increments sent in this line
+    shadowIncrement((short)numinner*innerskip);
+
+    sink.endLine();
+
+    {
+      PROF_SCOPE(PROF_ADDRESS);
+      setPointer(outerreg);
+      incValue(outerskip); // go to next line
+    }
+  }
+}
+
+/*********************************************************************/
+//	readoutFreeCore
+//	Readout loop for the free-running onboard ADC.  A conversion 
+//	samples the addressed pixel during its first 1.5 ADC clocks and 
+//	the next conversion starts as soon as it ends, so the loop runs
+//	one pixel behind the ADC: after each sync() the conversion that
+//	just started is sampling pixel N+1 while the result of pixel N is
+//	read.  Once the sample/hold window has closed the column is 
+//	advanced, and the new pixel settles during the rest of the
+//	conversion.  One pixel therefore takes one conversion (13 ADC 
+//	clocks) and the settling time is hidden.
+//
+//	The ADC does not wait for the loop.  If the sink took longer than
+//	a conversion (e.g. printing or sending the pixel), the conversion
+//	of pixel N has already ended before the column is advanced, and
+//	the next one is sampling N again.  The loop checks for this 
+//	before moving on and then takes the result of N at once.  If the
+//	conversion ends while the column is advanced, sync() reports it.
+//	Either way the conversion running may have sampled N or the 
+//	change to N+1, so the loop warms up again on N+1 as at the start
+//	of a line.  Such a pixel costs two or three conversions, the 
+//	values stay in place.
+//
+//	Each line starts with a warm-up (freeWarmUp): the first pixel 
+//	settles, then a conversion is started on it.  With the amplifier
+//	the INPHI pulse must fit in the conversion, use a prescaler of 8
+//	or more.
+/*********************************************************************/
+
+template<class Pins> template<char Bits8,char UseAmp,class Sink>
+void ArduEyeSMHChip<Pins>::readoutFreeCore(Sink &sink, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char anain)
+{
+  unsigned char outer,inner,k;
+  char outerreg,innerreg;
+  unsigned char outerstart,numouter,outerskip;
+  unsigned char innerstart,numinner,innerskip;
+  short val;
+  char late;
+  const SMHTiming tm=timing[Bits8 ? SMH1_ADCTYPE_ONBOARD_FAST8 : SMH1_ADCTYPE_ONBOARD_FAST];
+
+  if (Sink::colMajor)	//columns in the outer loop
+  {
+    outerreg=SMH_SYS_COLSEL; outerstart=colstart; numouter=numcols; outerskip=colskip;
+    innerreg=SMH_SYS_ROWSEL; innerstart=rowstart; numinner=numrows; innerskip=rowskip;
+  }
+  else			//rows in the outer loop
+  {
+    outerreg=SMH_SYS_ROWSEL; outerstart=rowstart; numouter=numrows; outerskip=rowskip;
+    innerreg=SMH_SYS_COLSEL; innerstart=colstart; numinner=numcols; innerskip=colskip;
+  }
+
+  // Go to first line
+  {
+    PROF_SCOPE(PROF_ADDRESS);
+    setPointerValue(outerreg,outerstart);
+  }
+
+  // Loop through all lines
+  for (outer=0; outer<numouter; ++outer) {
+
+    // Go to first pixel of line
+    {
+      PROF_SCOPE(PROF_ADDRESS);
+      setPointerValue(innerreg,innerstart);
+    }
+
+    // warm-up: settle first pixel and start its conversion
+    freeWarmUp<Bits8,UseAmp>(tm,anain);
+
+    // Loop through all pixels of line
+    for (inner=0; inner<numinner; ++inner) {
+
+      // wait for the sample/hold window of pixel N to close
+      delayMicroseconds(adcHoldUs);
+
+      if (SMHADC_Free<Bits8>::ended())
+      {
+        // the loop fell behind: the conversion of pixel N is done
+        // and the ADC is converting N again, take the result now
+        late = SMHADC_Free<Bits8>::sync(anain);
+        val = SMHADC_Free<Bits8>::result(anain);
+
+        for (k=0; k<innerskip; ++k)
+          Pins::INCV::pulse();
+      }
+      else
+      {
+        // go to pixel N+1, it settles during the conversion of N
+        for (k=0; k<innerskip; ++k)
+          Pins::INCV::pulse();
+
+        // pulse amplifier for pixel N+1 if needed
+        if (UseAmp) 
+          pulseInphi(tm.inphi);
+
+        // end of conversion of pixel N, N+1 is now being sampled
+        late = SMHADC_Free<Bits8>::sync(anain);
+        val = SMHADC_Free<Bits8>::result(anain);
+      }
+
+      // if the conversion ended before or while the column changed,
+      // start over on pixel N+1
+      if (late && (inner+1<numinner))
+        freeWarmUp<Bits8,UseAmp>(tm,anain);
+
+      if (Sink::colMajor)
+        sink.pixel(inner,outer,val);
+      else
+        sink.pixel(outer,inner,val);
+    }
+
+    // account for the increments sent in this line
+    shadowIncrement((short)numinner*innerskip);
+
+    sink.endLine();
+
+    {
+      PROF_SCOPE(PROF_ADDRESS);
+      setPointer(outerreg);
+      incValue(outerskip); // go to next line
+    }
+  }
+}
+
+/*********************************************************************/
+//	freeWarmUp
+//	Settles the addressed pixel, then syncs twice.  The first sync()
+//	may return at once on a conversion that ended while the address
+//	was still changing (a long pulse train, a slow sink or end of 
+//	line, a small prescaler), and the conversion then running may 
+//	have sampled the old or a passing address.  The second sync() 
+//	waits for that conversion to end, so the one it starts samples 
+//	the settled pixel.
+/*********************************************************************/
+
+template<class Pins> template<char Bits8,char UseAmp>
+void ArduEyeSMHChip<Pins>::freeWarmUp(const SMHTiming &tm, char anain)
+{
+  smhDelayUs(tm.settle1);
+  if (UseAmp) 
+    pulseInphi(tm.inphi);
+  smhDelayUs(tm.settle2);
+  SMHADC_Free<Bits8>::sync(anain);
+  SMHADC_Free<Bits8>::sync(anain);
+}
+
+/*********************************************************************/
+//	readoutROICore
+//	Readout loop of getImageROIs, following the scan order planned
+//	by SMHROIScan.  Rows only move forward with INCV; within a row
+//	the column register is advanced by the gap to the next planned
+//	column.
+/*********************************************************************/
+
+template<class Pins> template<char ADCType,char UseAmp>
+void ArduEyeSMHChip<Pins>::readoutROICore(SMHROIScan &scan, char anain)
+{
+  unsigned char row,col,next;
+  short k,incs;
+  const SMHTiming tm=timing[(ADCType>=0)?ADCType:SMH1_ADCTYPE_ONBOARD];	//unknown ADC: onboard timing
+
+  for (row=scan.nextRow(); row!=SMH_ROI_END; row=scan.nextRow()) {
+
+    // Go to row, then first planned column of the row
+    setPointerValue(SMH_SYS_ROWSEL,row);
+    col=scan.nextCol();
+    setPointerValue(SMH_SYS_COLSEL,col);
+    incs=0;
+
+    while (col!=SMH_ROI_END) {
+
+      // settling delay
+      smhDelayUs(tm.settle1);
+
+      // pulse amplifier if needed
+      if (UseAmp) 
+        pulseInphi(tm.inphi);
+
+      // get data value
+      smhDelayUs(tm.settle2);
+
+      scan.store(SMHADC<ADCType,typename Pins::ADC_SS>::read(anain));
+
+      // go to next planned column
+      next=scan.nextCol();
+      if (next!=SMH_ROI_END) {
+        for (k=col; k<next; ++k)
+          Pins::INCV::pulse();
+        incs+=next-col;
+      }
+      col=next;
+    }
+
+    // account for the increments sent in this row
+    shadowIncrement(incs);
+  }
+}
+
+/*********************************************************************/
+//	readoutPixelCore
+//	Readout loop of getPixels.  Visits pixels[order[i]] for i=0..n-1,
+//	order being sorted by row then column, so setPointerValue only 
+//	sends forward INCV pulses except when returning to a lower column
+//	on a new row.  Each value is written to out[order[i]], i.e. in 
+//	the caller's order.
+/*********************************************************************/
+
+template<class Pins> template<char ADCType,char UseAmp>
+void ArduEyeSMHChip<Pins>::readoutPixelCore(const SMHPixel *pixels, const short *order, short n, short *out, char anain)
+{
+  short i,k;
+  const SMHTiming tm=timing[(ADCType>=0)?ADCType:SMH1_ADCTYPE_ONBOARD];	//unknown ADC: onboard timing
+
+  for (i=0; i<n; ++i) {
+    k=order[i];
+
+    // address pixel, shadows keep both moves forward where possible
+    setPointerValue(SMH_SYS_ROWSEL,pixels[k].row);
+    setPointerValue(SMH_SYS_COLSEL,pixels[k].col);
+
+    // settling delay
+    smhDelayUs(tm.settle1);
+
+    // pulse amplifier if needed
+    if (UseAmp) 
+      pulseInphi(tm.inphi);
+
+    // get data value
+    smhDelayUs(tm.settle2);
+
+    out[k] = SMHADC<ADCType,typename Pins::ADC_SS>::read(anain);
+  }
+}
+
+/*********************************************************************/
+//	readoutMultiCore
+//	Multi-chip version of readoutCore used by getImageMulti.  The
+//	RESP/INCP/RESV/INCV and INPHI lines are shared by all chips, so
+//	each pixel address is set up once and then every chip in 
+//	chipmask is sampled before moving on.  With an external ADC each
+//	chip is switched onto the ADC with setADCInput for its sample,
+//	the free-running onboard ADC is switched with readInput.
+/*********************************************************************/
+
+template<class Pins> template<char ADCType,char UseAmp>
+void ArduEyeSMHChip<Pins>::readoutMultiCore(short **imgs, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, unsigned char chipmask)
+{
+  short *pimg[SMH_MAX_CHIPS];	//output pointer for each chip
+  unsigned char row,col,k;
+  char chip;
+  const SMHTiming tm=timing[(ADCType>=0)?ADCType:SMH1_ADCTYPE_ONBOARD];	//unknown ADC: onboard timing
+
+  for (chip=0; chip<SMH_MAX_CHIPS; ++chip)
+    pimg[(unsigned char)chip] = imgs[(unsigned char)chip];
+
+  // Go to first row
+  setPointerValue(SMH_SYS_ROWSEL,rowstart);
+
+  // Loop through all rows
+  for (row=0; row<numrows; ++row) {
+
+    // Go to first column
+    setPointerValue(SMH_SYS_COLSEL,colstart);
+
+    // Loop through all columns
+    for (col=0; col<numcols; ++col) {
+
+      // settling delay
+      smhDelayUs(tm.settle1);
+
+      // pulse amplifier if needed, INPHI reaches all chips at once
+      if (UseAmp) 
+        pulseInphi(tm.inphi);
+
+      // get data value
+      smhDelayUs(tm.settle2);
+
+      // sample every enabled chip at this address
+      for (chip=0; chip<SMH_MAX_CHIPS; ++chip)
+      {
+        if (!(chipmask&(1<<chip)))
+          continue;
+
+        if (ADCType==SMH1_ADCTYPE_ONBOARD_FAST)
+          *pimg[(unsigned char)chip] = SMHADC_FreeRead<0>::readInput(chip);
+        else if (ADCType==SMH1_ADCTYPE_ONBOARD_FAST8)
+          *pimg[(unsigned char)chip] = SMHADC_FreeRead<1>::readInput(chip);
+        else if (ADCType==SMH1_ADCTYPE_ONBOARD)
+          *pimg[(unsigned char)chip] = SMHADC<ADCType,typename Pins::ADC_SS>::read(chip);
+        else
+        {
+          setADCInput(chip,1);	// switch chip onto external ADC
+          *pimg[(unsigned char)chip] = SMHADC<ADCType,typename Pins::ADC_SS>::read(chip);
+          setADCInput(chip,0);
+        }
+        pimg[(unsigned char)chip]++;
+      }
+
+      // go to next column
+      for (k=0; k<colskip; ++k)
+        Pins::INCV::pulse();
+    }
+
+    // account for the increments sent in this row
+    shadowIncrement((short)numcols*colskip);
+
+    setPointer(SMH_SYS_ROWSEL);
+    incValue(rowskip); // go to next row
+  }
+}
+
+#endif
@@ -0,0 +1,547 @@
+/* ARDUEYE_BENCHMARK_V1
+ 
+ This sketch measures how fast the ArduEye_SMH library reads pixels
+ from a Stonyman/Hawksbill vision chip.  Each benchmark prints its
+ result over serial in microseconds and CPU cycles per pixel, so 
+ changes to the readout code can be compared on real hardware.
+
+ Type "?" into the serial terminal for a list of benchmarks. 
+*/
+
+/*
+===============================================================================
+ Copyright (c) 2012 Centeye, Inc. 
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without 
+ modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, 
+ this list of conditions and the following disclaimer.
+ 
+ Redistributions in binary form must reproduce the above copyright notice, 
+ this list of conditions and the following disclaimer in the documentation 
+ and/or other materials provided with the distribution.
+ 
+ THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+ IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+ EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+ INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+ BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+ OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+ The views and conclusions contained in the software and documentation are 
+ those of the authors and should not be interpreted as representing official 
+ policies, either expressed or implied, of Centeye, Inc.
+ ===============================================================================
+ */
+
+//=============================================================================
+// INCLUDE FILES. The top two files are part of the ArduEye library and should
+// be included in the Arduino "libraries" folder.
+
+#include <ArduEye_SMH.h>  //Stonyman/Hawksbill vision chip library
+#include <ArduEye_GUI.h>  //ArduEye processing GUI interface
+#include <ArduEye_Prof.h> //per stage timing, see ARDUEYE_PROF
+#include <CYE_Images_v1.h>  //image support functions and frames
+
+#include <SPI.h>  //SPI library is needed to use an external ADC
+                  //not supported for MEGA 2560
+#include <EEPROM.h>  //EEPROM library is needed for stored profiles
+
+//==============================================================================
+// GLOBAL VARIABLES
+
+//benchmark window: a 16x16 block of raw pixels in the middle of the
+//Stonyman 112x112 array, small enough for the 328 memory
+#define BENCH_ROWS 16
+#define BENCH_COLS 16
+#define BENCH_PIXELS (BENCH_ROWS*BENCH_COLS)
+#define BENCH_START 48
+#define BENCH_FRAMES 10        //frames averaged per measurement
+
+short img[BENCH_PIXELS];       //1D image array
+short rowbuf[112];             //one Stonyman row for streaming readout
+
+long streamSum;                //sum of all streamed pixels
+int streamMinFree;             //least free RAM seen while streaming
+
+short chipSelect=0;            //which vision chip to read from
+
+// Command inputs - for receiving commands from user via Serial terminal
+char command; // command character
+int commandArgument; // argument of command
+
+//default ADC is the Arduino onboard ADC
+unsigned char adcType=SMH1_ADCTYPE_ONBOARD;
+
+
+//=======================================================================
+// ARDUINO SETUP AND LOOP FUNCTIONS
+
+void setup() 
+{
+  // initialize serial port
+  Serial.begin(115200); 
+  
+  //initialize SPI (needed for external ADC
+  SPI.begin();
+  
+  //initialize ArduEye Stonyman
+  ArduEyeSMH.begin();
+}
+
+void loop() 
+{
+  //process commands from serial (should be performed once every execution of loop())
+  processCommands();
+}
+
+
+//=======================================================================
+// FUNCTIONS DEFINED FOR THIS SKETCH
+
+// printResult prints the time per pixel of a benchmark in microseconds
+// and in CPU cycles
+void printResult(const char *name, unsigned long us, unsigned long pixels)
+{
+  unsigned long us100 = (us*100)/pixels;  //hundredths of a microsecond
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(us100/100);
+  Serial.print(".");
+  if ((us100%100)<10)
+    Serial.print("0");
+  Serial.print(us100%100);
+  Serial.print(" us/pixel, ");
+  Serial.print((us100*(F_CPU/1000000L))/100);
+  Serial.println(" cycles/pixel");
+}
+
+// legacyGetImage is the getImage loop as it was before the templated
+// readout core: a switch on the ADC type for every pixel.  It is kept
+// here only as the reference for the readout benchmark.
+void legacyGetImage(short *img, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char anain, char useAmp) 
+{
+  short *pimg = img;
+  short val;
+  unsigned char chigh,clow;
+  unsigned char row,col;
+
+  if (ADCType==SMH1_ADCTYPE_ONBOARD)
+    ArduEyeSMH.setAnalogInput(anain);
+  else
+  {
+    ArduEyeSMH.setADCInput(anain,1);
+    ADC_SS_PORT |= ADC_SS;
+  }
+
+  ArduEyeSMH.setPointerValue(SMH_SYS_ROWSEL,rowstart);
+  for (row=0; row<numrows; ++row) {
+    ArduEyeSMH.setPointerValue(SMH_SYS_COLSEL,colstart);
+    for (col=0; col<numcols; ++col) {
+      delayMicroseconds(1);
+      if (useAmp) 
+        ArduEyeSMH.pulseInphi(2);
+      delayMicroseconds(1);
+      switch (ADCType) 
+      {
+        case SMH1_ADCTYPE_ONBOARD:
+          val = analogRead(anain);
+          break;
+        case SMH1_ADCTYPE_MCP3001:
+          ADC_SS_PORT &= ~ADC_SS;
+          chigh=SPI.transfer(0);
+          clow=SPI.transfer(0);
+          val = ((short)(chigh&0x1F))<<5;
+          val += (clow&0xF8)>>3;
+          ADC_SS_PORT |= ADC_SS;
+          break;
+        case SMH1_ADCTYPE_MCP3201:
+        case SMH1_ADCTYPE_MCP3201_2:
+          ADC_SS_PORT &= ~ADC_SS;
+          chigh=SPI.transfer(0);
+          clow=SPI.transfer(0);
+          val = ((short)(chigh&0x1F))<<7;
+          val += (clow&0xFE)>>1;
+          ADC_SS_PORT |= ADC_SS;
+          break;
+        default:
+          val = 555;
+          break;
+      }
+      *pimg = val;
+      pimg++;
+      ArduEyeSMH.incValue(colskip);
+    }
+    ArduEyeSMH.setPointer(SMH_SYS_ROWSEL);
+    ArduEyeSMH.incValue(rowskip);
+  }
+
+  if (ADCType!=SMH1_ADCTYPE_ONBOARD)
+    ArduEyeSMH.setADCInput(anain,0);
+}
+
+// benchReadout compares the per-pixel cost of getImage against the
+// legacy loop with a per-pixel ADC switch
+void benchReadout()
+{
+  unsigned long t;
+  char i;
+
+  t=micros();
+  for (i=0; i<BENCH_FRAMES; ++i)
+    legacyGetImage(img,BENCH_START,BENCH_ROWS,1,BENCH_START,BENCH_COLS,1,adcType,chipSelect,0);
+  printResult("legacy loop",micros()-t,(unsigned long)BENCH_FRAMES*BENCH_PIXELS);
+
+  t=micros();
+  for (i=0; i<BENCH_FRAMES; ++i)
+    ArduEyeSMH.getImage(img,BENCH_START,BENCH_ROWS,1,BENCH_START,BENCH_COLS,1,adcType,chipSelect);
+  printResult("getImage",micros()-t,(unsigned long)BENCH_FRAMES*BENCH_PIXELS);
+
+  ArduEyeSMH.setPipelined(1);
+  t=micros();
+  for (i=0; i<BENCH_FRAMES; ++i)
+    ArduEyeSMH.getImage(img,BENCH_START,BENCH_ROWS,1,BENCH_START,BENCH_COLS,1,adcType,chipSelect);
+  printResult("getImage pipelined",micros()-t,(unsigned long)BENCH_FRAMES*BENCH_PIXELS);
+  ArduEyeSMH.setPipelined(0);
+}
+
+// benchModel prints the pixel rate predicted by the library timing 
+// model for every ADC type, without and with pipelining
+void benchModel()
+{
+  char type;
+
+  for (type=SMH1_ADCTYPE_ONBOARD; type<=SMH1_ADCTYPE_ONBOARD_FAST8; ++type)
+  {
+    Serial.print("ADC type ");
+    Serial.print((short)type);
+    Serial.print(": ");
+    Serial.print(ArduEyeSMH.predictPixelRate(type));
+    ArduEyeSMH.setPipelined(1);
+    Serial.print(" pixels/s, pipelined ");
+    Serial.print(ArduEyeSMH.predictPixelRate(type));
+    ArduEyeSMH.setPipelined(0);
+    Serial.println(" pixels/s");
+  }
+}
+
+// benchPrescaler characterizes the fast onboard ADC: for every 
+// prescaler it reads pairs of 8x16 frames from the same window and
+// prints the time per pixel and the temporal noise, the mean absolute
+// difference between the two frames in ADC counts.  The two halves of
+// img hold the frame pair.
+void benchPrescaler(char type)
+{
+  short *a = img;
+  short *b = img+BENCH_PIXELS/2;
+  unsigned long t,diff;
+  unsigned short div;
+  unsigned char i;
+  char f;
+
+  for (div=2; div<=128; div*=2)
+  {
+    ArduEyeSMH.setADCPrescaler(div);
+    diff=0;
+    t=0;
+    for (f=0; f<BENCH_FRAMES; ++f)
+    {
+      unsigned long t0=micros();
+      ArduEyeSMH.getImage(a,BENCH_START,BENCH_ROWS/2,1,BENCH_START,BENCH_COLS,1,type,chipSelect);
+      t+=micros()-t0;
+      ArduEyeSMH.getImage(b,BENCH_START,BENCH_ROWS/2,1,BENCH_START,BENCH_COLS,1,type,chipSelect);
+      for (i=0; i<BENCH_PIXELS/2; ++i)
+        diff += abs(a[i]-b[i]);
+    }
+
+    Serial.print("prescaler ");
+    Serial.print(div);
+    Serial.print(" noise = ");
+    Serial.print((diff*100)/((unsigned long)BENCH_FRAMES*BENCH_PIXELS/2));
+    Serial.println("/100 counts");
+    printResult("  getImage",t,(unsigned long)BENCH_FRAMES*BENCH_PIXELS/2);
+  }
+
+  ArduEyeSMH.setADCPrescaler(SMH_ADC_PRESCALER_DEFAULT);
+}
+
+// benchTiming calibrates the pixel timing profile of the current ADC
+// type on the benchmark window and prints the chosen delays and the
+// frame rate gain over the default profile.  The tolerance is in 
+// 1/16 ADC counts.  img holds the calibration scratch.
+void benchTiming(short tolerance)
+{
+  unsigned short gain;
+  SMHTiming t;
+
+  gain=ArduEyeSMH.calibrateTiming(adcType,chipSelect,BENCH_START,BENCH_START,tolerance,img);
+  t=ArduEyeSMH.getTiming(adcType);
+
+  Serial.print("settle1 = ");
+  Serial.print((short)t.settle1);
+  Serial.print(" us, inphi = ");
+  Serial.print((short)t.inphi);
+  Serial.print(" us, settle2 = ");
+  Serial.print((short)t.settle2);
+  Serial.println(" us");
+  Serial.print("frame rate gain = ");
+  Serial.print(gain);
+  Serial.println("%");
+}
+
+// lighting ramp recorded as the mean dark signal (ADC counts with
+// the amplifier bypassed) of a scene going from indoor light to a
+// window and back
+const short aeRamp[]={100,100,140,200,300,400,600,800,800,400,150,50,20,20,100};
+#define AE_RAMP_STEPS (sizeof(aeRamp)/sizeof(aeRamp[0]))
+#define AE_FRAMES 40           //frames simulated per ramp step
+
+// aeModel fills a histogram as the chip would for a scene of mean 
+// dark signal "light" with +-30% contrast, at the registers in ae.
+// The amplifier gain (x1 to x7) inverts the output.
+void aeModel(SMHExposure *ae, short light, unsigned short *hist)
+{
+  static const unsigned char gainx4[SMH_GAIN_MAX+1]={4,6,8,12,16,20,24,28};
+  unsigned char i;
+  long v;
+
+  for (i=0; i<SMH_AE_BINS; ++i)
+    hist[i]=0;
+  for (i=0; i<64; ++i)
+  {
+    v=(long)light*(70+i*60/63)/100;
+    v=300+(ae->vref-SMH_VREF_5V0)*12+(ae->aobias-SMH_AOBIAS_5V0)*4+v*gainx4[ae->gain]/4;
+    if (ae->gain)
+      v=1023-v;
+    v=constrain(v,0,1023);
+    hist[v>>5]++;
+  }
+}
+
+// benchExposure runs the auto exposure loop on the recorded lighting
+// ramp through aeModel and prints, per ramp step, the frames until 
+// the registers stop changing and the register writes, followed by
+// the cost of one autoExposureStep.  With live set it also times
+// autoExposure on the chip with an 8x8 binned pre-frame.
+void benchExposure(char live)
+{
+  unsigned short hist[SMH_AE_BINS];
+  SMHExposure ae;
+  unsigned long us=0,steps=0,t;
+  unsigned char r,f,converged,writes;
+  char changed;
+
+  ArduEyeSMH.autoExposureInit(&ae);
+  for (r=0; r<AE_RAMP_STEPS; ++r)
+  {
+    converged=0;
+    writes=0;
+    for (f=0; f<AE_FRAMES; ++f)
+    {
+      aeModel(&ae,aeRamp[r],hist);
+      t=micros();
+      changed=ArduEyeSMH.autoExposureStep(&ae,hist);
+      us+=micros()-t;
+      steps++;
+      if (changed)
+      {
+        converged=f+1;
+        writes++;
+      }
+    }
+    Serial.print("light ");
+    Serial.print(aeRamp[r]);
+    Serial.print(": settled after ");
+    Serial.print((short)converged);
+    Serial.print(" frames, ");
+    Serial.print((short)writes);
+    Serial.print(" writes, vref ");
+    Serial.print((short)ae.vref);
+    Serial.print(" aobias ");
+    Serial.print((short)ae.aobias);
+    Serial.print(" gain ");
+    Serial.println((short)ae.gain);
+  }
+  printResult("autoExposureStep",us,steps);
+
+  if (live)
+  {
+    ArduEyeSMH.autoExposureInit(&ae);
+    t=micros();
+    for (f=0; f<BENCH_FRAMES; ++f)
+      ArduEyeSMH.autoExposure(&ae,0,112,0,112,8,adcType,chipSelect);
+    t=micros()-t;
+    printResult("autoExposure (per frame)",t,BENCH_FRAMES);
+    ArduEyeSMH.setBiasesVdd(SMH1_VDD_5V0);
+    ArduEyeSMH.setAmpGain(SMH_GAIN_DEFAULT);
+  }
+}
+
+#if ARDUEYE_PROF
+// benchStages runs BENCH_FRAMES frames of acquisition, FPN correction
+// and GUI transmission and prints the per stage statistics collected
+// by ArduEye_Prof (only in a profiling build)
+void benchStages()
+{
+  unsigned char mask[BENCH_PIXELS];
+  short mask_base;
+  char i;
+
+  ArduEyeSMH.getImage(img,BENCH_START,BENCH_ROWS,1,BENCH_START,BENCH_COLS,1,adcType,chipSelect);
+  ArduEyeSMH.calcMask(img,BENCH_PIXELS,mask,&mask_base);
+
+  ArduEyeProf.reset();
+  for (i=0; i<BENCH_FRAMES; ++i)
+  {
+    ArduEyeSMH.getImage(img,BENCH_START,BENCH_ROWS,1,BENCH_START,BENCH_COLS,1,adcType,chipSelect);
+    ArduEyeSMH.applyMask(img,BENCH_PIXELS,mask,mask_base);
+    ArduEyeGUI.sendImage(BENCH_ROWS,BENCH_COLS,img,BENCH_PIXELS);
+    PROF_FRAME_END();
+  }
+  ArduEyeProf.printStats();
+}
+#endif
+
+// freeRam returns the number of bytes between the heap and the stack
+int freeRam()
+{
+  extern int __heap_start, *__brkval;
+  int v;
+  return (int)&v - (__brkval == 0 ? (int)&__heap_start : (int)__brkval);
+}
+
+// streamRow is called by getImageRows for every row.  It sums the row
+// and records the lowest free RAM seen, i.e. the peak RAM use.
+void streamRow(unsigned char row, short *pixels, unsigned char numcols)
+{
+  int f = freeRam();
+
+  for (unsigned char i=0; i<numcols; ++i)
+    streamSum += pixels[i];
+  if (f < streamMinFree)
+    streamMinFree = f;
+}
+
+// benchStream reads 28x28, 56x56 and the full 112x112 Stonyman with
+// getImageRows and prints time per pixel and peak RAM use.  The peak
+// should stay the same as the resolution grows since only one row 
+// buffer is used.
+void benchStream()
+{
+  unsigned long t;
+  unsigned char skip;
+
+  for (skip=4; skip>0; skip/=2)
+  {
+    unsigned char n = 112/skip;
+
+    streamSum = 0;
+    streamMinFree = freeRam();
+    t=micros();
+    ArduEyeSMH.getImageRows(rowbuf,0,n,skip,0,n,skip,adcType,chipSelect,streamRow);
+    t=micros()-t;
+
+    Serial.print(n);
+    Serial.print("x");
+    Serial.print(n);
+    Serial.print(" free RAM at peak = ");
+    Serial.print(streamMinFree);
+    Serial.print(", mean = ");
+    Serial.println(streamSum/((long)n*n));
+    printResult("  getImageRows",t,(unsigned long)n*n);
+  }
+}
+
+// the processCommands function reads and responds to commands sent to
+// the Arduino over the serial connection.  
+void processCommands()
+{
+  // PROCESS USER COMMANDS, IF ANY
+  if (Serial.available()>0) // Check Serial buffer for input from user
+  { 
+
+    // get user command and argument
+    ArduEyeGUI.getCommand(&command,&commandArgument); 
+
+    //switch statement to process commands
+    switch (command) 
+    {
+
+    //CHANGE ADC TYPE, argument is one of the SMH1_ADCTYPE values
+    case 'a':
+      adcType=commandArgument;
+      Serial.print("ADC type = ");
+      Serial.println((short)adcType);
+      break;
+
+    //auto exposure on the recorded ramp, argument 1 also on the chip
+    case 'e':
+      benchExposure(commandArgument);
+      break;
+
+#if ARDUEYE_PROF
+    //per stage timing (profiling build)
+    case 'f':
+      benchStages();
+      break;
+#endif
+
+    //streaming memory benchmark
+    case 'm':
+      benchStream();
+      break;
+
+    //fast onboard ADC prescaler sweep, argument 1 for 8 bit results
+    case 'n':
+      benchPrescaler(commandArgument ? SMH1_ADCTYPE_ONBOARD_FAST8 : SMH1_ADCTYPE_ONBOARD_FAST);
+      break;
+
+    //timing model
+    case 'p':
+      benchModel();
+      break;
+
+    //readout benchmark
+    case 'r':
+      benchReadout();
+      break;
+
+    //timing calibration, argument is the tolerance (default 16)
+    case 't':
+      benchTiming(commandArgument ? commandArgument : 16);
+      break;
+
+    //change chip select
+    case 's':
+      chipSelect=commandArgument;
+      Serial.print("chip select = ");
+      Serial.println(chipSelect);
+      break;
+
+    // ? - print up command list
+    case '?':
+        Serial.println("a: ADC type"); 
+        Serial.println("e: auto exposure (1 = also on chip)"); 
+#if ARDUEYE_PROF
+        Serial.println("f: per stage timing"); 
+#endif
+        Serial.println("m: streaming RAM benchmark"); 
+        Serial.println("n: fast ADC prescaler sweep (1 = 8 bit)"); 
+        Serial.println("p: predicted pixel rates"); 
+        Serial.println("r: readout benchmark"); 
+        Serial.println("s: chip select");
+        Serial.println("t: calibrate pixel timing (tolerance/16)");
+      break;
+      
+    default:
+      break;
+    }
+  }
+}
@@ -65,9 +65,12 @@
 
 #include <ArduEye_SMH.h>  //Stonyman/Hawksbill vision chip library
 #include <ArduEye_GUI.h>  //ArduEye processing GUI interface
+#include <ArduEye_Prof.h> //per stage timing, see ARDUEYE_PROF
+#include <CYE_Images_v1.h>  //image support functions and frames
 
 #include <SPI.h>  //SPI library is needed to use an external ADC
                   //not supported for MEGA 2560
+#include <EEPROM.h>  //EEPROM library is needed for stored profiles
 
 //==============================================================================
 // GLOBAL VARIABLES
@@ -308,6 +311,17 @@ void processCommands()
     case 'M':   
       ArduEyeSMH.chipToMatlab(0,adcType,chipSelect);
       break;
+
+    //send the current array over Serial as a packed binary dump
+    //(decode the capture with host/ArduEye_DumpDecode.cpp)
+    case 'd':
+      ArduEyeSMH.sectionToBinary(sr,row,skiprow,sc,col,skipcol,adcType,chipSelect);
+      break;
+
+    //send the entire chip over Serial as a packed binary dump
+    case 'D':
+      ArduEyeSMH.chipToBinary(0,adcType,chipSelect);
+      break;
       
     //change NBIAS
     case 'n': // set pinhole column
@@ -363,6 +377,8 @@ void processCommands()
         Serial.println("b: reset"); 
         Serial.println("c: cols"); 
         Serial.println("C: start col");
+        Serial.println("d: binary section");
+        Serial.println("D: binary all");
         Serial.println("g: amp gain"); 
         Serial.println("h: hor binning"); 
         Serial.println("f: FPN mask"); 
@@ -0,0 +1,192 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_Dump.cpp
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Host build: packed binary dump decoder, see ArduEye_Dump.h
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+#include <string.h>
+
+#include "ArduEye_Dump.h"
+
+/*********************************************************************/
+//	smhDumpDataSize
+//	Packed data bytes: whole groups of 4 pixels in 5 bytes (10 bits)
+//	or 2 pixels in 3 bytes (12 bits)
+/*********************************************************************/
+
+long smhDumpDataSize(const SMHDumpFrame *frame)
+{
+  long n=(long)frame->rows*frame->cols;
+
+  if (frame->bits==12)
+    return (n+1)/2*3;
+  return (n+3)/4*5;
+}
+
+/*********************************************************************/
+//	fletcher
+//	Fletcher-16 as computed by SMHPackSink
+/*********************************************************************/
+
+static unsigned short fletcher(const unsigned char *p, long n)
+{
+  unsigned short sum1=0,sum2=0;
+
+  while (n--)
+  {
+    sum1=(sum1+*p++)%255;
+    sum2=(sum2+sum1)%255;
+  }
+  return sum1|(sum2<<8);
+}
+
+/*********************************************************************/
+//	unpack
+//	Unpacks the pixels of one frame
+/*********************************************************************/
+
+static void unpack(const unsigned char *p, const SMHDumpFrame *frame, short *pixels)
+{
+  long n=(long)frame->rows*frame->cols;
+  long i;
+  int k;
+
+  if (frame->bits==12)
+  {
+    for (i=0; i<n; i+=2, p+=3)
+      for (k=0; k<2 && i+k<n; ++k)
+        pixels[i+k]=(p[k]<<4)|((p[2]>>(4*k))&15);
+  }
+  else
+  {
+    for (i=0; i<n; i+=4, p+=5)
+      for (k=0; k<4 && i+k<n; ++k)
+        pixels[i+k]=(p[k]<<2)|((p[4]>>(2*k))&3);
+  }
+}
+
+/*********************************************************************/
+//	smhDumpDecode
+/*********************************************************************/
+
+long smhDumpDecode(const unsigned char *buf, long len, SMHDumpFrame *frame, short *pixels, long maxpix, int *bad)
+{
+  long pos,size;
+  const unsigned char *h;
+
+  for (pos=0; pos+2+SMH_DUMP_HEADER<=len; ++pos)
+  {
+    if (buf[pos]!=SMH_DUMP_SYNC0 || buf[pos+1]!=SMH_DUMP_SYNC1)
+      continue;
+
+    h=buf+pos+2;
+    if (h[0]!=10 && h[0]!=12)
+      continue;
+    frame->bits=h[0];
+    frame->adctype=(signed char)h[1];
+    frame->rows=h[2];
+    frame->cols=h[3];
+    frame->rowstart=h[4];
+    frame->colstart=h[5];
+    frame->rowskip=h[6];
+    frame->colskip=h[7];
+
+    size=SMH_DUMP_HEADER+smhDumpDataSize(frame);
+    if (pos+2+size+2>len)
+      continue;		//truncated, or a false sync in text
+
+    if (fletcher(h,size)!=(h[size]|(h[size+1]<<8)) ||
+        (long)frame->rows*frame->cols>maxpix)
+    {
+      if (bad)
+        (*bad)++;
+      continue;
+    }
+
+    unpack(h+SMH_DUMP_HEADER,frame,pixels);
+    return pos+2+size+2;
+  }
+  return 0;
+}
+
+/*********************************************************************/
+//	Writers
+/*********************************************************************/
+
+static void put32(FILE *f, long v)
+{
+  fputc(v&0xFF,f);
+  fputc((v>>8)&0xFF,f);
+  fputc((v>>16)&0xFF,f);
+  fputc((v>>24)&0xFF,f);
+}
+
+void smhDumpWriteMat(FILE *f, const char *name, const SMHDumpFrame *frame, const short *pixels)
+{
+  unsigned char r,c;
+  double v;
+
+  // level 4 header: little-endian doubles (the host must be little-
+  // endian, as x86 and ARM are), full real matrix
+  put32(f,0);
+  put32(f,frame->rows);
+  put32(f,frame->cols);
+  put32(f,0);
+  put32(f,strlen(name)+1);
+  fwrite(name,1,strlen(name)+1,f);
+
+  // column-major
+  for (c=0; c<frame->cols; ++c)
+    for (r=0; r<frame->rows; ++r)
+    {
+      v=pixels[r*frame->cols+c];
+      fwrite(&v,sizeof(v),1,f);
+    }
+}
+
+void smhDumpWriteRaw(FILE *f, const SMHDumpFrame *frame, const short *pixels)
+{
+  long i,n=(long)frame->rows*frame->cols;
+
+  for (i=0; i<n; ++i)
+  {
+    fputc(pixels[i]&0xFF,f);
+    fputc((pixels[i]>>8)&0xFF,f);
+  }
+}
@@ -0,0 +1,78 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_Dump.h
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Host build: decoder of the packed binary dumps written by 
+//	chipToBinary and sectionToBinary (frame layout in ArduEye_SMH.h),
+//	and writers for Matlab (.mat level 4) and raw 16 bit files.
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+#ifndef _ARDUEYE_DUMP_H_INCLUDED
+#define _ARDUEYE_DUMP_H_INCLUDED
+
+#include <stdio.h>
+
+#include "ArduEye_SMH.h"
+
+//header of a decoded frame, as written by SMHPackSink::header
+struct SMHDumpFrame
+{
+  unsigned char bits;		//10 or 12
+  signed char adctype;		//ADC type used
+  unsigned char rows,cols;
+  unsigned char rowstart,colstart,rowskip,colskip;
+};
+
+//bytes of packed pixel data of a frame
+long smhDumpDataSize(const SMHDumpFrame *frame);
+
+//finds and decodes the first valid frame in buf.  pixels receives
+//rows*cols values raster-wise and must hold maxpix.  Returns the 
+//offset just past the frame, or 0 if buf holds no complete valid 
+//frame.  Frames with a bad checksum are skipped, *bad (if not NULL)
+//counts them.
+long smhDumpDecode(const unsigned char *buf, long len, SMHDumpFrame *frame, short *pixels, long maxpix, int *bad);
+
+//appends the frame as a rows x cols double matrix "name" to a 
+//level 4 .mat file (load in Matlab or Octave)
+void smhDumpWriteMat(FILE *f, const char *name, const SMHDumpFrame *frame, const short *pixels);
+
+//appends the frame as raster-wise 16 bit little-endian values
+void smhDumpWriteRaw(FILE *f, const SMHDumpFrame *frame, const short *pixels);
+
+#endif
@@ -0,0 +1,126 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_DumpDecode.cpp
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Host program: converts a serial capture holding binary dumps 
+//	(chipToBinary, sectionToBinary) to a Matlab .mat file with one 
+//	matrix per frame (Img1, Img2, ...), or to raw 16 bit 
+//	little-endian frames.  Text printed by the sketch around the 
+//	dumps is skipped.
+//
+//	Usage: dumpdecode [-raw] capture.bin output
+//
+//	Build from the repository root:
+//	g++ -O2 -DARDUINO=100 -IArduEye_SMH_v1/host -IArduEye_SMH_v1 
+//	  -IArduEye_Prof_v1 -ICYE_Images_v1 
+//	  ArduEye_SMH_v1/host/ArduEye_DumpDecode.cpp 
+//	  ArduEye_SMH_v1/host/ArduEye_Dump.cpp -o dumpdecode
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ArduEye_Dump.h"
+
+int main(int argc, char **argv)
+{
+  SMHDumpFrame frame;
+  static short pixels[256*256];
+  unsigned char *buf;
+  long len,pos,next;
+  int raw=0,bad=0,frames=0;
+  char name[16];
+  FILE *in,*out;
+
+  if (argc>1 && !strcmp(argv[1],"-raw"))
+  {
+    raw=1;
+    argc--;
+    argv++;
+  }
+  if (argc!=3)
+  {
+    fprintf(stderr,"usage: dumpdecode [-raw] capture.bin output\n");
+    return 2;
+  }
+
+  in=fopen(argv[1],"rb");
+  if (!in)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+  fseek(in,0,SEEK_END);
+  len=ftell(in);
+  fseek(in,0,SEEK_SET);
+  buf=(unsigned char *)malloc(len ? len : 1);
+  if (!buf || fread(buf,1,len,in)!=(size_t)len)
+  {
+    fprintf(stderr,"%s: read error\n",argv[1]);
+    return 1;
+  }
+  fclose(in);
+
+  out=fopen(argv[2],"wb");
+  if (!out)
+  {
+    perror(argv[2]);
+    return 1;
+  }
+
+  for (pos=0; (next=smhDumpDecode(buf+pos,len-pos,&frame,pixels,256*256,&bad))>0; pos+=next)
+  {
+    frames++;
+    if (raw)
+      smhDumpWriteRaw(out,&frame,pixels);
+    else
+    {
+      sprintf(name,"Img%d",frames);
+      smhDumpWriteMat(out,name,&frame,pixels);
+    }
+    fprintf(stderr,"frame %d: %dx%d at (%d,%d) skip (%d,%d), %d bits, ADC type %d\n",
+      frames,frame.rows,frame.cols,frame.rowstart,frame.colstart,
+      frame.rowskip,frame.colskip,frame.bits,frame.adctype);
+  }
+
+  fclose(out);
+  free(buf);
+  fprintf(stderr,"%d frames, %d with bad checksum\n",frames,bad);
+  return frames ? 0 : 1;
+}
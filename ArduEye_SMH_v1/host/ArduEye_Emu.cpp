@@ -0,0 +1,427 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_Emu.cpp
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Host build: Stonyman/Hawksbill chip emulator, see ArduEye_Emu.h
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+#include "ArduEye_Emu.h"
+
+SMHEmulator *SMHEmulator::attached[SMH_EMU_MAX];
+
+//emulator whose external ADC frame is being clocked out
+static SMHEmulator *spiChip=0;
+
+/*********************************************************************/
+//	smhEmuDefaultScene
+//	Scene used when none is set: a diagonal gradient with a bright 
+//	5x5 spot at row 40, col 70
+/*********************************************************************/
+
+static short smhEmuDefaultScene(unsigned char row, unsigned char col, void *arg)
+{
+  if (row>=38 && row<=42 && col>=68 && col<=72)
+    return 1000;
+  return (row+col)/2;
+}
+
+/*********************************************************************/
+//	Constructor
+/*********************************************************************/
+
+SMHEmulator::SMHEmulator(unsigned char size)
+{
+  chipsize=size;
+  anain=-1;
+  memset(line,0,sizeof(line));
+  ptr=0;
+  memset(regs,0,sizeof(regs));
+  amp=0;
+  fpn=0;
+  noise=0;
+  gainfpn=0;
+  extbits=12;
+  spicount=2;
+  scene=smhEmuDefaultScene;
+  scenearg=0;
+  sceneimg=0;
+  resetStats();
+}
+
+SMHEmulator::~SMHEmulator(void)
+{
+  detach();
+}
+
+/*********************************************************************/
+//	connect
+//	Registers the emulator with the host backend hooks
+/*********************************************************************/
+
+void SMHEmulator::connect(char a)
+{
+  unsigned char i;
+
+  detach();
+  anain=a;
+  for (i=0; i<SMH_EMU_MAX; ++i)
+    if (!attached[i])
+    {
+      attached[i]=this;
+      break;
+    }
+
+  smhHostSetPinHook(pinHook);
+  smhHostSetAnalogHook(analogHook);
+  smhHostSetConversionHook(conversionHook);
+  smhHostSetSPIHook(spiHook);
+  resetStats();
+}
+
+void SMHEmulator::detach(void)
+{
+  unsigned char i;
+
+  for (i=0; i<SMH_EMU_MAX; ++i)
+    if (attached[i]==this)
+      attached[i]=0;
+  if (spiChip==this)
+    spiChip=0;
+}
+
+/*********************************************************************/
+//	Scene and noise settings
+/*********************************************************************/
+
+void SMHEmulator::setScene(SMHEmuScene s, void *arg)
+{
+  scene=s ? s : smhEmuDefaultScene;
+  scenearg=arg;
+  sceneimg=0;
+}
+
+void SMHEmulator::setSceneImage(const short *img, unsigned char rows, unsigned char cols)
+{
+  sceneimg=img;
+  scenerows=rows;
+  scenecols=cols;
+}
+
+void SMHEmulator::setFPN(short amplitude)
+{
+  fpn=amplitude;
+}
+
+void SMHEmulator::setNoise(short amplitude)
+{
+  noise=amplitude;
+}
+
+void SMHEmulator::setGainFPN(short percent)
+{
+  gainfpn=percent;
+}
+
+void SMHEmulator::setExternalADC(char bits)
+{
+  extbits=(bits==10) ? 10 : 12;
+}
+
+/*********************************************************************/
+//	light, raw
+//	Scene light at a pixel, and the unamplified pixel output with its
+//	sensitivity, fixed pattern offset and the VREF shift
+/*********************************************************************/
+
+short SMHEmulator::light(unsigned char row, unsigned char col)
+{
+  if (sceneimg)
+    return sceneimg[(row*scenerows/chipsize)*scenecols+col*scenecols/chipsize];
+  return scene(row,col,scenearg);
+}
+
+short SMHEmulator::raw(unsigned char row, unsigned char col)
+{
+  long l=light(row,col);
+  short val;
+
+  if (gainfpn)
+  {
+    unsigned long h=((unsigned long)row*193+col*37+11)*2654435761UL;
+    l=l*(100+(short)((h>>16)%(2*gainfpn+1))-gainfpn)/100;
+  }
+  val=SMH_EMU_DARK-l/2;
+
+  if (fpn)
+  {
+    unsigned long h=((unsigned long)row*131+col*71+7)*2654435761UL;
+    val+=(short)((h>>16)%(2*fpn+1))-fpn;
+  }
+  val+=((short)regs[SMH_SYS_VREF]-SMH_VREF_5V0)*SMH_EMU_VREF_STEP;
+  return val;
+}
+
+/*********************************************************************/
+//	span
+//	Super pixel containing pos for switch register sw: bit k of sw 
+//	joins pixel k-1 and k (within each group of 8)
+/*********************************************************************/
+
+void SMHEmulator::span(unsigned short sw, unsigned char pos, unsigned char *first, unsigned char *last)
+{
+  unsigned char p;
+
+  p=pos;
+  while (p>0 && ((sw>>(p&7))&1))
+    p--;
+  *first=p;
+
+  p=pos;
+  while (p+1<chipsize && ((sw>>((p+1)&7))&1))
+    p++;
+  *last=p;
+}
+
+/*********************************************************************/
+//	output
+//	Chip output at a pixel: mean of the super pixel, through the 
+//	amplifier if CONFIG selects it, clipped to the 10 bit range
+/*********************************************************************/
+
+short SMHEmulator::output(unsigned char row, unsigned char col)
+{
+  unsigned char r0,r1,c0,c1,r,c;
+  unsigned short config=regs[SMH_SYS_CONFIG];
+  long sum=0;
+  short val;
+
+  if (row>=chipsize || col>=chipsize)
+    return SMH_EMU_DARK;
+
+  span(regs[SMH_SYS_VSW],row,&r0,&r1);
+  span(regs[SMH_SYS_HSW],col,&c0,&c1);
+  for (r=r0; r<=r1; ++r)
+    for (c=c0; c<=c1; ++c)
+      sum+=raw(r,c);
+  val=sum/((r1-r0+1)*(c1-c0+1));
+
+  if (config&8)	// amplifier selected
+    val=SMH_EMU_AMP_OFFSET+((config&7)+1)*(SMH_EMU_DARK-val)/2;
+
+  return constrain(val,0,1023);
+}
+
+/*********************************************************************/
+//	sample
+//	What an ADC reads: the addressed pixel, or with the amplifier 
+//	its output as of the last INPHI pulse
+/*********************************************************************/
+
+short SMHEmulator::sample(void)
+{
+  short val;
+
+  if (regs[SMH_SYS_CONFIG]&8)
+    val=amp;
+  else
+    val=output(regs[SMH_SYS_ROWSEL],regs[SMH_SYS_COLSEL]);
+
+  if (noise)
+    val=constrain(val+random(-noise,noise+1),0,1023);
+  return val;
+}
+
+/*********************************************************************/
+//	pins
+//	Applies a port transition to the chip
+/*********************************************************************/
+
+void SMHEmulator::pins(unsigned short port, unsigned char oldval, unsigned char newval)
+{
+  unsigned char rising=newval&~oldval;
+  unsigned char falling=oldval&~newval;
+  unsigned char i;
+  short val;
+
+  if ((port==line[SMH_EMU_RESP].port) && (rising&line[SMH_EMU_RESP].mask))
+  {
+    ptr=0;
+    st.resp++;
+  }
+  if ((port==line[SMH_EMU_INCP].port) && (rising&line[SMH_EMU_INCP].mask))
+  {
+    ptr++;
+    st.incp++;
+  }
+  if ((port==line[SMH_EMU_RESV].port) && (rising&line[SMH_EMU_RESV].mask))
+  {
+    if (ptr<SMH_SYS_NUMREGS)
+      regs[(unsigned char)ptr]=0;
+    st.resv++;
+  }
+  if ((port==line[SMH_EMU_INCV].port) && (rising&line[SMH_EMU_INCV].mask))
+  {
+    if (ptr<SMH_SYS_NUMREGS)	//8 bit registers wrap
+      regs[(unsigned char)ptr]=(regs[(unsigned char)ptr]+1)&0xFF;
+    st.incv++;
+  }
+  if ((port==line[SMH_EMU_INPHI].port) && (rising&line[SMH_EMU_INPHI].mask))
+  {
+    amp=output(regs[SMH_SYS_ROWSEL],regs[SMH_SYS_COLSEL]);
+    st.inphi++;
+  }
+
+  // external ADC: the chip whose ANALOG pin is driven high is 
+  // connected, or the first one if none is
+  if ((port==line[SMH_EMU_SS].port) && (falling&line[SMH_EMU_SS].mask))
+  {
+    SMHEmulator *sel=0;
+
+    for (i=0; i<SMH_EMU_MAX; ++i)
+    {
+      SMHEmulator *e=attached[i];
+      if (e && (smhHostPortRead(e->line[SMH_EMU_ANALOG].port)&e->line[SMH_EMU_ANALOG].mask))
+      {
+        sel=e;
+        break;
+      }
+    }
+    if (!sel)
+      for (i=0; i<SMH_EMU_MAX && !sel; ++i)
+        sel=attached[i];
+
+    if (sel==this)
+    {
+      val=sample();
+      if (extbits==12)
+      {
+        val<<=2;		// MCP3201: null bit, 12 bits, 1 spare
+        spibyte[0]=(val>>7)&0x1F;
+        spibyte[1]=(val<<1)&0xFF;
+      }
+      else
+      {
+        spibyte[0]=(val>>5)&0x1F;	// MCP3001: 10 bits, 3 spare
+        spibyte[1]=(val<<3)&0xFF;
+      }
+      spicount=0;
+      spiChip=this;
+      st.spiframes++;
+    }
+  }
+}
+
+/*********************************************************************/
+//	Host backend hooks
+/*********************************************************************/
+
+void SMHEmulator::pinHook(unsigned short port, unsigned char oldval, unsigned char newval)
+{
+  unsigned char i;
+
+  for (i=0; i<SMH_EMU_MAX; ++i)
+    if (attached[i])
+      attached[i]->pins(port,oldval,newval);
+}
+
+int SMHEmulator::analogHook(unsigned char pin)
+{
+  unsigned char i;
+
+  for (i=0; i<SMH_EMU_MAX; ++i)
+    if (attached[i] && attached[i]->anain==(char)pin)
+    {
+      attached[i]->st.samples++;
+      return attached[i]->sample();
+    }
+  return 0;
+}
+
+int SMHEmulator::conversionHook(unsigned char pin)
+{
+  unsigned char i;
+
+  for (i=0; i<SMH_EMU_MAX; ++i)
+    if (attached[i] && attached[i]->anain==(char)pin)
+    {
+      attached[i]->st.conversions++;
+      return attached[i]->sample();
+    }
+  return 0;
+}
+
+unsigned char SMHEmulator::spiHook(unsigned char out)
+{
+  if (!spiChip || spiChip->spicount>=2)
+    return 0;
+  return spiChip->spibyte[spiChip->spicount++];
+}
+
+/*********************************************************************/
+//	Statistics
+/*********************************************************************/
+
+const SMHEmuStats &SMHEmulator::stats(void)
+{
+  st.delayus=smhHostDelayTotal()-delaystart;
+  return st;
+}
+
+void SMHEmulator::resetStats(void)
+{
+  memset(&st,0,sizeof(st));
+  delaystart=smhHostDelayTotal();
+}
+
+/*********************************************************************/
+//	cycles
+//	Approximate ATmega cycles of the events since resetStats: pin 
+//	pulses, conversions, the delays of the library and a fixed loop
+//	overhead per sample.  Other arithmetic is not included, nor are
+//	the conversions of the ADC registers: that ADC runs beside the 
+//	code, the loop only waits for it (see smhHostCycles).
+/*********************************************************************/
+
+unsigned long SMHEmulator::cycles(void)
+{
+  stats();
+  return (st.resp+st.incp+st.resv+st.incv+st.inphi)*SMH_EMU_PULSE_CYCLES
+    + st.samples*(SMH_EMU_ANALOGREAD_CYCLES+SMH_EMU_SAMPLE_CYCLES)
+    + st.spiframes*(SMH_EMU_SPIFRAME_CYCLES+SMH_EMU_SAMPLE_CYCLES)
+    + st.delayus*SMH_EMU_DELAY_CYCLES;
+}
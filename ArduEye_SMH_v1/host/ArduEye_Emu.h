@@ -0,0 +1,207 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_Emu.h
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Host build: software model of a Stonyman (112x112) or Hawksbill
+//	(136x136) vision chip, attached to the simulated pins of the host
+//	backend so the unmodified ArduEye_SMH library drives it.
+//
+//	Emulated:
+//	- RESP/INCP/RESV/INCV pulses on the pointer and the 8 system
+//	  registers
+//	- COLSEL/ROWSEL addressing, HSW/VSW binning (bit k of the switch
+//	  register joins pixel k-1 and k of every group of 8, a binned
+//	  pixel reads as the mean of its super pixel)
+//	- VREF shifting the output, the amplifier (CONFIG selamp and 
+//	  gain) inverting and amplifying it; the amplifier output only
+//	  follows the pixel on an INPHI pulse
+//	- the onboard ADC (analogRead, or the free-running ADC registers
+//	  of the host backend) and the MCP3001/MCP3201 external ADCs 
+//	  (SPI, sampled on the falling edge of ADC SS)
+//
+//	Pixels come from a scene: a function or a recorded image.  Each 
+//	emulator counts the pulses and ADC samples it sees, and converts
+//	them to approximate ATmega cycles (see cycles()), so readout 
+//	strategies can be compared without the chip.
+//
+//	Not emulated: NBIAS/AOBIAS, settling and analog timing.
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+#ifndef _ARDUEYE_EMU_H_INCLUDED
+#define _ARDUEYE_EMU_H_INCLUDED
+
+#include "Arduino.h"
+#include "ArduEye_SMH.h"
+
+//chip sizes
+#define SMH_EMU_STONYMAN 112
+#define SMH_EMU_HAWKSBILL 136
+
+//emulators that can be attached at once
+#define SMH_EMU_MAX 4
+
+//output model, in 10 bit ADC counts: without the amplifier a pixel
+//reads SMH_EMU_DARK - light/2 (bright is low), VREF moves it by 
+//SMH_EMU_VREF_STEP per count.  The amplifier outputs
+//SMH_EMU_AMP_OFFSET + (gain+1)*(SMH_EMU_DARK-pixel)/2 (bright is high)
+#define SMH_EMU_DARK 800
+#define SMH_EMU_VREF_STEP 4
+#define SMH_EMU_AMP_OFFSET 100
+
+//approximate ATmega328 cycles per event, for cycles()
+#define SMH_EMU_PULSE_CYCLES 4		//sbi+cbi
+#define SMH_EMU_ANALOGREAD_CYCLES 1792	//112us analogRead
+#define SMH_EMU_SPIFRAME_CYCLES (2*(8*(F_CPU/SMH_SPI_CLOCK_HZ)+12)+8)	//2 SPI.transfer calls plus SS
+#define SMH_EMU_SAMPLE_CYCLES 36	//loop, read call and store per sample
+#define SMH_EMU_DELAY_CYCLES (F_CPU/1000000L)
+
+//scene: light (0-1023, bright is high) at a chip pixel
+typedef short (*SMHEmuScene)(unsigned char row, unsigned char col, void *arg);
+
+//events counted by an emulator
+struct SMHEmuStats
+{
+  unsigned long resp,incp,resv,incv,inphi;	//pulses
+  unsigned long samples;	//analogRead conversions
+  unsigned long spiframes;	//external ADC conversions
+  unsigned long conversions;	//conversions of the ADC registers
+  unsigned long delayus;	//delays of the library
+};
+
+/*********************************************************************/
+//	SMHEmulator
+/*********************************************************************/
+
+class SMHEmulator
+{
+public:
+  SMHEmulator(unsigned char size=SMH_EMU_STONYMAN);
+  ~SMHEmulator(void);
+
+  //connects the chip to the lines of a pin set; anain is the analog
+  //input (and ANALOG pin) of its output
+  template<class Pins> void attach(char anain)
+  {
+    line[SMH_EMU_RESP].set(Pins::RESP::port,Pins::RESP::mask);
+    line[SMH_EMU_INCP].set(Pins::INCP::port,Pins::INCP::mask);
+    line[SMH_EMU_RESV].set(Pins::RESV::port,Pins::RESV::mask);
+    line[SMH_EMU_INCV].set(Pins::INCV::port,Pins::INCV::mask);
+    line[SMH_EMU_INPHI].set(Pins::INPHI::port,Pins::INPHI::mask);
+    line[SMH_EMU_SS].set(Pins::ADC_SS::port,Pins::ADC_SS::mask);
+    switch (anain)
+    {
+      case 1: line[SMH_EMU_ANALOG].set(Pins::ANALOG1::port,Pins::ANALOG1::mask); break;
+      case 2: line[SMH_EMU_ANALOG].set(Pins::ANALOG2::port,Pins::ANALOG2::mask); break;
+      case 3: line[SMH_EMU_ANALOG].set(Pins::ANALOG3::port,Pins::ANALOG3::mask); break;
+      default: line[SMH_EMU_ANALOG].set(Pins::ANALOG0::port,Pins::ANALOG0::mask); break;
+    }
+    connect(anain);
+  }
+  void detach(void);
+
+  //scene as a function, or a recorded image stretched over the chip
+  void setScene(SMHEmuScene scene, void *arg);
+  void setSceneImage(const short *img, unsigned char rows, unsigned char cols);
+
+  //fixed pattern noise (per pixel offsets up to +-amplitude) and 
+  //random noise per sample, both 0 by default
+  void setFPN(short amplitude);
+  void setNoise(short amplitude);
+
+  //per pixel sensitivity, up to +-percent of the light, 0 by default
+  void setGainFPN(short percent);
+
+  //resolution of the external ADC: 10 (MCP3001) or 12 (MCP3201)
+  void setExternalADC(char bits);
+
+  //chip state
+  unsigned char size(void) const { return chipsize; }
+  char pointer(void) const { return ptr; }
+  unsigned short reg(char r) const { return regs[(unsigned char)r&7]; }
+
+  //value the chip outputs at a pixel with the current registers
+  short output(unsigned char row, unsigned char col);
+
+  //value it outputs at the addressed pixel (what an ADC would read)
+  short sample(void);
+
+  //event counts since the last resetStats, and their cost in cycles
+  const SMHEmuStats &stats(void);
+  void resetStats(void);
+  unsigned long cycles(void);
+
+private:
+  enum { SMH_EMU_RESP, SMH_EMU_INCP, SMH_EMU_RESV, SMH_EMU_INCV, SMH_EMU_INPHI, SMH_EMU_SS, SMH_EMU_ANALOG, SMH_EMU_NUMLINES };
+
+  struct Line
+  {
+    unsigned short port;
+    unsigned char mask;
+    void set(unsigned short p,unsigned char m) { port=p; mask=m; }
+  };
+
+  unsigned char chipsize;
+  char anain;
+  Line line[SMH_EMU_NUMLINES];
+  char ptr;
+  unsigned short regs[SMH_SYS_NUMREGS];
+  short amp;			//amplifier output, set on INPHI
+  short fpn,noise,gainfpn;
+  char extbits;
+  unsigned char spibyte[2],spicount;
+  SMHEmuScene scene;
+  void *scenearg;
+  const short *sceneimg;
+  unsigned char scenerows,scenecols;
+  SMHEmuStats st;
+  unsigned long delaystart;
+
+  void connect(char anain);
+  short light(unsigned char row, unsigned char col);
+  short raw(unsigned char row, unsigned char col);
+  void span(unsigned short sw, unsigned char pos, unsigned char *first, unsigned char *last);
+  void pins(unsigned short port, unsigned char oldval, unsigned char newval);
+
+  static SMHEmulator *attached[SMH_EMU_MAX];
+  static void pinHook(unsigned short port, unsigned char oldval, unsigned char newval);
+  static int analogHook(unsigned char pin);
+  static int conversionHook(unsigned char pin);
+  static unsigned char spiHook(unsigned char out);
+};
+
+#endif
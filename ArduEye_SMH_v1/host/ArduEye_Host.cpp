@@ -0,0 +1,538 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_Host.cpp
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Host backend: the Arduino functions declared in host/Arduino.h, 
+//	SPI.h and EEPROM.h, the simulated ports of the host pin set
+//	(ArduEye_SMH_Pins.h), which record every pin transition, and the
+//	ADC registers, which convert on a count of board cycles.
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+#include <stdio.h>
+#include <time.h>
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "EEPROM.h"
+#include "ArduEye_SMH_Pins.h"
+
+HostSerial Serial;
+HostSPI SPI;
+HostEEPROM EEPROM;
+
+//approximate ATmega328 cycles per operation, for the board cycles
+#define SMH_HOST_PORT_CYCLES 2		//out, sbi or cbi
+#define SMH_HOST_ADCREG_CYCLES 2	//lds or sts of an ADC register
+#define SMH_HOST_ANALOGREAD_CYCLES 1792	//112us analogRead
+
+static unsigned long long hostCycles=0;	//board cycles
+static void hostADCRun(void);
+
+/*********************************************************************/
+/*********************************************************************/
+//	Simulated ports
+/*********************************************************************/
+/*********************************************************************/
+
+static unsigned char hostPorts[SMH_HOST_NUMPORTS];
+static unsigned long hostEdges[SMH_HOST_NUMPORTS][8];
+static SMHHostPinHook hostPinHook=0;
+
+unsigned char smhHostPortRead(unsigned short port)
+{
+  return (port<SMH_HOST_NUMPORTS) ? hostPorts[port] : 0;
+}
+
+/*********************************************************************/
+//	smhHostPortWrite
+//	Writes a port, counts the rising edges of its pins and hands the
+//	transition to the pin hook
+/*********************************************************************/
+
+void smhHostPortWrite(unsigned short port, unsigned char val)
+{
+  unsigned char old,rising,bit;
+
+  if (port>=SMH_HOST_NUMPORTS)
+    return;
+
+  // the ADC converts up to the write, then sees the new value
+  hostCycles+=SMH_HOST_PORT_CYCLES;
+  hostADCRun();
+
+  old=hostPorts[port];
+  hostPorts[port]=val;
+  if (old==val)
+    return;
+
+  rising=val&~old;
+  for (bit=0; bit<8; ++bit)
+    if (rising&(1<<bit))
+      hostEdges[port][bit]++;
+
+  if (hostPinHook)
+    hostPinHook(port,old,val);
+}
+
+/*********************************************************************/
+//	smhHostEdges
+//	Rising edges (pulses) of the pins in mask since the last reset,
+//	e.g. smhHostEdges(SMHPinsHost::INCV::port,SMHPinsHost::INCV::mask)
+/*********************************************************************/
+
+unsigned long smhHostEdges(unsigned short port, unsigned char mask)
+{
+  unsigned long sum=0;
+  unsigned char bit;
+
+  if (port>=SMH_HOST_NUMPORTS)
+    return 0;
+  for (bit=0; bit<8; ++bit)
+    if (mask&(1<<bit))
+      sum+=hostEdges[port][bit];
+  return sum;
+}
+
+void smhHostResetEdges(void)
+{
+  memset(hostEdges,0,sizeof(hostEdges));
+}
+
+void smhHostSetPinHook(SMHHostPinHook hook)
+{
+  hostPinHook=hook;
+}
+
+/*********************************************************************/
+/*********************************************************************/
+//	Time
+/*********************************************************************/
+/*********************************************************************/
+
+static unsigned long long hostDelayUs=0;	//sum of all delays
+
+static unsigned long long hostNowUs(void)
+{
+  static unsigned long long start=0;
+  struct timespec ts;
+  unsigned long long now;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  now=(unsigned long long)ts.tv_sec*1000000ULL+ts.tv_nsec/1000;
+  if (!start)
+    start=now;
+  return now-start;
+}
+
+unsigned long micros(void)
+{
+  return (unsigned long)(hostNowUs()+hostDelayUs);
+}
+
+unsigned long millis(void)
+{
+  return micros()/1000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  hostDelayUs+=us;
+  hostCycles+=(unsigned long long)us*(F_CPU/1000000L);
+}
+
+void delay(unsigned long ms)
+{
+  hostDelayUs+=(unsigned long long)ms*1000;
+  hostCycles+=(unsigned long long)ms*(F_CPU/1000L);
+}
+
+unsigned long smhHostDelayTotal(void)
+{
+  return (unsigned long)hostDelayUs;
+}
+
+unsigned long smhHostCycles(void)
+{
+  return (unsigned long)hostCycles;
+}
+
+void smhHostAddCycles(unsigned long cycles)
+{
+  hostCycles+=cycles;
+}
+
+/*********************************************************************/
+/*********************************************************************/
+//	Analog input, random numbers
+/*********************************************************************/
+/*********************************************************************/
+
+static SMHHostAnalogHook hostAnalogHook=0;
+
+void smhHostSetAnalogHook(SMHHostAnalogHook hook)
+{
+  hostAnalogHook=hook;
+}
+
+int analogRead(uint8_t pin)
+{
+  hostCycles+=SMH_HOST_ANALOGREAD_CYCLES;
+  return hostAnalogHook ? hostAnalogHook(pin) : 0;
+}
+
+long random(long howbig)
+{
+  if (howbig<=0)
+    return 0;
+  return rand()%howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+  if (howsmall>=howbig)
+    return howsmall;
+  return howsmall+random(howbig-howsmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+  srand(seed);
+}
+
+/*********************************************************************/
+/*********************************************************************/
+//	ADC registers
+/*********************************************************************/
+/*********************************************************************/
+
+enum { SMH_HOST_ADCSRA, SMH_HOST_ADCSRB, SMH_HOST_ADMUX, SMH_HOST_ADCL, SMH_HOST_ADCH };
+
+HostADCRegister smhHostADCSRA(SMH_HOST_ADCSRA);
+HostADCRegister smhHostADCSRB(SMH_HOST_ADCSRB);
+HostADCRegister smhHostADMUX(SMH_HOST_ADMUX);
+HostADCRegister smhHostADCL(SMH_HOST_ADCL);
+HostADCRegister smhHostADCH(SMH_HOST_ADCH);
+HostADCWord smhHostADCW;
+
+static SMHHostAnalogHook hostConversionHook=0;
+
+static struct
+{
+  unsigned char sra,srb,mux;	//as written, ADIF in sra
+  unsigned short data;		//ADCH:ADCL
+  char busy,sampled,first;	//converting, input sampled, 25 clocks
+  unsigned long long sh,end;	//sample/hold and end of conversion
+  int sample;
+} hostADC={_BV(ADEN)|_BV(ADPS2)|_BV(ADPS1)|_BV(ADPS0),0,0,0,0,0,1,0,0,0};	//as the Arduino core leaves it
+
+void smhHostSetConversionHook(SMHHostAnalogHook hook)
+{
+  hostConversionHook=hook;
+}
+
+/*********************************************************************/
+//	hostADCStart
+//	Starts a conversion at board cycle at
+/*********************************************************************/
+
+static void hostADCStart(unsigned long long at)
+{
+  unsigned long div=(hostADC.sra&7) ? 1UL<<(hostADC.sra&7) : 2;
+
+  hostADC.busy=1;
+  hostADC.sampled=0;
+  hostADC.sh=at+(hostADC.first ? 27 : 3)*div/2;
+  hostADC.end=at+(hostADC.first ? 25 : 13)*div;
+  hostADC.first=0;
+}
+
+/*********************************************************************/
+//	hostADCRun
+//	Runs the ADC up to the current board cycle: samples the input at
+//	the sample/hold point of each conversion, stores the result and 
+//	sets ADIF at its end and, free running, starts the next one
+/*********************************************************************/
+
+static void hostADCRun(void)
+{
+  unsigned char ch;
+  int val;
+
+  while (hostADC.busy)
+  {
+    if (!hostADC.sampled)
+    {
+      if (hostCycles<hostADC.sh)
+        return;
+      ch=hostADC.mux&0x07;
+      if (hostConversionHook)
+        hostADC.sample=hostConversionHook(ch);
+      else
+        hostADC.sample=hostAnalogHook ? hostAnalogHook(ch) : 0;
+      hostADC.sampled=1;
+    }
+    if (hostCycles<hostADC.end)
+      return;
+
+    val=hostADC.sample;
+    val=(val<0) ? 0 : (val>1023) ? 1023 : val;
+    hostADC.data=(hostADC.mux&_BV(ADLAR)) ? val<<6 : val;
+    hostADC.sra|=_BV(ADIF);
+    if ((hostADC.sra&_BV(ADATE)) && !(hostADC.srb&0x07))
+      hostADCStart(hostADC.end);	//free running
+    else
+      hostADC.busy=0;
+  }
+}
+
+HostADCRegister::operator uint8_t() const
+{
+  hostCycles+=SMH_HOST_ADCREG_CYCLES;
+  hostADCRun();
+  switch (reg)
+  {
+    case SMH_HOST_ADCSRA: return hostADC.sra|(hostADC.busy ? _BV(ADSC) : 0);
+    case SMH_HOST_ADCSRB: return hostADC.srb;
+    case SMH_HOST_ADMUX: return hostADC.mux;
+    case SMH_HOST_ADCL: return hostADC.data&0xFF;
+    default: return hostADC.data>>8;
+  }
+}
+
+HostADCRegister &HostADCRegister::operator=(uint8_t val)
+{
+  hostCycles+=SMH_HOST_ADCREG_CYCLES;
+  hostADCRun();
+  switch (reg)
+  {
+    case SMH_HOST_ADCSRA:
+      if (!(hostADC.sra&_BV(ADEN)) && (val&_BV(ADEN)))
+        hostADC.first=1;
+      if (val&_BV(ADIF))	//a one clears the flag
+        hostADC.sra&=~_BV(ADIF);
+      hostADC.sra=(val&~(_BV(ADSC)|_BV(ADIF)))|(hostADC.sra&_BV(ADIF));
+      if (!(val&_BV(ADEN)))
+        hostADC.busy=0;
+      else if ((val&_BV(ADSC)) && !hostADC.busy)
+        hostADCStart(hostCycles);
+      break;
+    case SMH_HOST_ADCSRB: hostADC.srb=val; break;
+    case SMH_HOST_ADMUX: hostADC.mux=val; break;
+    default: break;	//ADCL and ADCH are read only
+  }
+  return *this;
+}
+
+HostADCWord::operator uint16_t() const
+{
+  hostCycles+=SMH_HOST_ADCREG_CYCLES;
+  hostADCRun();
+  return hostADC.data;
+}
+
+/*********************************************************************/
+/*********************************************************************/
+//	Serial
+/*********************************************************************/
+/*********************************************************************/
+
+size_t HostSerial::sent(long n)
+{
+  if (n>0)
+    hostCycles+=(unsigned long long)n*10*F_CPU/(baud ? baud : 115200);
+  return (n>0) ? n : 0;
+}
+
+int HostSerial::available(void)
+{
+  return (input && *input) ? strlen(input) : 0;
+}
+
+int HostSerial::read(void)
+{
+  if (!input || !*input)
+    return -1;
+  return (unsigned char)*input++;
+}
+
+void HostSerial::flush(void)
+{
+  fflush(stream());
+}
+
+void HostSerial::queueInput(const char *str)
+{
+  input=str;
+}
+
+void HostSerial::setOutput(FILE *f)
+{
+  out=f;
+}
+
+size_t HostSerial::write(uint8_t c)
+{
+  fputc(c,stream());
+  return sent(1);
+}
+
+size_t HostSerial::write(const uint8_t *buf, size_t n)
+{
+  return sent(fwrite(buf,1,n,stream()));
+}
+
+void HostSerial::print(const char *str)
+{
+  fputs(str,stream());
+  sent(strlen(str));
+}
+
+void HostSerial::print(char c)
+{
+  fputc(c,stream());
+  sent(1);
+}
+
+void HostSerial::print(unsigned char n, int base)
+{
+  print((unsigned long)n,base);
+}
+
+void HostSerial::print(int n, int base)
+{
+  print((long)n,base);
+}
+
+void HostSerial::print(unsigned int n, int base)
+{
+  print((unsigned long)n,base);
+}
+
+void HostSerial::print(long n, int base)
+{
+  if (base==HEX)
+    sent(fprintf(stream(),"%lX",(unsigned long)n));
+  else
+    sent(fprintf(stream(),"%ld",n));
+}
+
+void HostSerial::print(unsigned long n, int base)
+{
+  sent(fprintf(stream(),(base==HEX) ? "%lX" : "%lu",n));
+}
+
+void HostSerial::print(double n, int digits)
+{
+  sent(fprintf(stream(),"%.*f",digits,n));
+}
+
+void HostSerial::println(void)
+{
+  fputs("\r\n",stream());
+  sent(2);
+}
+
+/*********************************************************************/
+/*********************************************************************/
+//	SPI, EEPROM
+/*********************************************************************/
+/*********************************************************************/
+
+static SMHHostSPIHook hostSPIHook=0;
+
+void smhHostSetSPIHook(SMHHostSPIHook hook)
+{
+  hostSPIHook=hook;
+}
+
+uint8_t HostSPI::transfer(uint8_t data)
+{
+  return hostSPIHook ? hostSPIHook(data) : 0;
+}
+
+static uint8_t hostEEPROM[SMH_HOST_EEPROM_SIZE];
+static char hostEEPROMInit=0;
+static FILE *hostEEPROMFile=0;
+
+char smhHostEEPROMFile(const char *path)
+{
+  if (hostEEPROMFile)
+    fclose(hostEEPROMFile);
+  memset(hostEEPROM,0xFF,sizeof(hostEEPROM));
+  hostEEPROMInit=1;
+
+  hostEEPROMFile=fopen(path,"r+b");
+  if (hostEEPROMFile)
+    fread(hostEEPROM,1,sizeof(hostEEPROM),hostEEPROMFile);
+  else
+    hostEEPROMFile=fopen(path,"w+b");
+  if (!hostEEPROMFile)
+    return 0;
+
+  // a short or new file is padded with erased cells
+  fseek(hostEEPROMFile,0,SEEK_SET);
+  fwrite(hostEEPROM,1,sizeof(hostEEPROM),hostEEPROMFile);
+  fflush(hostEEPROMFile);
+  return 1;
+}
+
+uint8_t HostEEPROM::read(int address)
+{
+  if (!hostEEPROMInit)
+  {
+    memset(hostEEPROM,0xFF,sizeof(hostEEPROM));
+    hostEEPROMInit=1;
+  }
+  if (address<0 || address>=SMH_HOST_EEPROM_SIZE)
+    return 0xFF;
+  return hostEEPROM[address];
+}
+
+void HostEEPROM::write(int address, uint8_t value)
+{
+  read(0);	// erase on first use
+  if (address<0 || address>=SMH_HOST_EEPROM_SIZE)
+    return;
+  hostEEPROM[address]=value;
+  if (hostEEPROMFile)
+  {
+    fseek(hostEEPROMFile,address,SEEK_SET);
+    fputc(value,hostEEPROMFile);
+    fflush(hostEEPROMFile);
+  }
+}
@@ -0,0 +1,1098 @@
+/*********************************************************************/
+/*********************************************************************/
+//	ArduEye_HostBench.cpp
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Host program: runs the ArduEye_SMH library against the chip 
+//	emulator.  First checks that the acquisition functions return
+//	what the emulated chip outputs, then prints the pulses, ADC 
+//	samples and approximate ATmega cycles per frame of each readout
+//	strategy, next to the cycles per pixel predictPixelRate models.
+//	Exits with 1 if a check fails.
+//
+//	Build from the repository root:
+//	g++ -O2 -DARDUINO=100 -IArduEye_SMH_v1/host -IArduEye_SMH_v1 
+//	  -IArduEye_Prof_v1 -ICYE_Images_v1 
+//	  ArduEye_SMH_v1/host/ArduEye_HostBench.cpp 
+//	  ArduEye_SMH_v1/host/ArduEye_Emu.cpp 
+//	  ArduEye_SMH_v1/host/ArduEye_Dump.cpp 
+//	  ArduEye_SMH_v1/host/ArduEye_Host.cpp 
+//	  ArduEye_SMH_v1/ArduEye_SMH.cpp ArduEye_Prof_v1/ArduEye_Prof.cpp 
+//	  CYE_Images_v1/CYE_Images_v1.cpp -lpthread -o hostbench
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+#include <stdio.h>
+
+#include "Arduino.h"
+#include "ArduEye_SMH.h"
+#include "ArduEye_Emu.h"
+#include "ArduEye_Dump.h"
+#include "EEPROM.h"
+
+#define CHIP SMH_EMU_STONYMAN
+
+SMHEmulator emu(CHIP);
+short img[CHIP*CHIP];
+int failures=0;
+
+/*********************************************************************/
+//	check
+//	Compares an acquired window with the emulator output, scaled as
+//	the ADC type reports it
+/*********************************************************************/
+
+void check(const char *name, const short *got, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char shift)
+{
+  unsigned char r,c;
+  short want;
+  int bad=0;
+
+  for (r=0; r<numrows; ++r)
+    for (c=0; c<numcols; ++c)
+    {
+      want=emu.output(rowstart+r*rowskip,colstart+c*colskip);
+      want=(shift>=0) ? want<<shift : want>>-shift;
+      if (got[r*numcols+c]!=want)
+        bad++;
+    }
+
+  printf("%-32s %s",name,bad ? "FAIL" : "ok");
+  if (bad)
+    printf(" (%d pixels differ)",bad);
+  printf("\n");
+  failures+=bad ? 1 : 0;
+}
+
+/*********************************************************************/
+//	report
+//	Prints the events counted since the last resetStats.  For a full
+//	width window read with ADCType, also the cycles per pixel that 
+//	predictPixelRate models, which must be within SMH_BENCH_MODEL_TOL
+//	percent of the emulated count.
+/*********************************************************************/
+
+#define SMH_BENCH_MODEL_TOL 10
+
+void report(const char *name, unsigned long pixels, char ADCType=SMH1_ADCTYPE_UNKNOWN)
+{
+  const SMHEmuStats &st=emu.stats();
+  unsigned long pulses=st.resp+st.incp+st.resv+st.incv+st.inphi;
+  unsigned long cycles=emu.cycles();
+  unsigned long perpix=pixels ? cycles/pixels : 0;
+  unsigned long model;
+  char bad;
+
+  printf("%-32s %6lu %8lu %8lu %10lu %8lu",name,pixels,pulses,st.samples+st.spiframes,cycles,perpix);
+  if (ADCType!=SMH1_ADCTYPE_UNKNOWN)
+  {
+    model=F_CPU/ArduEyeSMH.predictPixelRate(ADCType);
+    bad=(labs((long)perpix-(long)model)*100>(long)model*SMH_BENCH_MODEL_TOL);
+    printf(" %8lu%s",model,bad ? " FAIL" : "");
+    failures+=bad;
+  }
+  else
+    printf(" %8s","-");
+  printf("\n");
+  emu.resetStats();
+}
+
+/*********************************************************************/
+//	checkDump
+//	Writes a binary dump through Serial to a file, decodes it and 
+//	compares it with the emulator output
+/*********************************************************************/
+
+void checkDump(const char *name, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, char shift)
+{
+  static unsigned char buf[32768];
+  SMHDumpFrame frame;
+  FILE *f=tmpfile();
+  long len;
+
+  Serial.setOutput(f);
+  Serial.println("text before the dump");
+  ArduEyeSMH.sectionToBinary(rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,0);
+  Serial.setOutput(0);
+  rewind(f);
+  len=fread(buf,1,sizeof(buf),f);
+  fclose(f);
+
+  if (!smhDumpDecode(buf,len,&frame,img,CHIP*CHIP,0) || frame.rows!=numrows || frame.cols!=numcols)
+  {
+    printf("%-32s FAIL (no frame)\n",name);
+    failures++;
+    return;
+  }
+  check(name,img,rowstart,numrows,rowskip,colstart,numcols,colskip,shift);
+}
+
+/*********************************************************************/
+//	checkPacked
+//	Acquires into a packed frame, unpacks it row by row and compares
+//	it with the emulator output
+/*********************************************************************/
+
+void checkPacked(const char *name, unsigned char format, unsigned char rowstart, unsigned char numrows, unsigned char colstart, unsigned char numcols, char ADCType, char shift)
+{
+  static unsigned char buf[CYE_PACK12_BYTES(CHIP,CHIP)];
+  CYE_Frame frame;
+  unsigned char r;
+
+  CYE_FrameInit(&frame,buf,numrows,numcols,format);
+  ArduEyeSMH.getImage(&frame,rowstart,1,colstart,1,ADCType,0);
+  for (r=0; r<numrows; ++r)
+    CYE_FrameGetRow(&frame,r,img+r*numcols);
+  check(name,img,rowstart,numrows,1,colstart,numcols,1,shift);
+}
+
+/*********************************************************************/
+//	checkPackRows
+//	CYE_Pack10/12 and CYE_Unpack10/12 round trips for every row length
+//	up to 255, with values outside the range to check the clamping
+/*********************************************************************/
+
+void checkPackRows(void)
+{
+  short src[255],got[255];
+  unsigned char buf[CYE_PACK12_ROWBYTES(255)];
+  unsigned short n,i;
+  int bad=0;
+
+  for (i=0; i<255; ++i)
+    src[i]=(i*1237)%4200-50;
+  for (n=1; n<=255; ++n)
+  {
+    CYE_Pack10(src,buf,n);
+    CYE_Unpack10(buf,got,n);
+    for (i=0; i<n; ++i)
+      bad+=got[i]!=constrain(src[i],0,1023);
+    CYE_Pack12(src,buf,n);
+    CYE_Unpack12(buf,got,n);
+    for (i=0; i<n; ++i)
+      bad+=got[i]!=constrain(src[i],0,4095);
+  }
+
+  printf("%-32s %s\n","pack rows 1..255 pixels",bad ? "FAIL" : "ok");
+  failures+=bad ? 1 : 0;
+}
+
+/*********************************************************************/
+//	checkMaskPacked
+//	applyMask on a packed frame wider than CYE_PACK_MAXCOLS, which is
+//	unpacked in pieces, against the same arithmetic on its pixels
+/*********************************************************************/
+
+void checkMaskPacked(void)
+{
+  static unsigned char buf[CYE_PACK10_BYTES(6,150)],mask[6*150];
+  static short src[6*150],got[150];
+  CYE_Frame frame;
+  short want;
+  unsigned short i;
+  unsigned char r,c;
+  int bad=0;
+
+  CYE_FrameInit(&frame,buf,6,150,CYE_FRAME_PACK10);
+  for (i=0; i<6*150; ++i)
+  {
+    src[i]=(i*29)%1024;
+    mask[i]=(i*7)%200;
+  }
+  for (r=0; r<6; ++r)
+    CYE_FramePutRow(&frame,r,src+r*150);
+  ArduEyeSMH.applyMask(&frame,mask,300);
+
+  for (r=0; r<6; ++r)
+  {
+    CYE_FrameGetRow(&frame,r,got);
+    for (c=0; c<150; ++c)
+    {
+      want=constrain(1023-(src[r*150+c]-300-mask[r*150+c]),0,1023);
+      bad+=got[c]!=want;
+    }
+  }
+
+  printf("%-32s %s\n","applyMask packed 150 columns",bad ? "FAIL" : "ok");
+  failures+=bad ? 1 : 0;
+}
+
+/*********************************************************************/
+//	checkProjections
+//	Compares getImageProjections, with the image stored in the same
+//	pass, with sums of the emulator output
+/*********************************************************************/
+
+void checkProjections(const char *name, unsigned char rowstart, unsigned char numrows, unsigned char colstart, unsigned char numcols, char norm)
+{
+  short rowproj[CHIP],colproj[CHIP];
+  long colacc[CHIP],sum,want;
+  unsigned char r,c;
+  int bad=0;
+
+  ArduEyeSMH.getImageProjections(rowproj,colproj,colacc,img,rowstart,numrows,1,colstart,numcols,1,SMH1_ADCTYPE_ONBOARD,0,norm);
+
+  for (r=0; r<numrows; ++r)
+  {
+    for (sum=0, c=0; c<numcols; ++c)
+      sum+=emu.output(rowstart+r,colstart+c);
+    want=(norm==SMH_PROJ_MEAN) ? sum/numcols : constrain(sum>>norm,-32768L,32767L);
+    bad+=(rowproj[r]!=want);
+  }
+  for (c=0; c<numcols; ++c)
+  {
+    for (sum=0, r=0; r<numrows; ++r)
+      sum+=emu.output(rowstart+r,colstart+c);
+    want=(norm==SMH_PROJ_MEAN) ? sum/numrows : constrain(sum>>norm,-32768L,32767L);
+    bad+=(colproj[c]!=want);
+  }
+
+  printf("%-32s %s",name,bad ? "FAIL" : "ok");
+  if (bad)
+    printf(" (%d sums differ)",bad);
+  printf("\n");
+  failures+=bad ? 1 : 0;
+  check("  image of the same pass",img,rowstart,numrows,1,colstart,numcols,1,0);
+}
+
+/*********************************************************************/
+//	checkFPN
+//	Two point calibration of a window under uniform light with offset
+//	and gain FPN and random noise, then the spread of a corrected 
+//	frame at a third light level without gain, with gain, and raw.
+//	Also checks the fused correction exactly on a noise free chip.
+/*********************************************************************/
+
+short uniformScene(unsigned char row, unsigned char col, void *arg)
+{
+  return *(short *)arg;
+}
+
+short spread(const short *p, short n)
+{
+  short i,lo=p[0],hi=p[0];
+
+  for (i=1; i<n; ++i)
+  {
+    lo=min(lo,p[i]);
+    hi=max(hi,p[i]);
+  }
+  return hi-lo;
+}
+
+void checkFPN(void)
+{
+  static short offset[32*32],scratch[32*32];
+  static unsigned char gain[32*32];
+  SMHFPN fpn={40,32,1,50,32,1,offset,gain};
+  SMHFPN fpnoff=fpn;
+  short level,i,bad=0,raw,once,twop;
+
+  fpnoff.gain=0;
+  emu.setScene(uniformScene,&level);
+  emu.setFPN(30);
+  emu.setGainFPN(10);
+
+  // exact: corrected pixel is (offset-value)*gain>>7
+  level=200;
+  ArduEyeSMH.calibrateFPN(&fpn,SMH1_ADCTYPE_ONBOARD,0,4);
+  level=800;
+  ArduEyeSMH.calibrateFPNGain(&fpn,scratch,SMH1_ADCTYPE_ONBOARD,0,4);
+  level=500;
+  ArduEyeSMH.getImage(img,&fpn,SMH1_ADCTYPE_ONBOARD,0);
+  for (i=0; i<32*32; ++i)
+    bad+=(img[i]!=(short)(((long)(offset[i]-emu.output(40+i/32,50+i%32))*gain[i])>>7));
+  printf("%-32s %s","getImage FPN corrected",bad ? "FAIL" : "ok");
+  if (bad)
+    printf(" (%d pixels differ)",bad);
+  printf("\n");
+  failures+=bad ? 1 : 0;
+
+  // frame version: a frame that is not the window is left alone
+  {
+    static short buf[32*33];
+    CYE_Frame frame;
+    unsigned short seq;
+
+    CYE_FrameInit(&frame,buf,32,33,CYE_FRAME_SHORT);
+    for (i=0; i<32*33; ++i)
+      buf[i]=-1;
+    frame.seq=seq=77;
+    bad=(ArduEyeSMH.getImage(&frame,&fpn,SMH1_ADCTYPE_ONBOARD,0)!=0 || frame.seq!=seq);
+    for (i=0; i<32*33; ++i)
+      bad+=(buf[i]!=-1);
+    CYE_FrameInit(&frame,buf,32,32,CYE_FRAME_SHORT);
+    frame.seq=seq;
+    bad+=(ArduEyeSMH.getImage(&frame,&fpn,SMH1_ADCTYPE_ONBOARD,0)!=1 || frame.seq==seq);
+    for (i=0; i<32*32; ++i)
+      bad+=(buf[i]!=img[i]);
+    printf("%-32s %s\n","getImage FPN frame mismatch",bad ? "FAIL" : "ok");
+    failures+=bad ? 1 : 0;
+  }
+
+  // averaged with noise: the two point correction should be flattest
+  emu.setNoise(4);
+  level=200;
+  ArduEyeSMH.calibrateFPN(&fpn,SMH1_ADCTYPE_ONBOARD,0,64);
+  level=800;
+  ArduEyeSMH.calibrateFPNGain(&fpn,scratch,SMH1_ADCTYPE_ONBOARD,0,64);
+  level=500;
+  ArduEyeSMH.getImage(img,40,32,1,50,32,1,SMH1_ADCTYPE_ONBOARD,0);
+  raw=spread(img,32*32);
+  ArduEyeSMH.getImage(img,&fpnoff,SMH1_ADCTYPE_ONBOARD,0);
+  once=spread(img,32*32);
+  ArduEyeSMH.getImage(img,&fpn,SMH1_ADCTYPE_ONBOARD,0);
+  twop=spread(img,32*32);
+  bad=!(twop<once && once<raw && twop<=20);
+  printf("%-32s %s (spread raw %d, offset %d, two point %d)\n","calibrateFPN 64 frames + gain",bad ? "FAIL" : "ok",raw,once,twop);
+  failures+=bad;
+
+  emu.setNoise(0);
+  emu.setGainFPN(0);
+  emu.setFPN(0);
+  emu.setScene(0,0);
+}
+
+/*********************************************************************/
+//	checkProfiles
+//	Stores profiles of two chips, rewrites one in place and once with
+//	a new layout, then loads it with begin() after the settings were
+//	reset, and once more after corrupting a byte of it
+/*********************************************************************/
+
+void checkProfiles(void)
+{
+  static short offset[10*10];
+  static unsigned char gain[10*10];
+  SMHFPN fpn={16,10,8,16,10,8,offset,gain};
+  SMHTiming t={3,4,5},got;
+  short i,bad=0;
+  char ok,crc;
+  unsigned long pulses;
+
+  ArduEyeSMH.eraseProfiles();
+
+  ArduEyeSMH.setBiases(40,50,60);
+  ArduEyeSMH.setAmpGain(2);
+  ArduEyeSMH.setBinning(8,8);
+  ArduEyeSMH.setTiming(SMH1_ADCTYPE_MCP3201,t);
+  for (i=0; i<100; ++i)
+  {
+    offset[i]=700+i;
+    gain[i]=i;
+  }
+  bad+=!ArduEyeSMH.saveProfile(2,&fpn);
+  for (i=0; i<100; ++i)
+    offset[i]=-1000+3*i;
+  bad+=!ArduEyeSMH.saveProfile(1,&fpn);	//second profile
+  for (i=0; i<100; ++i)
+    offset[i]=600-i;
+  bad+=!ArduEyeSMH.saveProfile(1,&fpn);	//in place
+  fpn.gain=0;
+  bad+=!ArduEyeSMH.saveProfile(1,&fpn);	//new layout, appended
+  fpn.gain=gain;
+
+  // reset, then boot from the profile
+  ArduEyeSMH.setTiming(SMH1_ADCTYPE_MCP3201,ArduEyeSMH.getTiming(SMH1_ADCTYPE_ONBOARD));
+  memset(offset,0,sizeof(offset));
+  emu.resetStats();
+  ok=ArduEyeSMH.begin(1,8,8,&fpn);
+  pulses=emu.stats().resp+emu.stats().incp+emu.stats().resv+emu.stats().incv;
+  got=ArduEyeSMH.getTiming(SMH1_ADCTYPE_MCP3201);
+  bad+=!ok;
+  bad+=(emu.reg(SMH_SYS_VREF)!=40)||(emu.reg(SMH_SYS_NBIAS)!=50)||(emu.reg(SMH_SYS_AOBIAS)!=60);
+  bad+=(emu.reg(SMH_SYS_CONFIG)!=2+8+16)||(emu.reg(SMH_SYS_HSW)!=0xFE)||(emu.reg(SMH_SYS_VSW)!=0xFE);
+  bad+=(got.settle1!=3)||(got.inphi!=4)||(got.settle2!=5);
+  for (i=0; i<100; ++i)
+    bad+=(offset[i]!=600-i)||(gain[i]!=SMH_FPN_GAIN_ONE);
+
+  // a changed byte fails the CRC: nothing applied, offsets zeroed
+  for (i=SMH_PROFILE_ADDR; EEPROM.read(i)==SMH_PROFILE_VALID || EEPROM.read(i)==SMH_PROFILE_DELETED; i+=SMH_PROFILE_HEADER+2*100+(EEPROM.read(i+1) ? 100 : 0)+2)
+    if (EEPROM.read(i)==SMH_PROFILE_VALID && EEPROM.read(i+2)==2)
+      EEPROM.write(i+SMH_PROFILE_HEADER+5,EEPROM.read(i+SMH_PROFILE_HEADER+5)^1);
+  ArduEyeSMH.begin();
+  crc=ArduEyeSMH.loadProfile(2,0xFE,0xFE,&fpn);
+  bad+=crc || (offset[5]!=0) || (emu.reg(SMH_SYS_VREF)==40);
+
+  printf("%-32s %s (boot %lu pulses)\n","saveProfile + begin(profile)",bad ? "FAIL" : "ok",pulses);
+  failures+=bad ? 1 : 0;
+
+  ArduEyeSMH.eraseProfiles();
+  ArduEyeSMH.begin();
+  ArduEyeSMH.setTiming(SMH1_ADCTYPE_MCP3201,ArduEyeSMH.getTiming(SMH1_ADCTYPE_ONBOARD));
+}
+
+/*********************************************************************/
+//	checkTimingTypes
+//	getImage with SMH1_ADCTYPE_MCP3201_2 must use its own timing
+//	profile: a longer settle2 there costs delay cycles, one on 
+//	SMH1_ADCTYPE_MCP3201 does not
+/*********************************************************************/
+
+void checkTimingTypes(void)
+{
+  SMHTiming def=ArduEyeSMH.getTiming(SMH1_ADCTYPE_MCP3201_2),t=def;
+  unsigned long base,slow,other;
+  int bad=0;
+
+  emu.resetStats();
+  ArduEyeSMH.getImage(img,4,8,2,6,10,3,SMH1_ADCTYPE_MCP3201_2,0);
+  base=emu.stats().delayus;
+  check("getImage MCP3201_2",img,4,8,2,6,10,3,2);
+
+  t.settle2+=5;
+  ArduEyeSMH.setTiming(SMH1_ADCTYPE_MCP3201,t);
+  emu.resetStats();
+  ArduEyeSMH.getImage(img,4,8,2,6,10,3,SMH1_ADCTYPE_MCP3201_2,0);
+  other=emu.stats().delayus;
+  ArduEyeSMH.setTiming(SMH1_ADCTYPE_MCP3201,def);
+
+  ArduEyeSMH.setTiming(SMH1_ADCTYPE_MCP3201_2,t);
+  emu.resetStats();
+  ArduEyeSMH.getImage(img,4,8,2,6,10,3,SMH1_ADCTYPE_MCP3201_2,0);
+  slow=emu.stats().delayus;
+  ArduEyeSMH.setTiming(SMH1_ADCTYPE_MCP3201_2,def);
+
+  bad+=(other!=base)||(slow!=base+5UL*8*10);
+  printf("%-32s %s (delay %lu us, %lu us with settle2 +5)\n","MCP3201_2 timing profile",bad ? "FAIL" : "ok",base,slow);
+  failures+=bad ? 1 : 0;
+  emu.resetStats();
+}
+
+/*********************************************************************/
+//	checkRows
+//	getImageRows against getImage of the same window.  The rows must
+//	arrive in order in the caller's buffer, which is never written 
+//	past one row (constant RAM whatever the window height).  With 
+//	slow, each row takes that many board cycles in the caller.
+/*********************************************************************/
+
+struct RowCollect
+{
+  short *frame,*rowbuf;
+  unsigned char next,numcols;
+  int bad;
+  unsigned long slow;
+
+  void operator()(unsigned char row, short *pixels, unsigned char n)
+  {
+    bad+=(row!=next)||(pixels!=rowbuf)||(n!=numcols);
+    memcpy(frame+row*numcols,pixels,n*sizeof(short));
+    next++;
+    smhHostAddCycles(slow);
+  }
+};
+
+void checkRows(const char *name, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType, unsigned long slow=0)
+{
+  static short frame[CHIP*CHIP];
+  short rowbuf[CHIP+8];
+  RowCollect rc={frame,rowbuf,0,numcols,0,slow};
+  int i,bad;
+
+  for (i=numcols; i<numcols+8; ++i)
+    rowbuf[i]=0x5A5A;	//guard past the row
+  ArduEyeSMH.getImageRows(rowbuf,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,0,rc);
+  ArduEyeSMH.getImage(img,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,0);
+  for (i=numcols; i<numcols+8; ++i)
+    rc.bad+=(rowbuf[i]!=0x5A5A);
+  bad=rc.bad+(rc.next!=numrows);
+  for (i=0; i<numrows*numcols; ++i)
+    bad+=(frame[i]!=img[i]);
+
+  printf("%-32s %s",name,bad ? "FAIL" : "ok");
+  if (bad)
+    printf(" (%d differences)",bad);
+  printf("\n");
+  failures+=bad ? 1 : 0;
+}
+
+/*********************************************************************/
+//	checkMulti
+//	A second chip with its own scene on analog input 2.  Each chip's
+//	image from getImageMulti must equal getImage of that chip alone.
+//	The Bug board type must return 0 and leave the images alone.
+/*********************************************************************/
+
+short stripeScene(unsigned char row, unsigned char col, void *arg)
+{
+  return ((col/4)&1) ? 900 : 100+row*3;
+}
+
+void checkMulti(const char *name, unsigned char rowstart, unsigned char numrows, unsigned char rowskip, unsigned char colstart, unsigned char numcols, unsigned char colskip, char ADCType)
+{
+  static short img0[CHIP*CHIP],img2[CHIP*CHIP];
+  short *imgs[SMH_MAX_CHIPS]={img0,0,img2,0};
+  SMHEmulator emu2(CHIP);
+  char chip;
+  int i,same,bad=0;
+
+  emu2.attach<SMHPinsDefault>(2);
+  emu2.setScene(stripeScene,0);
+  emu2.setFPN(20);
+  ArduEyeSMH.begin();	//same register values in both chips
+
+  bad+=!ArduEyeSMH.getImageMulti(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,0x05);
+  for (chip=0; chip<=2; chip+=2)
+  {
+    ArduEyeSMH.getImage(img,rowstart,numrows,rowskip,colstart,numcols,colskip,ADCType,chip);
+    for (i=0; i<numrows*numcols; ++i)
+      bad+=(imgs[(unsigned char)chip][i]!=img[i]);
+  }
+  for (same=0, i=0; i<numrows*numcols; ++i)
+    same+=(img0[i]==img2[i]);
+  bad+=(same==numrows*numcols);	//the two chips must differ
+
+  img0[0]=img2[0]=-1;
+  bad+=ArduEyeSMH.getImageMulti(imgs,rowstart,numrows,rowskip,colstart,numcols,colskip,SMH1_ADCTYPE_MCP3201_2,0x05);
+  bad+=(img0[0]!=-1)||(img2[0]!=-1);
+
+  printf("%-32s %s",name,bad ? "FAIL" : "ok");
+  if (bad)
+    printf(" (%d pixels differ)",bad);
+  printf("\n");
+  failures+=bad ? 1 : 0;
+
+  emu2.detach();
+  emu.resetStats();
+}
+
+/*********************************************************************/
+//	checkROIs
+//	getImageROIs against the same windows cut from a full getImage:
+//	two overlapping regions with different skips and a sparse one
+/*********************************************************************/
+
+void checkROIs(const char *name, char ADCType)
+{
+  static short full[CHIP*CHIP],a[16*16],b[12*20],c[8*8];
+  SMHROI rois[3]={{10,16,1,10,16,1,a},{18,12,2,20,20,3,b},{60,8,4,0,8,9,c}};
+  unsigned char k,r,col;
+  int bad=0;
+
+  ArduEyeSMH.getImage(full,0,CHIP,1,0,CHIP,1,ADCType,0);
+  ArduEyeSMH.getImageROIs(rois,3,ADCType,0);
+  for (k=0; k<3; ++k)
+    for (r=0; r<rois[k].numrows; ++r)
+      for (col=0; col<rois[k].numcols; ++col)
+        bad+=(rois[k].img[r*rois[k].numcols+col]!=full[(rois[k].rowstart+r*rois[k].rowskip)*CHIP+rois[k].colstart+col*rois[k].colskip]);
+
+  printf("%-32s %s",name,bad ? "FAIL" : "ok");
+  if (bad)
+    printf(" (%d pixels differ)",bad);
+  printf("\n");
+  failures+=bad ? 1 : 0;
+}
+
+/*********************************************************************/
+//	checkPixels
+//	getPixels against a full getImage: an unsorted list with the 
+//	corners and a duplicate, whose values must come back in the 
+//	caller's order
+/*********************************************************************/
+
+void checkPixels(const char *name, char ADCType)
+{
+  static short full[CHIP*CHIP];
+  SMHPixel pix[300];
+  short out[300],order[300];
+  short i,n=300;
+  int bad=0;
+
+  for (i=0; i<n; ++i)
+  {
+    pix[i].row=(i*37+5)%CHIP;
+    pix[i].col=(CHIP-1)-(i*53)%CHIP;
+  }
+  pix[1].row=CHIP-1; pix[1].col=CHIP-1;
+  pix[2].row=0; pix[2].col=0;
+  pix[n-1]=pix[7];
+
+  ArduEyeSMH.getImage(full,0,CHIP,1,0,CHIP,1,ADCType,0);
+  ArduEyeSMH.getPixels(pix,n,out,order,ADCType,0);
+  for (i=0; i<n; ++i)
+    bad+=(out[i]!=full[pix[i].row*CHIP+pix[i].col]);
+
+  printf("%-32s %s",name,bad ? "FAIL" : "ok");
+  if (bad)
+    printf(" (%d pixels differ)",bad);
+  printf("\n");
+  failures+=bad ? 1 : 0;
+}
+
+/*********************************************************************/
+//	checkPeaks
+//	findPeaks on six blobs against a brute force top K of a full 
+//	getImage: the brightest pixels, each suppressing the pixels 
+//	within minsep of it.  Then the centroid of a recorded 12 bit 
+//	image whose weights sum past 2^23, against doubles.
+/*********************************************************************/
+
+#define SMH_BENCH_BLOBS 6
+
+static const short blobs[SMH_BENCH_BLOBS][3]={{15,20,500},{15,80,900},{40,50,600},{60,30,800},{85,90,700},{100,10,550}};
+
+short blobScene(unsigned char row, unsigned char col, void *arg)
+{
+  short i,dr,dc;
+
+  for (i=0; i<SMH_BENCH_BLOBS; ++i)
+  {
+    dr=row-blobs[i][0];
+    dc=col-blobs[i][1];
+    if (dr>=-1 && dr<=1 && dc>=-1 && dc<=1)
+      return blobs[i][2]-100*(dr*dr+dc*dc);
+  }
+  return 0;
+}
+
+void checkPeaks(void)
+{
+  static short full[CHIP*CHIP];
+  static char used[CHIP*CHIP];
+  SMHPeak peaks[3];
+  short threshold=700,w;
+  unsigned char n,i,minsep=3;
+  int j,best,bad=0;
+  double sw,swr,swc;
+
+  emu.setScene(blobScene,0);
+  ArduEyeSMH.getImage(full,0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD,0);
+  n=ArduEyeSMH.findPeaks(0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD,0,threshold,minsep,peaks,3);
+  emu.setScene(0,0);
+
+  memset(used,0,sizeof(used));
+  for (i=0; i<3; ++i)
+  {
+    for (best=-1, j=0; j<CHIP*CHIP; ++j)
+      if (!used[j] && full[j]<threshold && (best<0 || full[j]<full[best]))
+        best=j;
+    if (best<0)
+      break;
+    if (i>=n || peaks[i].row!=best/CHIP || peaks[i].col!=best%CHIP || peaks[i].weight!=threshold-full[best])
+      bad++;
+    for (j=0; j<CHIP*CHIP; ++j)	//suppress within minsep
+      if (abs(j/CHIP-best/CHIP)<=minsep && abs(j%CHIP-best%CHIP)<=minsep)
+        used[j]=1;
+  }
+  bad+=(n!=i);
+
+  printf("%-32s %s (%d peaks)\n","findPeaks top 3 of 6",bad ? "FAIL" : "ok",n);
+  failures+=bad ? 1 : 0;
+
+  // one peak over 40 rows of weights near 4000
+  for (sw=swr=swc=0, j=0; j<40*CHIP; ++j)
+  {
+    w=3000+((j/CHIP)*7+(j%CHIP)*3)%1000;
+    full[j]=w;
+    sw+=w;
+    swr+=(double)w*(j/CHIP);
+    swc+=(double)w*(j%CHIP);
+  }
+  n=ArduEyeSMH.findPeaks(full,40,CHIP,1,0,127,peaks,1);
+  bad=(n!=1) || (peaks[0].row_q8!=(unsigned short)(swr/sw*256)) || (peaks[0].col_q8!=(unsigned short)(swc/sw*256));
+  printf("%-32s %s (%.3f,%.3f)\n","findPeaks centroid past 2^23",bad ? "FAIL" : "ok",peaks[0].row_q8/256.0,peaks[0].col_q8/256.0);
+  failures+=bad;
+  emu.resetStats();
+}
+
+/*********************************************************************/
+//	checkBackground
+//	Background acquisition (the thread backend on a host) against 
+//	getImage of the same window once stopped.  The frame compared is
+//	the second one returned, so it was read entirely by the state 
+//	machine, from the frame start it addressed itself.
+/*********************************************************************/
+
+void checkBackground(const char *name, char gain)
+{
+  static short bufs[SMH_BG_SLOTS][12*16];
+  CYE_Frame frames[SMH_BG_SLOTS],*f,*last=0;
+  unsigned long start;
+  unsigned short seq=0;
+  char got=0;
+  int i,bad=0;
+
+  ArduEyeSMH.setAmpGain(gain);
+  for (i=0; i<SMH_BG_SLOTS; ++i)
+    CYE_FrameInit(&frames[i],bufs[i],12,16,CYE_FRAME_SHORT);
+  ArduEyeSMH.startBackground(frames,10,3,30,5,0);
+  start=micros();
+  while (got<2 && micros()-start<5000000UL)
+    if ((f=ArduEyeSMH.getBackgroundFrame()))
+    {
+      bad+=(got && f->seq==seq);	//a new frame each time
+      seq=f->seq;
+      last=f;
+      got++;
+    }
+  ArduEyeSMH.stopBackground();
+
+  ArduEyeSMH.getImage(img,10,12,3,30,16,5,SMH1_ADCTYPE_ONBOARD,0);
+  bad+=(got<2);
+  for (i=0; last && i<12*16; ++i)
+    bad+=(((short *)last->pixels)[i]!=img[i]);
+  ArduEyeSMH.setAmpGain(0);
+
+  printf("%-32s %s",name,bad ? "FAIL" : "ok");
+  if (bad)
+    printf(" (%d differences)",bad);
+  printf("\n");
+  failures+=bad ? 1 : 0;
+  emu.resetStats();
+}
+
+/*********************************************************************/
+//	checkExposure
+//	autoExposure while the light ramps up fourfold, then holds.  The
+//	mean of the histogram must be within SMH_BENCH_AE_BAND bins of
+//	the middle SMH_BENCH_AE_SETTLE steps after the ramp and stay
+//	there, and VREF, AOBIAS and the gain must stay in range (on the
+//	chip as well as in the loop state).
+/*********************************************************************/
+
+#define SMH_BENCH_AE_RAMP 24	//steps of the ramp
+#define SMH_BENCH_AE_SETTLE 20	//steps allowed to settle after it
+#define SMH_BENCH_AE_HOLD 10	//steps that must stay in the band
+#define SMH_BENCH_AE_BAND 2	//bins
+
+short gradientScene(unsigned char row, unsigned char col, void *arg)
+{
+  return (long)*(short *)arg*(64+row+col)/288;
+}
+
+void checkExposure(void)
+{
+  SMHExposure ae;
+  unsigned short hist[SMH_AE_BINS];
+  unsigned long sum,total;
+  short level,step,settled=-1,mean2=0;
+  unsigned char i;
+  int bad=0;
+
+  emu.setScene(gradientScene,&level);
+  ArduEyeSMH.begin();
+  ArduEyeSMH.autoExposureInit(&ae);
+
+  for (step=0; step<SMH_BENCH_AE_RAMP+SMH_BENCH_AE_SETTLE+SMH_BENCH_AE_HOLD; ++step)
+  {
+    level=(step<SMH_BENCH_AE_RAMP) ? 200+600*step/SMH_BENCH_AE_RAMP : 800;
+    ArduEyeSMH.autoExposure(&ae,0,CHIP,0,CHIP,8,SMH1_ADCTYPE_ONBOARD,0);
+
+    bad+=(ae.vref>SMH_BIAS_MAX)||(ae.aobias>SMH_BIAS_MAX)||(ae.gain>SMH_GAIN_MAX);
+    bad+=(emu.reg(SMH_SYS_VREF)!=ae.vref)||(emu.reg(SMH_SYS_AOBIAS)!=ae.aobias);
+    bad+=(emu.reg(SMH_SYS_CONFIG)&7)!=ae.gain;
+
+    // histogram mean, in half bins
+    ArduEyeSMH.getHistogram(hist,0,CHIP,0,CHIP,8,SMH1_ADCTYPE_ONBOARD,0);
+    for (sum=total=0, i=0; i<SMH_AE_BINS; ++i)
+    {
+      sum+=2UL*i*hist[i];
+      total+=hist[i];
+    }
+    mean2=total ? sum/total : 0;
+    if (abs(mean2-(SMH_AE_BINS-1))>2*SMH_BENCH_AE_BAND)
+      settled=-1;
+    else if (settled<0)
+      settled=step;
+  }
+  bad+=(settled<0)||(settled>SMH_BENCH_AE_RAMP+SMH_BENCH_AE_SETTLE);
+
+  printf("%-32s %s (mean %.1f bins, settled at step %d)\n","autoExposure light ramp",bad ? "FAIL" : "ok",mean2/2.0,settled);
+  failures+=bad ? 1 : 0;
+
+  emu.setScene(0,0);
+  ArduEyeSMH.begin();
+  emu.resetStats();
+}
+
+/*********************************************************************/
+//	checkShadows
+//	getPulseCount against the pulses the emulator saw, and a register
+//	incremented past 8 bits: its shadow must not skip the next RESV
+/*********************************************************************/
+
+void checkShadows(void)
+{
+  unsigned long pulses;
+  short bad=0;
+
+  ArduEyeSMH.resetPulseCount();
+  emu.resetStats();
+  ArduEyeSMH.getImage(img,5,20,3,7,30,2,SMH1_ADCTYPE_ONBOARD,0);
+  pulses=emu.stats().resp+emu.stats().incp+emu.stats().resv+emu.stats().incv;
+  bad+=(ArduEyeSMH.getPulseCount()!=pulses);
+  printf("%-32s %s (%lu, emulator %lu)\n","getPulseCount",bad ? "FAIL" : "ok",ArduEyeSMH.getPulseCount(),pulses);
+  failures+=bad;
+
+  ArduEyeSMH.setPointerValue(SMH_SYS_VREF,250);
+  ArduEyeSMH.incValue(10);	//wraps the 8 bit register to 4
+  ArduEyeSMH.setPointerValue(SMH_SYS_VREF,30);
+  bad=(emu.reg(SMH_SYS_VREF)!=30);
+  printf("%-32s %s (VREF %d)\n","register shadow past 8 bits",bad ? "FAIL" : "ok",emu.reg(SMH_SYS_VREF));
+  failures+=bad;
+  ArduEyeSMH.begin();
+  emu.resetStats();
+}
+
+/*********************************************************************/
+//	checkFree
+//	The free-running ADC (ONBOARD_FAST8) where it runs ahead of the
+//	loop: a stale flag after the pulse train at the start of a line
+//	(column starts ending at many points of a conversion, the fastest
+//	prescaler), a slow row callback and a slow Serial sink.  Afterwards the ADC must be set up as it
+//	was for analogRead.
+/*********************************************************************/
+
+void checkFree(void)
+{
+  unsigned char sra=ADCSRA,mux=ADMUX,col;
+  int i,bad;
+
+  // line starts at many points of a conversion
+  for (bad=0, col=40; col<100; col+=7)
+  {
+    ArduEyeSMH.getImage(img,2,10,3,col,12,1,SMH1_ADCTYPE_ONBOARD_FAST8,0);
+    for (i=0; i<10*12; ++i)
+      bad+=(img[i]!=(emu.output(2+(i/12)*3,col+i%12)>>2));
+  }
+  printf("%-32s %s","fast8 columns 40 to 100",bad ? "FAIL" : "ok");
+  if (bad)
+    printf(" (%d pixels differ)",bad);
+  printf("\n");
+  failures+=bad ? 1 : 0;
+
+  ArduEyeSMH.setADCPrescaler(2);
+  ArduEyeSMH.getImage(img,2,10,3,60,40,1,SMH1_ADCTYPE_ONBOARD_FAST8,0);
+  check("fast8 prescaler 2",img,2,10,3,60,40,1,-2);
+  ArduEyeSMH.setADCPrescaler(SMH_ADC_PRESCALER_DEFAULT);
+
+  checkRows("getImageRows fast8 slow rows",0,20,1,50,30,1,SMH1_ADCTYPE_ONBOARD_FAST8,5000);
+  checkDump("sectionToBinary fast8",10,12,2,10,30,3,SMH1_ADCTYPE_ONBOARD_FAST8,-2);
+
+  bad=(ADCSRA!=sra)||(ADMUX!=mux);
+  printf("%-32s %s (ADCSRA %02X)\n","deselectADC restores the ADC",bad ? "FAIL" : "ok",(unsigned char)ADCSRA);
+  failures+=bad;
+  emu.resetStats();
+}
+
+/*********************************************************************/
+//	checks
+/*********************************************************************/
+
+void runChecks(void)
+{
+  unsigned char row,col;
+  unsigned short rq8,cq8;
+
+  printf("checks\n");
+
+  ArduEyeSMH.getImage(img,0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD,0);
+  check("getImage onboard",img,0,CHIP,1,0,CHIP,1,0);
+
+  ArduEyeSMH.getImage(img,8,16,4,20,16,4,SMH1_ADCTYPE_ONBOARD_FAST8,0);
+  check("getImage onboard fast8",img,8,16,4,20,16,4,-2);
+  checkFree();
+
+  emu.setExternalADC(12);
+  ArduEyeSMH.setPipelined(1);
+  ArduEyeSMH.getImage(img,10,32,2,10,32,2,SMH1_ADCTYPE_MCP3201,0);
+  check("getImage MCP3201 pipelined",img,10,32,2,10,32,2,2);
+  ArduEyeSMH.setPipelined(0);
+
+  emu.setExternalADC(10);
+  ArduEyeSMH.getImage(img,10,32,2,10,32,2,SMH1_ADCTYPE_MCP3001,0);
+  check("getImage MCP3001",img,10,32,2,10,32,2,0);
+
+  ArduEyeSMH.setBinning(4,4);
+  ArduEyeSMH.getImage(img,0,CHIP/4,4,0,CHIP/4,4,SMH1_ADCTYPE_ONBOARD,0);
+  check("setBinning 4 + getImage",img,0,CHIP/4,4,0,CHIP/4,4,0);
+  ArduEyeSMH.setBinning(1,1);
+
+  ArduEyeSMH.setBinning(4,2,1,1);
+  ArduEyeSMH.getImage(img,1,40,2,1,20,4,SMH1_ADCTYPE_ONBOARD,0);
+  check("setBinning 4x2 offset 1",img,1,40,2,1,20,4,0);
+
+  SMHBinPlan plan;
+  ArduEyeSMH.planBinning(10,6,0,CHIP,20,60,&plan);
+  ArduEyeSMH.setBinning(&plan);
+  emu.resetStats();
+  ArduEyeSMH.setBinning(&plan);
+  if (emu.stats().incv || emu.stats().resv)
+  {
+    printf("%-32s FAIL (switches rewritten)\n","setBinning cache");
+    failures++;
+  }
+  ArduEyeSMH.getImage(img,plan.rowstart,plan.numrows,plan.rowskip,plan.colstart,plan.numcols,plan.colskip,SMH1_ADCTYPE_ONBOARD,0);
+  check("planBinning 10x6",img,plan.rowstart,plan.numrows,plan.rowskip,plan.colstart,plan.numcols,plan.colskip,0);
+  ArduEyeSMH.setBinning(1,1);
+
+  ArduEyeSMH.setAmpGain(3);
+  ArduEyeSMH.getImage(img,30,20,1,60,20,1,SMH1_ADCTYPE_ONBOARD,0);
+  check("getImage amplifier gain 3",img,30,20,1,60,20,1,0);
+  ArduEyeSMH.setAmpGain(0);
+
+  checkDump("sectionToBinary 10 bits",0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD,0);
+  emu.setExternalADC(12);
+  checkDump("sectionToBinary 12 bits",5,21,3,7,33,2,SMH1_ADCTYPE_MCP3201,2);
+
+  checkProjections("getImageProjections mean",0,CHIP,0,CHIP,SMH_PROJ_MEAN);
+  checkProjections("getImageProjections sum",10,50,20,90,0);
+
+  checkRows("getImageRows onboard",0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD);
+  emu.setExternalADC(12);
+  checkRows("getImageRows MCP3201 skip",3,30,3,5,50,2,SMH1_ADCTYPE_MCP3201);
+
+  checkMulti("getImageMulti 2 chips onboard",10,30,2,20,40,1,SMH1_ADCTYPE_ONBOARD);
+  emu.setExternalADC(12);
+  checkMulti("getImageMulti 2 chips MCP3201",0,CHIP,4,0,CHIP,4,SMH1_ADCTYPE_MCP3201);
+  checkMulti("getImageMulti 2 chips fast",10,30,2,20,40,1,SMH1_ADCTYPE_ONBOARD_FAST);
+  checkMulti("getImageMulti 2 chips fast8",5,20,3,60,50,1,SMH1_ADCTYPE_ONBOARD_FAST8);
+
+  checkROIs("getImageROIs onboard",SMH1_ADCTYPE_ONBOARD);
+  emu.setExternalADC(12);
+  checkROIs("getImageROIs MCP3201",SMH1_ADCTYPE_MCP3201);
+
+  checkPixels("getPixels onboard",SMH1_ADCTYPE_ONBOARD);
+  emu.setExternalADC(12);
+  checkPixels("getPixels MCP3201",SMH1_ADCTYPE_MCP3201);
+
+  checkPeaks();
+  checkExposure();
+  checkBackground("background frame",0);
+  checkBackground("background frame amplifier",2);
+  checkShadows();
+  checkFPN();
+  checkProfiles();
+  checkTimingTypes();
+
+  checkPacked("getImage packed 10 bits",CYE_FRAME_PACK10,3,17,5,23,SMH1_ADCTYPE_ONBOARD,0);
+  checkPacked("getImage packed 12 bits",CYE_FRAME_PACK12,3,17,5,23,SMH1_ADCTYPE_MCP3201,2);
+  checkPackRows();
+  checkMaskPacked();
+
+  ArduEyeSMH.findMax(0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD,0,&row,&col);
+  printf("%-32s %s (%d,%d)\n","findMax",(row>=38&&row<=42&&col>=68&&col<=72) ? "ok" : "FAIL",row,col);
+  failures+=(row>=38&&row<=42&&col>=68&&col<=72) ? 0 : 1;
+
+  ArduEyeSMH.findMaxCoarseToFine(0,CHIP,0,CHIP,8,SMH1_ADCTYPE_ONBOARD,0,&row,&col,&rq8,&cq8);
+  printf("%-32s %s (%.2f,%.2f)\n","findMaxCoarseToFine",(rq8>>8==40 && cq8>>8==70) ? "ok" : "FAIL",rq8/256.0,cq8/256.0);
+  failures+=(rq8>>8==40 && cq8>>8==70) ? 0 : 1;
+}
+
+/*********************************************************************/
+//	benchmarks
+/*********************************************************************/
+
+void runBench(void)
+{
+  unsigned char row,col;
+  unsigned short rq8,cq8;
+  SMHPixel pix[256];
+  long colacc[CHIP];
+  short order[256];
+  SMHROI rois[2];
+  short i;
+
+  printf("\n%-32s %6s %8s %8s %10s %8s %8s\n","per frame","pixels","pulses","samples","cycles","cyc/pix","model");
+  emu.resetStats();
+
+  ArduEyeSMH.getImage(img,0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD,0);
+  report("getImage 112x112 onboard",CHIP*CHIP,SMH1_ADCTYPE_ONBOARD);
+
+  ArduEyeSMH.getImage(img,0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_MCP3201,0);
+  report("getImage 112x112 MCP3201",CHIP*CHIP,SMH1_ADCTYPE_MCP3201);
+
+  ArduEyeSMH.setPipelined(1);
+  ArduEyeSMH.getImage(img,0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_MCP3201,0);
+  report("getImage 112x112 MCP3201 pipe",CHIP*CHIP,SMH1_ADCTYPE_MCP3201);
+  ArduEyeSMH.setPipelined(0);
+
+  ArduEyeSMH.setAmpGain(2);
+  ArduEyeSMH.getImage(img,0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_MCP3201,0);
+  report("getImage 112x112 MCP3201 amp",CHIP*CHIP,SMH1_ADCTYPE_MCP3201);
+  ArduEyeSMH.setAmpGain(0);
+
+  ArduEyeSMH.getImage(img,16,10,8,16,10,8,SMH1_ADCTYPE_ONBOARD,0);
+  report("getImage 10x10 skip 8",100);
+
+  ArduEyeSMH.setBinning(8,8);
+  ArduEyeSMH.getImage(img,0,CHIP/8,8,0,CHIP/8,8,SMH1_ADCTYPE_ONBOARD,0);
+  report("setBinning 8 + 14x14",CHIP*CHIP/64);
+  ArduEyeSMH.setBinning(1,1);
+
+  ArduEyeSMH.getImageRowSum(img,0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD,0);
+  ArduEyeSMH.getImageColSum(img+CHIP,0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD,0);
+  report("getImageRowSum + ColSum",2*CHIP*CHIP);
+
+  ArduEyeSMH.getImageProjections(img,img+CHIP,colacc,0,0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD,0,SMH_PROJ_MEAN);
+  report("getImageProjections 112x112",CHIP*CHIP);
+
+  rois[0].rowstart=10; rois[0].numrows=16; rois[0].rowskip=1;
+  rois[0].colstart=10; rois[0].numcols=16; rois[0].colskip=1;
+  rois[0].img=img;
+  rois[1].rowstart=60; rois[1].numrows=16; rois[1].rowskip=1;
+  rois[1].colstart=80; rois[1].numcols=16; rois[1].colskip=1;
+  rois[1].img=img+256;
+  ArduEyeSMH.getImageROIs(rois,2,SMH1_ADCTYPE_ONBOARD,0);
+  report("getImageROIs 2x 16x16",512);
+
+  for (i=0; i<256; ++i)
+  {
+    pix[i].row=(i*37)%CHIP;
+    pix[i].col=(i*53)%CHIP;
+  }
+  ArduEyeSMH.getPixels(pix,256,img,order,SMH1_ADCTYPE_ONBOARD,0);
+  report("getPixels 256 scattered",256);
+
+  ArduEyeSMH.findMax(0,CHIP,1,0,CHIP,1,SMH1_ADCTYPE_ONBOARD,0,&row,&col);
+  report("findMax 112x112",CHIP*CHIP);
+
+  ArduEyeSMH.findMaxCoarseToFine(0,CHIP,0,CHIP,8,SMH1_ADCTYPE_ONBOARD,0,&row,&col,&rq8,&cq8);
+  report("findMaxCoarseToFine bin 8",emu.stats().samples);	//coarse and fine samples
+}
+
+int main(int argc, char **argv)
+{
+  emu.attach<SMHPinsDefault>(0);
+  ArduEyeSMH.begin();
+  emu.resetStats();
+
+  runChecks();
+  runBench();
+
+  return failures ? 1 : 0;
+}
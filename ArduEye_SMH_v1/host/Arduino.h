@@ -0,0 +1,218 @@
+/*********************************************************************/
+/*********************************************************************/
+//	Arduino.h (host)
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
+//	
+//	Minimal Arduino core for building the ArduEye libraries on a 
+//	Linux or Mac host, for tests and benchmarks.  Pins go to the 
+//	simulated ports of ArduEye_SMH_Pins.h, analogRead and SPI call 
+//	hooks (e.g. a chip emulator), Serial prints to stdout and the 
+//	delays advance micros() without waiting.  The ADC registers of
+//	an ATmega328 are modeled for the free-running readout.
+//
+//	Build a host program with the host directory first on the 
+//	include path and ARDUINO defined, e.g.:
+//	g++ -DARDUINO=100 -IArduEye_SMH_v1/host -IArduEye_SMH_v1 
+//	  -IArduEye_Prof_v1 -ICYE_Images_v1 prog.cpp 
+//	  ArduEye_SMH_v1/ArduEye_SMH.cpp ArduEye_SMH_v1/host/ArduEye_Host.cpp
+//	  ArduEye_Prof_v1/ArduEye_Prof.cpp CYE_Images_v1/CYE_Images_v1.cpp 
+//	  -lpthread
+//
+/*********************************************************************/
+/*********************************************************************/
+
+/*
+===============================================================================
+Copyright (c) 2012 Centeye, Inc. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, 
+    this list of conditions and the following disclaimer.
+    
+    Redistributions in binary form must reproduce the above copyright notice, 
+    this list of conditions and the following disclaimer in the documentation 
+    and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY CENTEYE, INC. ``AS IS'' AND ANY EXPRESS OR 
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO 
+EVENT SHALL CENTEYE, INC. OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, 
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY 
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, 
+EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+The views and conclusions contained in the software and documentation are 
+those of the authors and should not be interpreted as representing official 
+policies, either expressed or implied, of Centeye, Inc.
+===============================================================================
+*/
+
+#ifndef _ARDUEYE_HOST_ARDUINO_H_INCLUDED
+#define _ARDUEYE_HOST_ARDUINO_H_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL	//timing models assume a 16MHz board
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HEX 16
+#define DEC 10
+#define PI 3.1415926535897932384626433832795
+
+#define _BV(bit) (1<<(bit))
+#define constrain(x,low,high) ((x)<(low)?(low):((x)>(high)?(high):(x)))
+#ifndef min
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#endif
+
+/*********************************************************************/
+//	Time.  delay and delayMicroseconds return at once and advance 
+//	the clock, so micros() is the run time plus all delays.
+/*********************************************************************/
+
+unsigned long micros(void);
+unsigned long millis(void);
+void delayMicroseconds(unsigned int us);
+void delay(unsigned long ms);
+
+//sum of all delays so far, in microseconds
+unsigned long smhHostDelayTotal(void);
+
+//ATmega cycles the code would have taken so far, as far as the host
+//can tell: delays, port writes, ADC register reads, analogRead and
+//Serial output advance it.  It is the time base of the ADC registers
+//below.  smhHostAddCycles accounts for other work, e.g. a callback 
+//that would be slow on the board.
+unsigned long smhHostCycles(void);
+void smhHostAddCycles(unsigned long cycles);
+
+/*********************************************************************/
+//	Analog input, read through a hook (0 if none is set)
+/*********************************************************************/
+
+typedef int (*SMHHostAnalogHook)(unsigned char pin);
+void smhHostSetAnalogHook(SMHHostAnalogHook hook);
+int analogRead(uint8_t pin);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+/*********************************************************************/
+//	ADC registers of an ATmega328 (ADCSRA, ADCSRB, ADMUX, ADCL, ADCH,
+//	ADCW).  Conversions take 13 ADC clocks (25 for the first one 
+//	after ADEN), sample the input 1.5 ADC clocks after they start 
+//	and follow each other without a gap in free-running mode (ADATE,
+//	ADCSRB=0).  ADIF is set at the end of each conversion and is 
+//	cleared by writing a one to it.  Conversions run on the board 
+//	cycles, so the ADC keeps converting while the code is busy.  The
+//	input is read through the conversion hook (the analog hook if 
+//	none is set) on the channel in ADMUX.
+/*********************************************************************/
+
+void smhHostSetConversionHook(SMHHostAnalogHook hook);
+
+class HostADCRegister
+{
+public:
+  HostADCRegister(unsigned char r) : reg(r) {}
+  operator uint8_t() const;
+  HostADCRegister &operator=(uint8_t val);
+  HostADCRegister &operator|=(uint8_t val) { return *this=(uint8_t)*this|val; }
+  HostADCRegister &operator&=(uint8_t val) { return *this=(uint8_t)*this&val; }
+
+private:
+  unsigned char reg;
+};
+
+class HostADCWord
+{
+public:
+  operator uint16_t() const;
+};
+
+extern HostADCRegister smhHostADCSRA,smhHostADCSRB,smhHostADMUX,smhHostADCL,smhHostADCH;
+extern HostADCWord smhHostADCW;
+
+#define ADCSRA smhHostADCSRA
+#define ADCSRB smhHostADCSRB
+#define ADMUX smhHostADMUX
+#define ADCL smhHostADCL
+#define ADCH smhHostADCH
+#define ADCW smhHostADCW
+
+//ADCSRA
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+
+//ADMUX
+#define REFS1 7
+#define REFS0 6
+#define ADLAR 5
+
+/*********************************************************************/
+//	Serial, printed to stdout.  Input is what was queued with 
+//	queueInput, so a host program can send commands to a sketch.
+//	Each byte sent takes 10 bit times of the begin() rate (115200 if
+//	not set) in board cycles.
+/*********************************************************************/
+
+class HostSerial
+{
+public:
+  void begin(long rate) { baud=rate; }
+  int available(void);
+  int read(void);
+  void flush(void);
+  void queueInput(const char *str);
+  void setOutput(FILE *f);	//output goes to f, stdout if NULL
+
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buf, size_t n);
+
+  void print(const char *str);
+  void print(char c);
+  void print(unsigned char n, int base=DEC);
+  void print(int n, int base=DEC);
+  void print(unsigned int n, int base=DEC);
+  void print(long n, int base=DEC);
+  void print(unsigned long n, int base=DEC);
+  void print(double n, int digits=2);
+
+  void println(void);
+  template<class T> void println(T val) { print(val); println(); }
+  template<class T> void println(T val, int fmt) { print(val,fmt); println(); }
+
+private:
+  const char *input;
+  FILE *out;
+  long baud;
+
+  FILE *stream(void) { return out ? out : stdout; }
+  size_t sent(long n);	//n bytes sent, in board cycles
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -1,12 +1,11 @@
 /*********************************************************************/
 /*********************************************************************/
-//	pin_defs_168_328.h
-//	ArduEye Library for the ATMega 168/328
+//	EEPROM.h (host)
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
 //	
-//	Defines pin interface between ATMega 168/328 and 
-//	Stonyman/Hawksbill vision chips
-//
-//	Working revision started July 9, 2012
+//	EEPROM for host builds, kept in memory (4KB as the ATmega2560).
+//	Erased cells read as 0xFF.  smhHostEEPROMFile keeps it in a file
+//	instead, so stored profiles survive between runs.
 //
 /*********************************************************************/
 /*********************************************************************/
@@ -43,45 +42,26 @@ policies, either expressed or implied, of Centeye, Inc.
 ===============================================================================
 */
 
-#ifndef _PIN_DEFS_168_328_H_INCLUDED
-#define _PIN_DEFS_168_328_H_INCLUDED
-
-//RESP pin
-#define SMH_RESP_PORT PORTB
-#define SMH_RESP_DDR DDRB
-#define SMH_RESP_PIN 0x01
+#ifndef _ARDUEYE_HOST_EEPROM_H_INCLUDED
+#define _ARDUEYE_HOST_EEPROM_H_INCLUDED
 
-//INCP pin
-#define SMH_INCP_PORT PORTD
-#define SMH_INCP_DDR DDRD
-#define SMH_INCP_PIN 0x80
-	
-//RESV pin
-#define SMH_RESV_PORT PORTD
-#define SMH_RESV_DDR DDRD
-#define SMH_RESV_PIN 0x40
+#include "Arduino.h"
 
-//INCV pin
-#define SMH_INCV_PORT PORTD
-#define SMH_INCV_DDR DDRD
-#define SMH_INCV_PIN 0x20
+#define SMH_HOST_EEPROM_SIZE 4096
+#define E2END (SMH_HOST_EEPROM_SIZE-1)	//last address, as avr/io.h
 
-//INPHI pin
-#define SMH_INPHI_PORT PORTD
-#define SMH_INPHI_DDR DDRD
-#define SMH_INPHI_PIN 0x10
+class HostEEPROM
+{
+public:
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  int length(void) { return SMH_HOST_EEPROM_SIZE; }
+};
 
-//ANALOG OUT pins (4 supported)
-#define SMH_ANALOG_PORT PORTC
-#define SMH_ANALOG_DDR	DDRC
-#define SMH_ANALOG0 0x01
-#define SMH_ANALOG1 0x02
-#define SMH_ANALOG2 0x04
-#define SMH_ANALOG3 0x08
+extern HostEEPROM EEPROM;
 
-//EXTERNAL ADC SS pin
-#define SMH_ADC_SS_PORT PORTB
-#define SMH_ADC_SS_DDR	 DDRB
-#define SMH_ADC_SS_PIN  0x04
+//loads the EEPROM from a file (created if missing) and writes every
+//change through to it; returns 0 if the file cannot be opened
+char smhHostEEPROMFile(const char *path);
 
 #endif
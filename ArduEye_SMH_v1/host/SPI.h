@@ -1,13 +1,10 @@
 /*********************************************************************/
 /*********************************************************************/
-//	pin_defs_2560.h
-//	ArduEye Library for the ATMega 2560
+//	SPI.h (host)
+//	ArduEye Library for the Stonyman/Hawksbill Centeye Vision Chips
 //	
-//	Defines pin interface between ATMega 2560 and 
-//	Stonyman/Hawksbill vision chips
-//	NOTE: ATMega 2560 SPI for external ADC is not supported.
-//
-//	Working revision started July 9, 2012
+//	SPI for host builds: every transfer calls a hook (e.g. an 
+//	external ADC emulator), 0 is returned if none is set.
 //
 /*********************************************************************/
 /*********************************************************************/
@@ -44,51 +41,31 @@ policies, either expressed or implied, of Centeye, Inc.
 ===============================================================================
 */
 
-#ifndef _PIN_DEFS_2560_H_INCLUDED
-#define _PIN_DEFS_2560_H_INCLUDED
-
-//RESP pin
-#define SMH_RESP_PORT PORTH
-#define SMH_RESP_DDR DDRH
-#define SMH_RESP_PIN 0x20
-
-//INCP pin
-#define SMH_INCP_PORT PORTH
-#define SMH_INCP_DDR DDRH
-#define SMH_INCP_PIN 0x10
+#ifndef _ARDUEYE_HOST_SPI_H_INCLUDED
+#define _ARDUEYE_HOST_SPI_H_INCLUDED
 
-//RESV pin	
-#define SMH_RESV_PORT PORTH
-#define SMH_RESV_DDR DDRH
-#define SMH_RESV_PIN 0x08
+#include "Arduino.h"
 
-//INCV pin
-#define SMH_INCV_PORT PORTE
-#define SMH_INCV_DDR DDRE
-#define SMH_INCV_PIN 0x08
+#define SPI_CLOCK_DIV4 0x00
+#define SPI_CLOCK_DIV16 0x01
+#define SPI_CLOCK_DIV64 0x02
+#define SPI_CLOCK_DIV128 0x03
+#define SPI_CLOCK_DIV2 0x04
+#define SPI_CLOCK_DIV8 0x05
+#define SPI_CLOCK_DIV32 0x06
 
-//INPHI pin
-#define SMH_INPHI_PORT PORTG
-#define SMH_INPHI_DDR DDRG
-#define SMH_INPHI_PIN 0x20
+typedef unsigned char (*SMHHostSPIHook)(unsigned char out);
+void smhHostSetSPIHook(SMHHostSPIHook hook);
 
-//ANALOG OUT pins (4 supported)
-#define SMH_ANALOG_PORT PORTF
-#define SMH_ANALOG_DDR	DDRF
-#define SMH_ANALOG0 0x01
-#define SMH_ANALOG1 0x02
-#define SMH_ANALOG2 0x04
-#define SMH_ANALOG3 0x08
+class HostSPI
+{
+public:
+  void begin(void) {}
+  void end(void) {}
+  void setClockDivider(uint8_t div) {}
+  uint8_t transfer(uint8_t data);
+};
 
-//EXTERNAL ADC SS pin
-//This needs to be defined to 
-//function with the library,
-//but the MOSI and CLK pins
-//are in the wrong place and
-//this external ADC function can't
-//be used.
-#define SMH_ADC_SS_PORT PORTB
-#define SMH_ADC_SS_DDR	 DDRB
-#define SMH_ADC_SS_PIN  0x10
+extern HostSPI SPI;
 
 #endif
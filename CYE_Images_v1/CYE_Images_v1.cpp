@@ -122,6 +122,315 @@ void CYE_ImgShortCopy(char *A, char *B, unsigned short numpix) {
 
 
 
+//========================================================================
+// FRAME OBJECTS
+//========================================================================
+
+/*------------------------------------------------------------------------
+CYE_FrameInit -- Sets up a frame around an existing pixel buffer. The
+buffer must hold rows*cols pixels of the given format, for packed 
+formats CYE_PACK10_BYTES(rows,cols) or CYE_PACK12_BYTES(rows,cols).
+VARIABLES:
+F: frame to set up
+pixels: pixel buffer (short, char or unsigned char array)
+rows,cols: image dimensions
+format: CYE_FRAME_SHORT, CYE_FRAME_CHAR, CYE_FRAME_UCHAR, 
+CYE_FRAME_PACK10 or CYE_FRAME_PACK12
+STATUS: UNTESTED
+*/
+void CYE_FrameInit(CYE_Frame *F, void *pixels, unsigned char rows, unsigned char cols, unsigned char format) {
+	F->pixels = pixels;
+	F->rows = rows;
+	F->cols = cols;
+	F->format = format;
+	F->shift = 0;
+	F->timestamp = 0;
+	F->seq = 0;
+}
+
+/*------------------------------------------------------------------------
+CYE_FrameNumPix -- Returns the number of pixels of a frame
+VARIABLES:
+F: frame
+STATUS: UNTESTED
+*/
+unsigned short CYE_FrameNumPix(CYE_Frame *F) {
+	return (unsigned short)F->rows * F->cols;
+}
+
+/*------------------------------------------------------------------------
+CYE_FrameMatch -- Returns 1 if two frames have the same dimensions and
+pixel format, so they can be compared or differenced, 0 otherwise
+VARIABLES:
+A,B: frames
+STATUS: UNTESTED
+*/
+char CYE_FrameMatch(CYE_Frame *A, CYE_Frame *B) {
+	return (A->rows==B->rows) && (A->cols==B->cols) && (A->format==B->format);
+}
+
+/*------------------------------------------------------------------------
+CYE_FrameRingInit -- Sets up a ring of 2 or 3 frames. Slot 0 is the 
+current frame, slot 1 the previous one and so on. 
+VARIABLES:
+R: ring to set up
+frames: array of numslots frames, already set up with CYE_FrameInit
+numslots: number of frames, at most CYE_FRAMERING_MAX
+STATUS: UNTESTED
+*/
+void CYE_FrameRingInit(CYE_FrameRing *R, CYE_Frame *frames, unsigned char numslots) {
+	unsigned char i;
+	if (numslots>CYE_FRAMERING_MAX)
+		numslots = CYE_FRAMERING_MAX;
+	for (i=0; i<numslots; ++i)
+		R->slot[i] = &frames[i];
+	R->numslots = numslots;
+}
+
+/*------------------------------------------------------------------------
+CYE_FrameRingGet -- Returns a frame of the ring by age: 0 is the current
+frame, 1 the previous frame, etc.
+VARIABLES:
+R: ring
+age: 0...numslots-1, larger values return the oldest frame
+STATUS: UNTESTED
+*/
+CYE_Frame *CYE_FrameRingGet(CYE_FrameRing *R, unsigned char age) {
+	if (age>=R->numslots)
+		age = R->numslots-1;
+	return R->slot[age];
+}
+
+/*------------------------------------------------------------------------
+CYE_FrameRingRotate -- Ages all frames by one. The oldest frame becomes
+the current frame, ready to be overwritten by the next acquisition, and
+the current frame becomes the previous one. Only pointers are swapped,
+no pixels are copied. Replaces CYE_ImgShortCopy(current,last,numpix)
+at the end of each frame.
+VARIABLES:
+R: ring
+STATUS: UNTESTED
+*/
+void CYE_FrameRingRotate(CYE_FrameRing *R) {
+	unsigned char i;
+	CYE_Frame *oldest = R->slot[R->numslots-1];
+	for (i=R->numslots-1; i>0; --i)
+		R->slot[i] = R->slot[i-1];
+	R->slot[0] = oldest;
+}
+
+/*------------------------------------------------------------------------
+CYE_FrameRowBytes -- Returns the number of bytes of one row of a frame
+VARIABLES:
+F: frame
+STATUS: UNTESTED
+*/
+unsigned short CYE_FrameRowBytes(CYE_Frame *F) {
+	switch (F->format) {
+		case CYE_FRAME_CHAR:
+		case CYE_FRAME_UCHAR:
+			return F->cols;
+		case CYE_FRAME_PACK10:
+			return CYE_PACK10_ROWBYTES(F->cols);
+		case CYE_FRAME_PACK12:
+			return CYE_PACK12_ROWBYTES(F->cols);
+		default:
+			return F->cols*sizeof(short);
+	}
+}
+
+/*------------------------------------------------------------------------
+CYE_FrameRow -- Returns a pointer to the first byte of a row of a frame
+VARIABLES:
+F: frame
+row: 0...rows-1
+STATUS: UNTESTED
+*/
+void *CYE_FrameRow(CYE_Frame *F, unsigned char row) {
+	return (unsigned char *)F->pixels + (unsigned short)row*CYE_FrameRowBytes(F);
+}
+
+/*------------------------------------------------------------------------
+CYE_FrameGetRow -- Copies one row of a frame of any format into an 
+array of shorts, unpacking packed frames. Lets a routine written for 
+short rows consume any frame one row at a time.
+VARIABLES:
+F: frame
+row: 0...rows-1
+dst: output, cols shorts
+STATUS: UNTESTED
+*/
+void CYE_FrameGetRow(CYE_Frame *F, unsigned char row, short *dst) {
+	CYE_FrameGetRowPart(F,row,0,F->cols,dst);
+}
+
+/*------------------------------------------------------------------------
+CYE_FrameGetRowPart -- As CYE_FrameGetRow for n pixels of a row from 
+column col on, so a routine with a buffer of CYE_PACK_MAXCOLS shorts 
+can consume a row of any width in pieces.
+VARIABLES:
+F: frame
+row: 0...rows-1
+col: first column, a multiple of 4 (CYE_PACK_GROUP)
+n: number of pixels, col+n at most cols
+dst: output, n shorts
+STATUS: UNTESTED
+*/
+void CYE_FrameGetRowPart(CYE_Frame *F, unsigned char row, unsigned char col, unsigned char n, short *dst) {
+	unsigned char *p = (unsigned char *)CYE_FrameRow(F,row);
+	unsigned char i;
+
+	switch (F->format) {
+		case CYE_FRAME_CHAR:
+			for (i=0; i<n; ++i)
+				dst[i] = ((char *)p)[col+i];
+			break;
+		case CYE_FRAME_UCHAR:
+			for (i=0; i<n; ++i)
+				dst[i] = p[col+i];
+			break;
+		case CYE_FRAME_PACK10:
+			CYE_Unpack10(p+(col/4)*5,dst,n);
+			break;
+		case CYE_FRAME_PACK12:
+			CYE_Unpack12(p+(col/2)*3,dst,n);
+			break;
+		default:
+			for (i=0; i<n; ++i)
+				dst[i] = ((short *)p)[col+i];
+			break;
+	}
+}
+
+/*------------------------------------------------------------------------
+CYE_FramePutRow -- Stores an array of shorts as one row of a frame, the
+inverse of CYE_FrameGetRow. Values are clamped to the pixel range of 
+8 bit and packed frames.
+VARIABLES:
+F: frame
+row: 0...rows-1
+src: cols shorts
+STATUS: UNTESTED
+*/
+void CYE_FramePutRow(CYE_Frame *F, unsigned char row, short *src) {
+	CYE_FramePutRowPart(F,row,0,F->cols,src);
+}
+
+/*------------------------------------------------------------------------
+CYE_FramePutRowPart -- Stores n shorts as part of a row from column col
+on, the inverse of CYE_FrameGetRowPart. A packed part is padded to a 
+whole group, so n must be a multiple of 4 unless the part ends the row.
+VARIABLES:
+F: frame
+row: 0...rows-1
+col: first column, a multiple of 4 (CYE_PACK_GROUP)
+n: number of pixels, col+n at most cols
+src: n shorts
+STATUS: UNTESTED
+*/
+void CYE_FramePutRowPart(CYE_Frame *F, unsigned char row, unsigned char col, unsigned char n, short *src) {
+	unsigned char *p = (unsigned char *)CYE_FrameRow(F,row);
+	unsigned char i;
+
+	switch (F->format) {
+		case CYE_FRAME_CHAR:
+			for (i=0; i<n; ++i)
+				((char *)p)[col+i] = constrain(src[i],-128,127);
+			break;
+		case CYE_FRAME_UCHAR:
+			for (i=0; i<n; ++i)
+				p[col+i] = constrain(src[i],0,255);
+			break;
+		case CYE_FRAME_PACK10:
+			CYE_Pack10(src,p+(col/4)*5,n);
+			break;
+		case CYE_FRAME_PACK12:
+			CYE_Pack12(src,p+(col/2)*3,n);
+			break;
+		default:
+			for (i=0; i<n; ++i)
+				((short *)p)[col+i] = src[i];
+			break;
+	}
+}
+
+/*------------------------------------------------------------------------
+CYE_Pack10, CYE_Unpack10 -- Pack n shorts into the 10 bit row format 
+(4 pixels in 5 bytes) and back. Values are clamped to 0...1023. A last
+partial group is padded with zero pixels.
+VARIABLES:
+src: input row
+dst: output row, CYE_PACK10_ROWBYTES(n) bytes when packing
+n: number of pixels
+STATUS: UNTESTED
+*/
+void CYE_Pack10(short *src, unsigned char *dst, unsigned char n) {
+	short g[4];
+	unsigned short i;	// n+3 does not fit a byte
+	unsigned char k;
+
+	for (i=0; i<n; i+=4, dst+=5) {
+		for (k=0; k<4; ++k)
+			g[k] = (i+k<n) ? constrain(src[i+k],0,1023) : 0;
+		dst[0] = g[0]>>2;
+		dst[1] = g[1]>>2;
+		dst[2] = g[2]>>2;
+		dst[3] = g[3]>>2;
+		dst[4] = (g[0]&3) | ((g[1]&3)<<2) | ((g[2]&3)<<4) | ((g[3]&3)<<6);
+	}
+}
+
+void CYE_Unpack10(unsigned char *src, short *dst, unsigned char n) {
+	unsigned char lo,k;
+
+	// whole groups
+	for (; n>=4; n-=4, src+=5, dst+=4) {
+		lo = src[4];
+		dst[0] = (src[0]<<2) | (lo&3);
+		dst[1] = (src[1]<<2) | ((lo>>2)&3);
+		dst[2] = (src[2]<<2) | ((lo>>4)&3);
+		dst[3] = (src[3]<<2) | (lo>>6);
+	}
+	// last partial group
+	if (n) {
+		lo = src[4];
+		for (k=0; k<n; ++k, lo>>=2)
+			dst[k] = (src[k]<<2) | (lo&3);
+	}
+}
+
+/*------------------------------------------------------------------------
+CYE_Pack12, CYE_Unpack12 -- Pack n shorts into the 12 bit row format 
+(2 pixels in 3 bytes) and back. Values are clamped to 0...4095.
+VARIABLES:
+src: input row
+dst: output row, CYE_PACK12_ROWBYTES(n) bytes when packing
+n: number of pixels
+STATUS: UNTESTED
+*/
+void CYE_Pack12(short *src, unsigned char *dst, unsigned char n) {
+	short a,b;
+	unsigned short i;	// n+1 does not fit a byte
+
+	for (i=0; i<n; i+=2, dst+=3) {
+		a = constrain(src[i],0,4095);
+		b = (i+1<n) ? constrain(src[i+1],0,4095) : 0;
+		dst[0] = a>>4;
+		dst[1] = b>>4;
+		dst[2] = (a&15) | ((b&15)<<4);
+	}
+}
+
+void CYE_Unpack12(unsigned char *src, short *dst, unsigned char n) {
+	for (; n>=2; n-=2, src+=3, dst+=2) {
+		dst[0] = (src[0]<<4) | (src[2]&15);
+		dst[1] = (src[1]<<4) | (src[2]>>4);
+	}
+	if (n)
+		dst[0] = (src[0]<<4) | (src[2]&15);
+}
+
+
 //========================================================================
 // IMAGE DISPLAY AND DUMPING (FOR ARDUINO SERIAL MONITOR)
 //========================================================================
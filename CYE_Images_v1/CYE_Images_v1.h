@@ -45,6 +45,71 @@ February 17, 2012: includes Arduino.h or WProgram.h depending on Arduino IDE ver
   #endif
 
 
+// Frame objects: an image buffer with its dimensions, pixel format 
+// and acquisition time, so frames can be passed around as one 
+// argument, and a ring of frames that rotates by swapping pointers.
+#define CYE_FRAME_SHORT 0	// short pixels
+#define CYE_FRAME_CHAR 1	// signed char pixels
+#define CYE_FRAME_UCHAR 2	// unsigned char pixels
+#define CYE_FRAME_PACK10 3	// 10 bit pixels, 4 in 5 bytes
+#define CYE_FRAME_PACK12 4	// 12 bit pixels, 2 in 3 bytes
+
+// Packed frames: each row starts on a byte boundary and is packed in
+// groups, 10 bits as the high 8 bits of 4 pixels then one byte of 
+// their low 2 bits (pixel 0 in bits 0-1), 12 bits as the high 8 bits
+// of 2 pixels then one byte of their low 4 bits.  A short row is 
+// padded to a whole group.  Bytes of a packed buffer:
+#define CYE_PACK10_ROWBYTES(cols) ((((cols)+3)/4)*5)
+#define CYE_PACK12_ROWBYTES(cols) ((((cols)+1)/2)*3)
+#define CYE_PACK10_BYTES(rows,cols) ((rows)*CYE_PACK10_ROWBYTES(cols))
+#define CYE_PACK12_BYTES(rows,cols) ((rows)*CYE_PACK12_ROWBYTES(cols))
+
+// row pieces: parts of a row start on a group boundary, and the 
+// row-wise consumers (SMH, OFO, GUI) unpack rows in pieces of at most
+// CYE_PACK_MAXCOLS pixels, keeping a few of them on the stack.  Frames
+// of any width are read, a narrower frame in one piece per row.
+#define CYE_PACK_GROUP 4
+#ifndef CYE_PACK_MAXCOLS
+#define CYE_PACK_MAXCOLS 40
+#endif
+#if (CYE_PACK_MAXCOLS%CYE_PACK_GROUP) || (CYE_PACK_MAXCOLS<2*CYE_PACK_GROUP)
+#error CYE_PACK_MAXCOLS must be a multiple of CYE_PACK_GROUP, at least 8
+#endif
+
+struct CYE_Frame {
+	void *pixels;			// pixel buffer, row-wise
+	unsigned char rows,cols;
+	unsigned char format;		// CYE_FRAME_SHORT/CHAR/UCHAR/PACK10/PACK12
+	unsigned char shift;		// right shift of 8 bit and packed pixels
+	unsigned long timestamp;	// micros() when acquired
+	unsigned short seq;		// acquisition sequence number
+};
+
+#define CYE_FRAMERING_MAX 3
+
+struct CYE_FrameRing {
+	CYE_Frame *slot[CYE_FRAMERING_MAX];	// slot[0] is the newest
+	unsigned char numslots;
+};
+
+void CYE_FrameInit(CYE_Frame *F, void *pixels, unsigned char rows, unsigned char cols, unsigned char format);
+unsigned short CYE_FrameNumPix(CYE_Frame *F);
+char CYE_FrameMatch(CYE_Frame *A, CYE_Frame *B);
+void CYE_FrameRingInit(CYE_FrameRing *R, CYE_Frame *frames, unsigned char numslots);
+CYE_Frame *CYE_FrameRingGet(CYE_FrameRing *R, unsigned char age);
+void CYE_FrameRingRotate(CYE_FrameRing *R);
+unsigned short CYE_FrameRowBytes(CYE_Frame *F);
+void *CYE_FrameRow(CYE_Frame *F, unsigned char row);
+void CYE_FrameGetRow(CYE_Frame *F, unsigned char row, short *dst);
+void CYE_FramePutRow(CYE_Frame *F, unsigned char row, short *src);
+void CYE_FrameGetRowPart(CYE_Frame *F, unsigned char row, unsigned char col, unsigned char n, short *dst);
+void CYE_FramePutRowPart(CYE_Frame *F, unsigned char row, unsigned char col, unsigned char n, short *src);
+
+void CYE_Pack10(short *src, unsigned char *dst, unsigned char n);
+void CYE_Unpack10(unsigned char *src, short *dst, unsigned char n);
+void CYE_Pack12(short *src, unsigned char *dst, unsigned char n);
+void CYE_Unpack12(unsigned char *src, short *dst, unsigned char n);
+
 void CYE_ImgShortCopy(short *A, short *B, unsigned short numpix);
 void CYE_ImgShortCopy(char *A, char *B, unsigned short numpix);
 